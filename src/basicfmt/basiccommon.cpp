@@ -6,6 +6,7 @@
 ///
 
 #include "basiccommon.h"
+#include "../diskimg/diskimage.h"
 
 
 //////////////////////////////////////////////////////////////////////
@@ -344,6 +345,115 @@ void DiskBasicGroups::SortItems()
 	items.Sort(&DiskBasicGroupItem::Compare);
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+//
+//
+DiskBasicFileMapItem::DiskBasicFileMapItem()
+{
+	sector = NULL;
+	offset = 0;
+	size = 0;
+	group_idx = 0;
+	sector_num = 0;
+	sector_end = 0;
+	no_track = false;
+}
+/// @param[in] n_sector     セクタ
+/// @param[in] n_offset     セクタバッファ内の開始位置
+/// @param[in] n_size       サイズ
+/// @param[in] n_group_idx  グループリスト内の位置
+/// @param[in] n_sector_num セクタ番号
+/// @param[in] n_sector_end グループ内の終了セクタ番号
+/// @param[in] n_no_track   トラックがない
+DiskBasicFileMapItem::DiskBasicFileMapItem(DiskImageSector *n_sector, int n_offset, int n_size, int n_group_idx, int n_sector_num, int n_sector_end, bool n_no_track)
+{
+	sector = n_sector;
+	offset = n_offset;
+	size = n_size;
+	group_idx = n_group_idx;
+	sector_num = n_sector_num;
+	sector_end = n_sector_end;
+	no_track = n_no_track;
+}
+
+WX_DEFINE_OBJARRAY(DiskBasicFileMapItems);
+
+//////////////////////////////////////////////////////////////////////
+//
+//
+//
+DiskBasicFileMap::DiskBasicFileMap()
+{
+	disk = NULL;
+	layout_gen = 0;
+}
+
+/// グループリストからセクタ位置の一覧を作成
+/// トラックがない時はその位置で打ち切る
+/// @param[in] n_disk   ディスク
+/// @param[in] n_groups グループリスト
+void DiskBasicFileMap::Make(DiskImageDisk *n_disk, const DiskBasicGroups &n_groups)
+{
+	Empty();
+
+	disk = n_disk;
+	layout_gen = disk->GetLayoutGeneration();
+	groups = n_groups.GetItems();
+
+	for(size_t gidx = 0; gidx < groups.Count(); gidx++) {
+		const DiskBasicGroupItem *gitem = &groups.Item(gidx);
+		DiskImageTrack *track = disk->GetTrack(gitem->track, gitem->side);
+		if (!track) {
+			// トラックがない
+			items.Add(DiskBasicFileMapItem(NULL, 0, 0, (int)gidx, gitem->sector_start, gitem->sector_end, true));
+			break;
+		}
+		for(int sector_num = gitem->sector_start; sector_num <= gitem->sector_end; sector_num++) {
+			DiskImageSector *sector = track->GetSector(sector_num);
+			int bufsize = 0;
+			if (sector) {
+				bufsize = sector->GetSectorSize();
+				bufsize /= gitem->div_nums;
+			}
+			items.Add(DiskBasicFileMapItem(sector, bufsize * gitem->div_num, bufsize, (int)gidx, sector_num, gitem->sector_end));
+		}
+	}
+}
+
+/// 指定したグループリストから作成した一覧か
+/// 作成後にトラックやセクタの削除、サイズ変更があれば保持したセクタは使えない
+/// @param[in] n_disk   ディスク
+/// @param[in] n_groups グループリスト
+bool DiskBasicFileMap::IsMadeFrom(const DiskImageDisk *n_disk, const DiskBasicGroups &n_groups) const
+{
+	if (!disk || disk != n_disk) return false;
+	if (layout_gen != disk->GetLayoutGeneration()) return false;
+	if (groups.Count() != n_groups.Count()) return false;
+
+	for(size_t gidx = 0; gidx < groups.Count(); gidx++) {
+		const DiskBasicGroupItem *s = &groups.Item(gidx);
+		const DiskBasicGroupItem *d = n_groups.ItemPtr(gidx);
+		if (s->track != d->track
+		 || s->side != d->side
+		 || s->sector_start != d->sector_start
+		 || s->sector_end != d->sector_end
+		 || s->div_num != d->div_num
+		 || s->div_nums != d->div_nums) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// リストをクリア
+void DiskBasicFileMap::Empty()
+{
+	disk = NULL;
+	groups.Empty();
+	items.Empty();
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 //
@@ -14,6 +14,9 @@
 #include <wx/dynarray.h>
 
 
+class DiskImageDisk;
+class DiskImageSector;
+
 //////////////////////////////////////////////////////////////////////
 
 #define FILENAME_BUFSIZE	(32)
@@ -975,6 +978,62 @@ public:
 
 //////////////////////////////////////////////////////////////////////
 
+/// @brief ファイルのセクタ位置 DiskBasicFileMap のアイテム
+class DiskBasicFileMapItem
+{
+public:
+	DiskImageSector *sector;	///< セクタ NULLのときはトラックかセクタがない
+	int offset;				///< セクタバッファ内の開始位置
+	int size;				///< サイズ
+	int group_idx;			///< グループリスト内の位置
+	int sector_num;			///< セクタ番号
+	int sector_end;			///< グループ内の終了セクタ番号
+	bool no_track;			///< トラックがない
+public:
+	DiskBasicFileMapItem();
+	DiskBasicFileMapItem(DiskImageSector *n_sector, int n_offset, int n_size, int n_group_idx, int n_sector_num, int n_sector_end, bool n_no_track = false);
+	~DiskBasicFileMapItem() {}
+};
+
+/// @class DiskBasicFileMapItems
+///
+/// @brief DiskBasicFileMapItem のリスト
+WX_DECLARE_OBJARRAY(DiskBasicFileMapItem, DiskBasicFileMapItems);
+
+//////////////////////////////////////////////////////////////////////
+
+/// @brief ファイルのセクタ位置の一覧
+///
+/// グループリストの各セクタをトラック、セクタから探してバッファ位置を求めておく。
+/// 同じファイルへ繰り返しアクセスする時に再計算しないようにする。
+///
+/// @sa DiskBasicGroups , DiskBasic::AccessUnitData()
+class DiskBasicFileMap
+{
+private:
+	DiskImageDisk		 *disk;		///< 作成元のディスク
+	wxUint32			  layout_gen;	///< 作成時のディスクのトラックやセクタの並びの世代
+	DiskBasicGroupItems	  groups;	///< 作成元のグループリスト
+	DiskBasicFileMapItems items;	///< セクタ位置のリスト
+
+public:
+	DiskBasicFileMap();
+	~DiskBasicFileMap() {}
+
+	/// @brief グループリストからセクタ位置の一覧を作成
+	void	Make(DiskImageDisk *n_disk, const DiskBasicGroups &n_groups);
+	/// @brief 指定したグループリストから作成した一覧か
+	bool	IsMadeFrom(const DiskImageDisk *n_disk, const DiskBasicGroups &n_groups) const;
+	/// @brief リストをクリア
+	void	Empty();
+	/// @brief リストの数を返す
+	size_t	Count() const { return items.Count(); }
+	/// @brief リストアイテムを返す
+	const DiskBasicFileMapItem &Item(size_t idx) const { return items.Item(idx); }
+};
+
+//////////////////////////////////////////////////////////////////////
+
 /// @brief 汎用リスト用アイテム
 ///
 /// @sa KeyValArray
@@ -567,26 +567,41 @@ DiskBasicDirItem *DiskBasicDir::FindFileOnCurrent(const DiskBasicFileName &filen
 /// @return NULL: ない
 DiskBasicDirItem *DiskBasicDir::FindFile(const DiskBasicDirItem *dir_item, const DiskBasicFileName &filename, bool icase, DiskBasicDirItem *exclude_item, DiskBasicDirItem **next_item)
 {
-	DiskBasicDirItem *match_item = NULL;
 	const DiskBasicDirItems *items = dir_item->GetChildren();
-	if (items) {
-		for(size_t pos = 0; pos <items->Count(); pos++) {
-			DiskBasicDirItem *item = items->Item(pos);
-			if (item != exclude_item && item->IsSameFileName(filename, icase)) {
-				match_item = item;
-				if (next_item) {
-					pos++;
-					if (pos < items->Count()) {
-						*next_item = items->Item(pos);
-					} else {
-						*next_item = NULL;
-					}
-				}
-				break;
+	if (!items || items->Count() == 0) return NULL;
+
+	// 索引があれば候補を絞る
+	// 拡張子の長さが異なるアイテムごとにキーを作り、それぞれの候補を集める
+	const DiskBasicDirItems *cands = items;
+	DiskBasicDirItems found;
+	DiskBasicDirNameIndex *index = dir_item->GetNameIndex();
+	if (index) {
+		index->Prepare(items, icase);
+		const DiskBasicDirItems &key_items = index->GetKeyItems();
+		bool converted = (key_items.Count() > 0);
+		for(size_t i=0; i<key_items.Count() && converted; i++) {
+			wxString key;
+			converted = key_items.Item(i)->ToFileNameKey(filename, icase, key);
+			const DiskBasicDirItems *files = (converted ? index->FindFiles(key) : NULL);
+			for(size_t n=0; files && n<files->Count(); n++) {
+				found.Add(files->Item(n));
 			}
 		}
+		// 変換できない時は全て比べる
+		if (converted) {
+			cands = &found;
+		}
 	}
-	return match_item;
+
+	DiskBasicDirItems matches;
+	for(size_t pos = 0; pos < cands->Count(); pos++) {
+		DiskBasicDirItem *item = cands->Item(pos);
+		if (item != exclude_item && item->IsSameFileName(filename, icase)) {
+			matches.Add(item);
+			if (cands == items) break;
+		}
+	}
+	return SelectMatchedItem(items, matches, next_item);
 }
 
 /// 現在のディレクトリ内に同じファイル名が既に存在するか
@@ -609,26 +624,29 @@ DiskBasicDirItem *DiskBasicDir::FindFileOnCurrent(const DiskBasicDirItem *target
 /// @return NULL: ない
 DiskBasicDirItem *DiskBasicDir::FindFile(const DiskBasicDirItem *dir_item, const DiskBasicDirItem *target_item, bool icase, DiskBasicDirItem *exclude_item, DiskBasicDirItem **next_item)
 {
-	DiskBasicDirItem *match_item = NULL;
 	const DiskBasicDirItems *items = dir_item->GetChildren();
-	if (items) {
-		for(size_t pos = 0; pos <items->Count(); pos++) {
-			DiskBasicDirItem *item = items->Item(pos);
-			if (item != exclude_item && item->IsSameFileName(target_item, icase)) {
-				match_item = item;
-				if (next_item) {
-					pos++;
-					if (pos < items->Count()) {
-						*next_item = items->Item(pos);
-					} else {
-						*next_item = NULL;
-					}
-				}
-				break;
-			}
+	if (!items || items->Count() == 0) return NULL;
+
+	// 索引があれば候補を絞る
+	const DiskBasicDirItems *cands = items;
+	DiskBasicDirNameIndex *index = dir_item->GetNameIndex();
+	if (index) {
+		wxString key;
+		target_item->GetFileNameKey(icase, key);
+		index->Prepare(items, icase);
+		cands = index->FindFiles(key);
+		if (!cands) return NULL;
+	}
+
+	DiskBasicDirItems matches;
+	for(size_t pos = 0; pos < cands->Count(); pos++) {
+		DiskBasicDirItem *item = cands->Item(pos);
+		if (item != exclude_item && item->IsSameFileName(target_item, icase)) {
+			matches.Add(item);
+			if (cands == items) break;
 		}
 	}
-	return match_item;
+	return SelectMatchedItem(items, matches, next_item);
 }
 
 /// 現在のディレクトリ内に同じファイル名(拡張子除く)が既に存在するか
@@ -651,26 +669,63 @@ DiskBasicDirItem *DiskBasicDir::FindNameOnCurrent(const wxString &name, bool ica
 /// @return NULL: ない
 DiskBasicDirItem *DiskBasicDir::FindName(const DiskBasicDirItem *dir_item, const wxString &name, bool icase, DiskBasicDirItem *exclude_item, DiskBasicDirItem **next_item)
 {
-	DiskBasicDirItem *match_item = NULL;
 	const DiskBasicDirItems *items = dir_item->GetChildren();
-	if (items) {
-		for(size_t pos = 0; pos <items->Count(); pos++) {
-			DiskBasicDirItem *item = items->Item(pos);
-			if (item != exclude_item && item->IsSameName(name, icase)) {
-				match_item = item;
-				if (next_item) {
-					pos++;
-					if (pos < items->Count()) {
-						*next_item = items->Item(pos);
-					} else {
-						*next_item = NULL;
-					}
-				}
-				break;
-			}
+	if (!items || items->Count() == 0) return NULL;
+
+	// 索引があれば候補を絞る
+	const DiskBasicDirItems *cands = items;
+	DiskBasicDirNameIndex *index = dir_item->GetNameIndex();
+	if (index) {
+		// 拡張子を含まないのでキーの作り方はアイテムによらない
+		index->Prepare(items, icase);
+		const DiskBasicDirItems &key_items = index->GetKeyItems();
+		wxString key;
+		if (key_items.Count() > 0 && key_items.Item(0)->ToNameKey(name, icase, key)) {
+			cands = index->FindNames(key);
+			if (!cands) return NULL;
 		}
 	}
-	return match_item;
+
+	DiskBasicDirItems matches;
+	for(size_t pos = 0; pos < cands->Count(); pos++) {
+		DiskBasicDirItem *item = cands->Item(pos);
+		if (item != exclude_item && item->IsSameName(name, icase)) {
+			matches.Add(item);
+			if (cands == items) break;
+		}
+	}
+	return SelectMatchedItem(items, matches, next_item);
+}
+
+/// 一致したアイテムのうちディレクトリ内で最初のものを返す
+/// @param [in]  items     ディレクトリ内のアイテム一覧
+/// @param [in]  matches   一致したアイテム
+/// @param [out] next_item 選んだアイテムの次位置にあるアイテム
+/// @return NULL: ない
+DiskBasicDirItem *DiskBasicDir::SelectMatchedItem(const DiskBasicDirItems *items, const DiskBasicDirItems &matches, DiskBasicDirItem **next_item)
+{
+	if (matches.Count() == 0) return NULL;
+	if (matches.Count() == 1 && !next_item) return matches.Item(0);
+
+	// 索引の候補は並び順が保証されないので位置で比べる
+	int match_pos = -1;
+	for(size_t i = 0; i < matches.Count(); i++) {
+		int pos = items->Index(matches.Item(i));
+		if (pos != wxNOT_FOUND && (match_pos < 0 || pos < match_pos)) {
+			match_pos = pos;
+		}
+	}
+	if (match_pos < 0) return NULL;
+
+	if (next_item) {
+		size_t pos = (size_t)match_pos + 1;
+		if (pos < items->Count()) {
+			*next_item = items->Item(pos);
+		} else {
+			*next_item = NULL;
+		}
+	}
+	return items->Item(match_pos);
 }
 
 /// 現在のディレクトリ内の属性に一致するファイルを検索
@@ -42,6 +42,9 @@ private:
 //	DiskBasicGroups		root_groups;	///< ルートディレクトリのあるセクタリスト
 
 	DiskBasicDir();
+
+	/// @brief 一致したアイテムのうちディレクトリ内で最初のものを返す
+	DiskBasicDirItem *SelectMatchedItem(const DiskBasicDirItems *items, const DiskBasicDirItems &matches, DiskBasicDirItem **next_item);
 public:
 	DiskBasicDir(DiskBasic *basic);
 	~DiskBasicDir();
@@ -141,6 +144,8 @@ public:
 
 	/// @brief フォーマット種類を設定
 	void		SetFormatType(const DiskBasicFormat *val) { format_type = val; }
+	/// @brief FATクラスを設定
+	void		SetFat(DiskBasicFat *val) { fat = val; }
 	/// @brief フォーマット種類を得る
 	const DiskBasicFormat *GetFormatType() const { return format_type; }
 
@@ -27,6 +27,7 @@ DiskBasicDirItem::DiskBasicDirItem()
 
 	m_parent = NULL;
 	m_children = NULL;
+	m_name_index = NULL;
 	m_valid_dir = false;
 
 	m_num = 0;
@@ -36,6 +37,10 @@ DiskBasicDirItem::DiskBasicDirItem()
 
 	m_external_attr = 0;
 
+	m_name_cache_nlen = 0;
+	m_name_cache_elen = 0;
+	m_name_cache_map = NULL;
+
 	m_flags = (VISIBLE_LIST | VISIBLE_TREE);
 }
 DiskBasicDirItem::DiskBasicDirItem(const DiskBasicDirItem &src)
@@ -60,6 +65,7 @@ DiskBasicDirItem::DiskBasicDirItem(DiskBasic *basic)
 
 	m_parent = NULL;
 	m_children = NULL;
+	m_name_index = NULL;
 	m_valid_dir = false;
 
 	m_num = 0;
@@ -69,6 +75,10 @@ DiskBasicDirItem::DiskBasicDirItem(DiskBasic *basic)
 
 	m_external_attr = 0;
 
+	m_name_cache_nlen = 0;
+	m_name_cache_elen = 0;
+	m_name_cache_map = NULL;
+
 	m_flags = (VISIBLE_LIST | VISIBLE_TREE);
 }
 /// ディレクトリアイテムを作成 DATAはディスクイメージをアサイン
@@ -83,6 +93,7 @@ DiskBasicDirItem::DiskBasicDirItem(DiskBasic *basic, DiskImageSector *n_sector,
 
 	m_parent = NULL;
 	m_children = NULL;
+	m_name_index = NULL;
 	m_valid_dir = false;
 
 	m_num = 0;
@@ -92,6 +103,10 @@ DiskBasicDirItem::DiskBasicDirItem(DiskBasic *basic, DiskImageSector *n_sector,
 
 	m_external_attr = 0;
 
+	m_name_cache_nlen = 0;
+	m_name_cache_elen = 0;
+	m_name_cache_map = NULL;
+
 	m_flags = (VISIBLE_LIST | VISIBLE_TREE);
 }
 /// ディレクトリアイテムを作成 DATAはディスクイメージをアサイン
@@ -110,6 +125,7 @@ DiskBasicDirItem::DiskBasicDirItem(DiskBasic *basic, int n_num, const DiskBasicG
 
 	m_parent = NULL;
 	m_children = NULL;
+	m_name_index = NULL;
 	m_valid_dir = false;
 
 	m_num = n_num;
@@ -119,6 +135,10 @@ DiskBasicDirItem::DiskBasicDirItem(DiskBasic *basic, int n_num, const DiskBasicG
 
 	m_external_attr = 0;
 
+	m_name_cache_nlen = 0;
+	m_name_cache_elen = 0;
+	m_name_cache_map = NULL;
+
 	m_flags = (VISIBLE_LIST | VISIBLE_TREE);
 }
 /// デストラクタ
@@ -132,6 +152,7 @@ DiskBasicDirItem::~DiskBasicDirItem()
 		m_children->Clear();
 		delete m_children;
 	}
+	delete m_name_index;
 }
 
 /// アイテムへのポインタを設定
@@ -165,11 +186,13 @@ void DiskBasicDirItem::Dup(const DiskBasicDirItem &src)
 	} else {
 		m_children = NULL;
 	}
+	m_name_index = NULL;	// 索引は必要な時に作り直す
 	m_valid_dir = src.m_valid_dir;
 
 	m_num = src.m_num;
 	m_position = src.m_position;
 //	m_file_size = src.m_file_size;
+	src.ResolveGroups();
 	m_groups = src.m_groups;
 	m_sector = src.m_sector;	// no duplicate
 
@@ -183,6 +206,10 @@ void DiskBasicDirItem::Dup(const DiskBasicDirItem &src)
 
 	m_external_attr = src.m_external_attr;
 
+	m_name_cache_nlen = 0;
+	m_name_cache_elen = 0;
+	m_name_cache_map = NULL;
+
 	m_flags = src.m_flags;
 }
 #endif
@@ -193,6 +220,9 @@ void DiskBasicDirItem::CreateChildren()
 	if (!m_children) {
 		m_children = new DiskBasicDirItems;
 	}
+	if (!m_name_index) {
+		m_name_index = new DiskBasicDirNameIndex;
+	}
 }
 
 /// 子ディレクトリを追加
@@ -201,6 +231,7 @@ void DiskBasicDirItem::AddChild(DiskBasicDirItem *newitem)
 {
 	CreateChildren();
 	m_children->Add(newitem);
+	m_name_index->Invalidate();
 }
 /// 子ディレクトリ一覧をクリア
 void DiskBasicDirItem::EmptyChildren()
@@ -215,9 +246,28 @@ void DiskBasicDirItem::EmptyChildren()
 		delete m_children;
 	}
 	m_children = NULL;
+	delete m_name_index;
+	m_name_index = NULL;
 	m_valid_dir = false;
 }
 
+/// 子ディレクトリのファイル名索引にアイテムを反映する
+/// @param [in] item 名前などを変更したアイテム
+void DiskBasicDirItem::UpdateNameIndex(DiskBasicDirItem *item)
+{
+	if (m_name_index && m_children) {
+		m_name_index->Update(m_children, item);
+	}
+}
+
+/// 子ディレクトリのファイル名索引を無効にする
+void DiskBasicDirItem::InvalidateNameIndex()
+{
+	if (m_name_index) {
+		m_name_index->Invalidate();
+	}
+}
+
 /// ディレクトリアイテムのチェック
 bool DiskBasicDirItem::CheckData(const wxUint8 *buf, size_t len, bool &last)
 {
@@ -245,7 +295,11 @@ void DiskBasicDirItem::Refresh()
 	Used(CheckUsed(false));
 
 	// ファイルサイズを再計算
-	CalcFileSize();
+	// 保留できる場合は必要になった時に計算する
+	DeferCalcFileSize();
+
+	// ファイル名は変換し直す
+	ClearFileNameCache();
 }
 
 /// アイテムを削除できるか
@@ -470,6 +524,15 @@ wxString DiskBasicDirItem::GetFileNameStr() const
 
 	GetNativeFileName(name, nl, ext, el);
 
+	// 内部ファイル名と文字コードが前回と同じなら変換済みの名前を返す
+	const CharCodeMap *map = basic->GetCharCodes().GetMap();
+	if (map != NULL && map == m_name_cache_map
+		&& nl == m_name_cache_nlen && el == m_name_cache_elen
+		&& memcmp(m_name_cache_raw, name, nl) == 0
+		&& memcmp(&m_name_cache_raw[FILENAME_BUFSIZE], ext, el) == 0) {
+		return m_name_cache;
+	}
+
 	wxString dst;
 
 	ConvCharsToString(name, nl, dst);
@@ -479,6 +542,15 @@ wxString DiskBasicDirItem::GetFileNameStr() const
 		ConvCharsToString(ext, el, dst);
 	}
 
+	// 変換結果を覚えておく
+	DiskBasicDirItem *self = const_cast<DiskBasicDirItem *>(this);
+	memcpy(self->m_name_cache_raw, name, nl);
+	memcpy(&self->m_name_cache_raw[FILENAME_BUFSIZE], ext, el);
+	self->m_name_cache_nlen = nl;
+	self->m_name_cache_elen = el;
+	self->m_name_cache = dst;
+	self->m_name_cache_map = map;
+
 	return dst;
 }
 
@@ -744,6 +816,118 @@ bool DiskBasicDirItem::IsSameFileName(const DiskBasicDirItem *src, bool icase) c
 		&& (src->GetOptionalName() == GetOptionalName());
 }
 
+/// ファイル名の索引キーを返す
+/// IsSameFileName() で一致するアイテム同士は同じキーになる
+/// @param [in]  icase 大文字小文字を区別しないか(case insensitive)
+/// @param [out] key   索引キー
+void DiskBasicDirItem::GetFileNameKey(bool icase, wxString &key) const
+{
+	wxUint8 name[FILENAME_BUFSIZE], ext[FILEEXT_BUFSIZE];
+	size_t nlen = sizeof(name);
+	size_t elen = sizeof(ext);
+
+	GetNativeFileName(name, nlen, ext, elen);
+	if (icase) {
+		ToUpper(name, nlen);
+		ToUpper(ext, elen);
+	}
+	MakeFileNameKey(name, nlen, ext, elen, GetOptionalName(), key);
+}
+
+/// 指定したファイル名の索引キーを返す
+/// @param [in]  filename ファイル名
+/// @param [in]  icase    大文字小文字を区別しないか(case insensitive)
+/// @param [out] key      索引キー
+/// @return false 変換できない
+bool DiskBasicDirItem::ToFileNameKey(const DiskBasicFileName &filename, bool icase, wxString &key) const
+{
+	wxUint8 name[FILENAME_BUFSIZE], ext[FILEEXT_BUFSIZE];
+	size_t nlen = sizeof(name);
+	size_t elen = sizeof(ext);
+
+	memset(name, 0, sizeof(name));
+	memset(ext, 0, sizeof(ext));
+	if (!ToNativeFileName(filename.GetName(), name, nlen, ext, elen)) return false;
+	if (icase) {
+		ToUpper(name, nlen);
+		ToUpper(ext, elen);
+	}
+	MakeFileNameKey(name, nlen, ext, elen, filename.GetOptional(), key);
+	return true;
+}
+
+/// ファイル名(拡張子除く)の索引キーを返す
+/// IsSameName() で一致するアイテム同士は同じキーになる
+/// @param [in]  icase 大文字小文字を区別しないか(case insensitive)
+/// @param [out] key   索引キー
+void DiskBasicDirItem::GetNameKey(bool icase, wxString &key) const
+{
+	wxUint8 name[FILENAME_BUFSIZE];
+	size_t nlen = sizeof(name);
+	size_t elen = 0;
+
+	GetNativeFileName(name, nlen, NULL, elen);
+	if (icase) {
+		ToUpper(name, nlen);
+	}
+	MakeFileNameKey(name, nlen, NULL, 0, 0, key);
+}
+
+/// 指定したファイル名(拡張子除く)の索引キーを返す
+/// @param [in]  name  ファイル名
+/// @param [in]  icase 大文字小文字を区別しないか(case insensitive)
+/// @param [out] key   索引キー
+/// @return false 変換できない
+bool DiskBasicDirItem::ToNameKey(const wxString &name, bool icase, wxString &key) const
+{
+	wxUint8 dname[FILENAME_BUFSIZE];
+	size_t nlen = sizeof(dname);
+	size_t elen = 0;
+
+	memset(dname, 0, sizeof(dname));
+	if (!ToNativeFileName(name, dname, nlen, NULL, elen)) return false;
+	if (icase) {
+		ToUpper(dname, nlen);
+	}
+	MakeFileNameKey(dname, nlen, NULL, 0, 0, key);
+	return true;
+}
+
+/// 指定したファイル名を索引キーに変換する時の拡張子の長さ
+/// ToFileNameKey() の結果はこの長さで変わる(ボリュームラベルは拡張子なしなど)
+/// @return 拡張子の長さ
+size_t DiskBasicDirItem::GetFileNameKeyLayout() const
+{
+	size_t elen = 0;
+	GetFileExtPos(elen);
+	return elen;
+}
+
+/// 内部ファイル名から索引キーを作成
+/// キーは終端コード(0)の手前までとする。
+/// 比較(IsSameFileName()など)は終端コード以降のバイトも見るが、一致するなら0の手前までも一致するので同じキーになる。
+/// 逆にキーが同じでも比較で一致するとは限らないので、候補は必ず比較で確かめること。
+/// @param [in]  name     ファイル名
+/// @param [in]  nlen     ファイル名長さ
+/// @param [in]  ext      拡張子
+/// @param [in]  elen     拡張子長さ
+/// @param [in]  optional 拡張属性
+/// @param [out] key      索引キー
+void DiskBasicDirItem::MakeFileNameKey(const wxUint8 *name, size_t nlen, const wxUint8 *ext, size_t elen, int optional, wxString &key)
+{
+	nlen = str_length(name, nlen, 0);
+	if (ext) elen = str_length(ext, elen, 0);
+	else elen = 0;
+
+	key = wxString::Format(wxT("%d:%d:"), optional, (int)nlen);
+	for(size_t i=0; i<nlen; i++) {
+		key += (wxChar)name[i];
+	}
+	for(size_t i=0; i<elen; i++) {
+		key += (wxChar)ext[i];
+	}
+}
+
 /// 小文字を大文字にする
 /// @param [in,out] str  文字列
 /// @param [in]     size 長さ
@@ -1225,6 +1409,7 @@ bool DiskBasicDirItem::IsDirectory() const
 /// @param [in] val サイズ
 void DiskBasicDirItem::SetFileSize(int val)
 {
+	ResolveGroups();
 	m_groups.SetSize(val);
 }
 
@@ -1232,6 +1417,7 @@ void DiskBasicDirItem::SetFileSize(int val)
 /// @return サイズ
 int DiskBasicDirItem::GetFileSize() const
 {
+	ResolveGroups();
 	return (int)m_groups.GetSize();
 }
 
@@ -1254,6 +1440,7 @@ void DiskBasicDirItem::GetAllGroups(DiskBasicGroups &group_items)
 /// @param [in] val 数
 void DiskBasicDirItem::SetGroupSize(int val)
 {
+	ResolveGroups();
 	m_groups.SetNums(val);
 }
 
@@ -1261,9 +1448,17 @@ void DiskBasicDirItem::SetGroupSize(int val)
 /// @return 数
 int DiskBasicDirItem::GetGroupSize() const
 {
+	ResolveGroups();
 	return m_groups.GetNums();
 }
 
+/// グループ数を返す(ファイル一覧画面表示用)
+/// @return 数
+int DiskBasicDirItem::GetGroupSizeForList() const
+{
+	return GetGroupSize();
+}
+
 /// 最初のグループ番号をセット
 /// @param [in] fileunit_num ファイル番号
 /// @param [in] val          番号
@@ -1347,24 +1542,28 @@ wxUint32 DiskBasicDirItem::GetParentGroup() const
 /// グループリストの数を返す
 size_t DiskBasicDirItem::GetGroupCount() const
 {
+	ResolveGroups();
 	return m_groups.Count();
 }
 
 /// グループリストを返す
 const DiskBasicGroups &DiskBasicDirItem::GetGroups() const
 {
+	ResolveGroups();
 	return m_groups;
 }
 
 /// グループリストを設定
 void DiskBasicDirItem::SetGroups(const DiskBasicGroups &vals)
 {
+	ResolveGroups();
 	m_groups = vals;
 }
 
 /// グループリストのアイテムを返す
 DiskBasicGroupItem *DiskBasicDirItem::GetGroup(size_t idx) const
 {
+	ResolveGroups();
 	return m_groups.ItemPtr(idx);
 }
 
@@ -1593,10 +1792,33 @@ wxString DiskBasicDirItem::GetFileDateTimeStr() const
 /// ファイルサイズとグループ数を計算する
 void DiskBasicDirItem::CalcFileSize()
 {
+	m_flags &= ~GROUPS_PENDING;
 	m_groups.Empty();
 	CalcFileUnitSize(0);
 }
 
+/// ファイルサイズとグループ数の計算を必要になるまで保留する
+/// @note 保留できない機種はすぐに計算する
+void DiskBasicDirItem::DeferCalcFileSize()
+{
+	if (CanDeferCalcFileSize()) {
+		m_flags |= GROUPS_PENDING;
+	} else {
+		CalcFileSize();
+	}
+}
+
+/// 保留していたファイルサイズとグループ数の計算を行う
+/// @note グループ参照時に呼ばれるためconstメソッドとしている
+void DiskBasicDirItem::ResolveGroups() const
+{
+	if (m_flags & GROUPS_PENDING) {
+		DiskBasicDirItem *self = const_cast<DiskBasicDirItem *>(this);
+		self->m_flags &= ~GROUPS_PENDING;
+		self->CalcFileSize();
+	}
+}
+
 /// ファイルの終端コードをチェックして必要なサイズを返す
 /// @param [in] istream   入力ストリーム
 /// @param [in] file_size 入力ストリームの元のデータサイズ
@@ -1626,6 +1848,7 @@ void DiskBasicDirItem::CopyItem(const DiskBasicDirItem &src)
 	// データはコピーする
 	CopyData(src.GetData());
 	// グループ
+	src.ResolveGroups();
 	m_groups = src.m_groups;
 	// サイズ
 //	m_file_size = src.m_file_size;
@@ -2167,6 +2390,106 @@ void DiskBasicDirItem::SetCommonDataInAttrDialog(KeyValArray &vals) const
 	vals.Add(wxT("external_attr"), (wxUint32)m_external_attr);
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+// ディレクトリ内のファイル名索引
+//
+DiskBasicDirNameIndex::DiskBasicDirNameIndex()
+{
+	m_count = 0;
+	m_icase = false;
+	m_valid = false;
+}
+
+/// 索引にアイテムを追加
+/// @param [in,out] map  索引
+/// @param [in]     key  索引キー
+/// @param [in]     item アイテム
+void DiskBasicDirNameIndex::Add(DiskBasicDirNameIndexMap &map, const wxString &key, DiskBasicDirItem *item)
+{
+	DiskBasicDirItems &items = map[key];
+	if (items.Index(item) == wxNOT_FOUND) {
+		items.Add(item);
+	}
+}
+
+/// 索引からアイテムリストを返す
+/// @param [in] map 索引
+/// @param [in] key 索引キー
+/// @return NULL:該当なし
+const DiskBasicDirItems *DiskBasicDirNameIndex::Find(const DiskBasicDirNameIndexMap &map, const wxString &key)
+{
+	DiskBasicDirNameIndexMap::const_iterator it = map.find(key);
+	if (it == map.end()) return NULL;
+	return &it->second;
+}
+
+/// アイテムを索引に追加
+/// 使用していないアイテムは検索で一致しないので登録しない
+/// @param [in] item アイテム
+void DiskBasicDirNameIndex::AddItem(DiskBasicDirItem *item)
+{
+	if (!item || !item->IsUsedAndVisible()) return;
+
+	wxString key;
+	item->GetFileNameKey(m_icase, key);
+	Add(m_files, key, item);
+	item->GetNameKey(m_icase, key);
+	Add(m_names, key, item);
+
+	// 拡張子の長さが異なるアイテムは検索キーの作り方も異なる
+	size_t layout = item->GetFileNameKeyLayout();
+	for(size_t i=0; i<m_key_items.Count(); i++) {
+		if (m_key_items.Item(i)->GetFileNameKeyLayout() == layout) return;
+	}
+	m_key_items.Add(item);
+}
+
+/// 索引を無効にする
+void DiskBasicDirNameIndex::Invalidate()
+{
+	m_files.clear();
+	m_names.clear();
+	m_key_items.Clear();
+	m_count = 0;
+	m_valid = false;
+}
+
+/// 索引を作成する 作成済みなら何もしない
+/// 子アイテムの数が変わっていたら作り直す
+/// @param [in] children 子アイテム一覧
+/// @param [in] icase    大文字小文字を区別しないか(case insensitive)
+void DiskBasicDirNameIndex::Prepare(const DiskBasicDirItems *children, bool icase)
+{
+	if (m_valid && m_icase == icase && m_count == children->Count()) return;
+
+	Invalidate();
+	m_icase = icase;
+	for(size_t pos = 0; pos < children->Count(); pos++) {
+		AddItem(children->Item(pos));
+	}
+	m_count = children->Count();
+	m_valid = true;
+}
+
+/// アイテムの新しいファイル名を索引に反映する
+/// 古いキーに残ったアイテムは検索時の確認で除かれる
+/// @param [in] children 子アイテム一覧
+/// @param [in] item     書き込みや名前変更を行ったアイテム
+void DiskBasicDirNameIndex::Update(const DiskBasicDirItems *children, DiskBasicDirItem *item)
+{
+	if (!m_valid) return;
+
+	// アイテムを挿入した場合を除き、一覧が変わっていたら作り直す
+	size_t count = children->Count();
+	if (count != m_count && count != m_count + 1) {
+		Invalidate();
+		return;
+	}
+	m_count = count;
+	AddItem(item);
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 // 属性値を一時的に集めておくクラス
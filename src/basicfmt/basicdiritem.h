@@ -12,6 +12,7 @@
 #include "basiccommon.h"
 #include <wx/string.h>
 #include <wx/dynarray.h>
+#include <wx/hashmap.h>
 
 
 class wxWindow;
@@ -32,6 +33,8 @@ class IntNameBox;
 class DiskBasicDirItem;
 class DiskBasicDirItems;
 class DiskBasicDirItemAttr;
+class DiskBasicDirNameIndex;
+class CharCodeMap;
 
 
 //////////////////////////////////////////////////////////////////////
@@ -160,6 +163,7 @@ public:
 		USED_ITEM	 = 0x0001,	///< bit0:使用しているか
 		VISIBLE_LIST = 0x0002,	///< bit1:リストに表示するか
 		VISIBLE_TREE = 0x0004,	///< bit2:ツリーに表示するか
+		GROUPS_PENDING = 0x0008,	///< bit3:グループの計算を保留しているか
 	};
 
 protected:
@@ -168,15 +172,22 @@ protected:
 
 	DiskBasicDirItem  *m_parent;	///< 親ディレクトリ
 	DiskBasicDirItems *m_children;	///< 子ディレクトリ
+	DiskBasicDirNameIndex *m_name_index;	///< 子ディレクトリのファイル名索引
 	bool		m_valid_dir;		///< 上記ディレクトリツリーが確定しているか
 
 	int			m_num;				///< 通し番号
 	int			m_position;			///< セクタ内の位置（バイト）
-	int			m_flags;			///< フラグ bit0:使用しているか bit1:リストに表示するか bit2:ツリーに表示するか
+	int			m_flags;			///< フラグ bit0:使用しているか bit1:リストに表示するか bit2:ツリーに表示するか bit3:グループ計算保留
 	DiskBasicGroups m_groups;		///< 占有グループ
 	DiskImageSector *m_sector;		///< ディレクトリのあるセクタ
 	int			m_external_attr;	///< ディレクトリエントリ内に持たない属性を保持する(機種依存)
 
+	wxString	m_name_cache;		///< 変換済みのファイル名
+	wxUint8		m_name_cache_raw[FILENAME_BUFSIZE + FILEEXT_BUFSIZE];	///< 変換前の内部ファイル名＋拡張子
+	size_t		m_name_cache_nlen;	///< 変換前のファイル名長さ
+	size_t		m_name_cache_elen;	///< 変換前の拡張子長さ
+	const CharCodeMap *m_name_cache_map;	///< 変換に使用した文字コードマップ NULLはキャッシュなし
+
 	DiskBasicDirItem();
 	DiskBasicDirItem(const DiskBasicDirItem &src);
 	DiskBasicDirItem &operator=(const DiskBasicDirItem &src);
@@ -186,6 +197,18 @@ protected:
 	virtual void	Dup(const DiskBasicDirItem &src);
 #endif
 
+	/// @name グループの遅延計算
+	//@{
+	/// @brief グループの計算を保留できるか
+	virtual bool	CanDeferCalcFileSize() const { return false; }
+	/// @brief ファイルサイズとグループ数の計算を必要になるまで保留する
+	void			DeferCalcFileSize();
+	/// @brief 保留していたファイルサイズとグループ数の計算を行う
+	void			ResolveGroups() const;
+	/// @brief グループの計算を保留しているか
+	bool			IsGroupsPending() const { return (m_flags & GROUPS_PENDING) != 0; }
+	//@}
+
 	/// @name 機種依存パラメータへのアクセス(protected)
 	//@{
 	/// @brief ファイル名を格納する位置を返す
@@ -287,6 +310,12 @@ public:
 	const DiskBasicDirItems *GetChildren() const { return m_children; }
 	/// @brief 子ディレクトリ一覧をクリア
 	void			EmptyChildren();
+	/// @brief 子ディレクトリのファイル名索引を返す
+	DiskBasicDirNameIndex *GetNameIndex() const { return m_name_index; }
+	/// @brief 子ディレクトリのファイル名索引にアイテムを反映する
+	void			UpdateNameIndex(DiskBasicDirItem *item);
+	/// @brief 子ディレクトリのファイル名索引を無効にする
+	void			InvalidateNameIndex();
 	/// @brief ディレクトリツリーが確定しているか
 	bool			IsValidDirectory() const { return m_valid_dir; }
 	/// @brief ディレクトリツリーが確定しているか設定
@@ -333,6 +362,8 @@ public:
 	virtual void	SetNativeFileName(wxUint8 *name, size_t nsize, size_t nlen, wxUint8 *ext, size_t esize, size_t elen);
 	/// @brief ファイル名をコピー
 	void			CopyFileName(const DiskBasicDirItem &src);
+	/// @brief 変換済みのファイル名を破棄する
+	void			ClearFileNameCache() { m_name_cache_map = NULL; }
 	/// @brief ファイル名を返す 名前 + "." + 拡張子
 	wxString		GetFileNameStr() const;
 	/// @brief ファイル名を返す 名前 + "." + 拡張子 エクスポート時
@@ -360,6 +391,18 @@ public:
 	/// @brief ファイル名に付随する拡張属性を返す
 	/// @see IsSameFileName()
 	virtual int		GetOptionalName() const { return 0; }
+	/// @brief ファイル名の索引キーを返す
+	void			GetFileNameKey(bool icase, wxString &key) const;
+	/// @brief 指定したファイル名の索引キーを返す
+	bool			ToFileNameKey(const DiskBasicFileName &filename, bool icase, wxString &key) const;
+	/// @brief ファイル名(拡張子除く)の索引キーを返す
+	void			GetNameKey(bool icase, wxString &key) const;
+	/// @brief 指定したファイル名(拡張子除く)の索引キーを返す
+	bool			ToNameKey(const wxString &name, bool icase, wxString &key) const;
+	/// @brief 指定したファイル名を索引キーに変換する時の拡張子の長さ
+	size_t			GetFileNameKeyLayout() const;
+	/// @brief 内部ファイル名から索引キーを作成
+	static void		MakeFileNameKey(const wxUint8 *name, size_t nlen, const wxUint8 *ext, size_t elen, int optional, wxString &key);
 	/// @brief 文字列をバッファにコピー あまりはfillでパディング
 	static void		MemoryCopy(const wxUint8 *src, size_t ssize, size_t slen, wxUint8 *dst, size_t dsize, size_t &dlen);
 	/// @brief 文字列をバッファにコピー spchr(通常".")で拡張子とを分ける
@@ -416,6 +459,8 @@ public:
 	void			SetGroupSize(int val);
 	/// @brief グループ数を返す
 	int				GetGroupSize() const;
+	/// @brief グループ数を返す(ファイル一覧画面表示用)
+	virtual int		GetGroupSizeForList() const;
 	/// @brief 最初のグループ番号をセット
 	virtual void	SetStartGroup(int fileunit_num, wxUint32 val, int size = 0);
 	/// @brief 最初のグループ番号を返す
@@ -730,6 +775,51 @@ WX_DEFINE_ARRAY(DiskBasicDirItem *, DiskBasicDirItems);
 
 //////////////////////////////////////////////////////////////////////
 
+/// @class DiskBasicDirNameIndexMap
+///
+/// @brief 索引キーとアイテムリストのハッシュ
+WX_DECLARE_STRING_HASH_MAP(DiskBasicDirItems, DiskBasicDirNameIndexMap);
+
+/// @brief ディレクトリ内のファイル名索引
+///
+/// 同名ファイルの検索で候補を絞り込むために使用する。
+/// 候補は IsSameFileName() などで必ず確認すること。
+class DiskBasicDirNameIndex
+{
+private:
+	DiskBasicDirNameIndexMap m_files;	///< ファイル名＋拡張子＋拡張属性の索引
+	DiskBasicDirNameIndexMap m_names;	///< ファイル名(拡張子除く)の索引
+	DiskBasicDirItems m_key_items;		///< 拡張子の長さごとの代表アイテム 検索キーの作成用
+	size_t	m_count;	///< 作成時の子アイテム数
+	bool	m_icase;	///< 大文字小文字を区別しないで作成したか
+	bool	m_valid;	///< 作成済みか
+
+	/// @brief 索引にアイテムを追加
+	static void Add(DiskBasicDirNameIndexMap &map, const wxString &key, DiskBasicDirItem *item);
+	/// @brief 索引からアイテムリストを返す
+	static const DiskBasicDirItems *Find(const DiskBasicDirNameIndexMap &map, const wxString &key);
+	/// @brief アイテムを索引に追加
+	void		AddItem(DiskBasicDirItem *item);
+
+public:
+	DiskBasicDirNameIndex();
+
+	/// @brief 索引を無効にする
+	void		Invalidate();
+	/// @brief 索引を作成する 作成済みなら何もしない
+	void		Prepare(const DiskBasicDirItems *children, bool icase);
+	/// @brief アイテムの新しいファイル名を索引に反映する
+	void		Update(const DiskBasicDirItems *children, DiskBasicDirItem *item);
+	/// @brief ファイル名＋拡張子＋拡張属性が一致する候補を返す
+	const DiskBasicDirItems *FindFiles(const wxString &key) const { return Find(m_files, key); }
+	/// @brief ファイル名(拡張子除く)が一致する候補を返す
+	const DiskBasicDirItems *FindNames(const wxString &key) const { return Find(m_names, key); }
+	/// @brief 検索キーの作成に使うアイテム 拡張子の長さが異なるアイテムごとに1つ
+	const DiskBasicDirItems &GetKeyItems() const { return m_key_items; }
+};
+
+//////////////////////////////////////////////////////////////////////
+
 /// @brief 属性値を一時的に集めておくクラス
 class DiskBasicDirItemAttr
 {
@@ -779,8 +779,8 @@ bool DiskBasicDirItemAmiga::GetFileGroups(const wxUint32 *tables, int table_size
 	int calc_file_size = 0;
 //	int real_file_size = 0;
 
-	amiga_block_pre_t *expre = NULL;
-	amiga_header_post_t *expost = NULL;
+	const amiga_block_pre_t *expre = NULL;
+	const amiga_header_post_t *expost = NULL;
 
 	const wxUint32 *table = tables;
 
@@ -802,7 +802,7 @@ bool DiskBasicDirItemAmiga::GetFileGroups(const wxUint32 *tables, int table_size
 			if (!sector) {
 				break;
 			}
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			if (!buffer) {
 				break;
 			}
@@ -831,7 +831,7 @@ bool DiskBasicDirItemAmiga::GetFileGroups(const wxUint32 *tables, int table_size
 		if (!sector) {
 			break;
 		}
-		expre = (amiga_block_pre_t *)sector->GetSectorBuffer();
+		expre = (const amiga_block_pre_t *)sector->PeekSectorBuffer();
 		if (!expre) {
 			break;
 		}
@@ -840,7 +840,7 @@ bool DiskBasicDirItemAmiga::GetFileGroups(const wxUint32 *tables, int table_size
 			break;
 		}
 		table = expre->u.table;
-		expost = (amiga_header_post_t *)sector->GetSectorBuffer(sector->GetSectorSize() - (int)sizeof(amiga_header_post_t));
+		expost = (const amiga_header_post_t *)(sector->PeekSectorBuffer() + sector->GetSectorSize() - (int)sizeof(amiga_header_post_t));
 		if (extension_list) extension_list->Add(exnum);
 	}
 	if (group_items && prev_num > 0) {
@@ -887,7 +887,7 @@ bool DiskBasicDirItemAmiga::GetDirectoryGroups(DiskBasic *basic, wxUint32 *table
 				break;
 			}
 			// ヘッダ種類が2なら有効
-			wxUint32 type = *(wxUint32 *)sector->GetSectorBuffer();
+			wxUint32 type = *(const wxUint32 *)sector->PeekSectorBuffer();
 			type = wxUINT32_SWAP_ON_LE(type);
 			if (type != FILETYPE_MASK_AMIGA_HEADER) {
 				valid = false;
@@ -496,7 +496,7 @@ int DiskBasicDirItemAppleDOS::RecalcFileSize(DiskBasicGroups &group_items, int o
 	if (!sector) return occupied_size;
 
 	int sector_size = sector->GetSectorSize();
-	wxUint8 *buf = sector->GetSectorBuffer();
+	const wxUint8 *buf = sector->PeekSectorBuffer();
 	int remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, buf, sector_size, sector_size);
 
 	occupied_size = occupied_size - sector_size + remain_size;
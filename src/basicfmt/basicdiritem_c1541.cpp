@@ -328,7 +328,7 @@ void DiskBasicDirItemC1541::GetUnitGroups(int fileunit_num, DiskBasicGroups &gro
 			if (!sector) {
 				break;
 			}
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			if (!buffer) {
 				break;
 			}
@@ -341,7 +341,7 @@ void DiskBasicDirItemC1541::GetUnitGroups(int fileunit_num, DiskBasicGroups &gro
 			limit -= bytes_per_group;
 
 			// 次のセクタなし
-			c1541_ptr_t *next = (c1541_ptr_t *)buffer;
+			const c1541_ptr_t *next = (const c1541_ptr_t *)buffer;
 			if (next->track == 0 || (int)next->track > basic->GetTracksPerSideOnBasic()) {
 				break;
 			}
@@ -382,7 +382,7 @@ int DiskBasicDirItemC1541::RecalcFileSize(DiskBasicGroups &group_items, int occu
 	if (!sector) {
 		return occupied_size;
 	}
-	c1541_ptr_t *p = (c1541_ptr_t *)sector->GetSectorBuffer();
+	const c1541_ptr_t *p = (const c1541_ptr_t *)sector->PeekSectorBuffer();
 	if (!p) {
 		return occupied_size;
 	}
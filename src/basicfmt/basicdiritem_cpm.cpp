@@ -396,7 +396,7 @@ int DiskBasicDirItemCPM::RecalcFileSize(DiskBasicGroups &group_items, int occupi
 	int sector_size = sector->GetSectorSize();
 	int remain_size = ((occupied_size + SECTOR_UNIT_CPM - 1) % SECTOR_UNIT_CPM) + 1;
 	int unit_pos = (((occupied_size + sector_size - 1) % sector_size) / SECTOR_UNIT_CPM);
-	wxUint8 *buf = sector->GetSectorBuffer();
+	const wxUint8 *buf = sector->PeekSectorBuffer();
 	buf += (unit_pos * SECTOR_UNIT_CPM);
 	remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, buf, SECTOR_UNIT_CPM, remain_size);
 
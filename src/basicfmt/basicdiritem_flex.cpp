@@ -271,7 +271,7 @@ void DiskBasicDirItemFLEX::GetUnitGroups(int fileunit_num, DiskBasicGroups &grou
 				// error
 				break;
 			}
-			flex_ptr_t *p = (flex_ptr_t *)sector->GetSectorBuffer(SecBufOfs(div_num + 1));
+			const flex_ptr_t *p = (const flex_ptr_t *)sector->PeekSectorBuffer(SecBufOfs(div_num + 1));
 			next_track_num = p->next_track;
 			next_sector_num = p->next_sector;
 
@@ -293,7 +293,7 @@ void DiskBasicDirItemFLEX::GetUnitGroups(int fileunit_num, DiskBasicGroups &grou
 			// error
 			break;
 		}
-		flex_ptr_t *p = (flex_ptr_t *)sector->GetSectorBuffer(SecBufOfs(div_num + 1));
+		const flex_ptr_t *p = (const flex_ptr_t *)sector->PeekSectorBuffer(SecBufOfs(div_num + 1));
 		next_track_num = p->next_track;
 		next_sector_num = p->next_sector;
 
@@ -315,7 +315,7 @@ void DiskBasicDirItemFLEX::GetUnitGroups(int fileunit_num, DiskBasicGroups &grou
 
 		if (track_num == 0 || sector_num == 0) {
 			// 最終セクタは0パディング部分のサイズを減らす
-			wxUint8 *buf = sector->GetSectorBuffer(SecBufOfs(div_num + 1));
+			const wxUint8 *buf = sector->PeekSectorBuffer(SecBufOfs(div_num + 1));
 			for(int pos = LogSecSiz(sector->GetSectorSize()) - 1; pos >= 4; pos--) {
 				if (buf[pos] != 0) break;
 				calc_file_size--;
@@ -450,7 +450,7 @@ void DiskBasicDirItemHFS::GetUnitGroupsDir(int fileunit_num, const hfs_cat_dir_r
 
 		sec_num = sector->GetSectorNumber();
 
-		wxUint8 *buffer = sector->GetSectorBuffer(); 
+		const wxUint8 *buffer = sector->PeekSectorBuffer();
 		if (!buffer) {
 			break;
 		}
@@ -508,18 +508,18 @@ void DiskBasicDirItemHFS::GetUnitGroupsFileExt(int fileunit_num, int fork_type,
 		if (!sector) {
 			break;
 		}
-		wxUint8 *buffer = sector->GetSectorBuffer();
+		const wxUint8 *buffer = sector->PeekSectorBuffer();
 		if (!buffer) {
 			break;
 		}
 
-		hfs_node_descriptor_t *node = (hfs_node_descriptor_t *)buffer;
+		const hfs_node_descriptor_t *node = (const hfs_node_descriptor_t *)buffer;
 		if (node->type == ndHdrNode) {
 			// ヘッダノードは常に最初
 			if (idx != 0) {
 				break;
 			}
-			hfs_bt_hdr_rec_t *header = (hfs_bt_hdr_rec_t *)&buffer[0xe];
+			const hfs_bt_hdr_rec_t *header = (const hfs_bt_hdr_rec_t *)&buffer[0xe];
 
 			end_idx = (int)(wxUINT32_SWAP_ON_LE(header->totalNodes) - wxUINT32_SWAP_ON_LE(header->freeNodes));
 			continue;
@@ -543,7 +543,7 @@ void DiskBasicDirItemHFS::GetUnitGroupsFileExt(int fileunit_num, int fork_type,
 //			int pos = (int)rpos;
 
 			// レコードのキー部分
-			hfs_ext_key_rec_t* rec_key = (hfs_ext_key_rec_t *)&buffer[rpos];
+			const hfs_ext_key_rec_t* rec_key = (const hfs_ext_key_rec_t *)&buffer[rpos];
 			if ((fork_type & 0xff) != rec_key->forkType || (wxUint32)file_id != wxUINT32_SWAP_ON_LE(rec_key->id)) {
 				continue;
 			}
@@ -559,7 +559,7 @@ void DiskBasicDirItemHFS::GetUnitGroupsFileExt(int fileunit_num, int fork_type,
 				rpos++;
 			}
 			// レコードのデータ部分
-			hfs_ext_data_rec_t *rec_dat = (hfs_ext_data_rec_t *)&buffer[rpos];
+			const hfs_ext_data_rec_t *rec_dat = (const hfs_ext_data_rec_t *)&buffer[rpos];
 
 			// 拡張レコードからグループを取得
 			GetGroupsFromExtDataRec(rec_dat, group_items);
@@ -590,7 +590,7 @@ void DiskBasicDirItemHFS::GetGroupsFromExtDataRec(const hfs_ext_data_rec_t *exts
 			}
 			sec_num = sector->GetSectorNumber();
 
-			wxUint8 *buffer = sector->GetSectorBuffer(); 
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			if (!buffer) {
 				break;
 			}
@@ -618,7 +618,7 @@ int DiskBasicDirItemHFS::RecalcFileSize(DiskBasicGroups &group_items, int occupi
 	if (!sector) return occupied_size;
 
 	int sector_size = sector->GetSectorSize();
-	wxUint8 *buf = sector->GetSectorBuffer();
+	const wxUint8 *buf = sector->PeekSectorBuffer();
 	int remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, buf, sector_size, sector_size);
 
 	occupied_size = occupied_size - sector_size + remain_size;
@@ -64,8 +64,8 @@ DiskBasicDirItemMSDOS::DiskBasicDirItemMSDOS(DiskBasic *basic, int n_num, const
 	Visible((GetFileType1() & FILETYPE_MASK_MS_LFN) != FILETYPE_MASK_MS_LFN);
 	n_unuse = (n_unuse || (m_data.Data()->msdos.name[0] == 0));
 
-	// グループ数を計算
-	CalcFileSize();
+	// グループ数の計算はチェーンを参照する時まで保留する
+	DeferCalcFileSize();
 
 	// カレント or 親ディレクトリはツリーに表示しない
 	wxString name = GetFileNamePlainStr();
@@ -354,6 +354,25 @@ void DiskBasicDirItemMSDOS::CalcFileUnitSize(int fileunit_num)
 	GetUnitGroups(fileunit_num, m_groups);
 }
 
+/// グループ数を返す(ファイル一覧画面表示用)
+/// @note 計算を保留している間はエントリ内のファイルサイズから求め、FATのチェーンをたどらない
+/// @return 数
+int DiskBasicDirItemMSDOS::GetGroupSizeForList() const
+{
+	if (!IsGroupsPending()) return GetGroupSize();
+	if (!IsUsed()) return 0;
+
+	int file_size = GetFileSize();
+	if (file_size <= 0) {
+		// サイズを持たないディレクトリなどはチェーンから求める
+		if (GetStartGroup(0) < 2) return 0;
+		return GetGroupSize();
+	}
+	int group_size = basic->GetSectorSize() * basic->GetSectorsPerGroup();
+	if (group_size <= 0) return GetGroupSize();
+	return (file_size + group_size - 1) / group_size;
+}
+
 /// 指定ディレクトリのすべてのグループを取得
 /// @param [in]  fileunit_num ファイル番号
 /// @param [out] group_items  グループリスト
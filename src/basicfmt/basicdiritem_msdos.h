@@ -79,6 +79,9 @@ protected:
 	/// @brief ダイアログ表示前にファイルの属性を設定
 	virtual void	SetFileTypeForAttrDialog(int show_flags, const wxString &name, int &file_type_1, int &file_type_2);
 
+	/// @brief グループの計算を保留できるか ファイルサイズはエントリ内に持つ
+	virtual bool	CanDeferCalcFileSize() const { return true; }
+
 	/// @brief ダイアログ内の属性部分のレイアウトを作成
 	wxStaticBoxSizer *CreateControlsSubForAttrDialog(IntNameBox *parent, int show_flags, wxBoxSizer *sizer, wxSizerFlags &flags, int file_type_1);
 	/// @brief 属性を設定する
@@ -125,6 +128,8 @@ public:
 
 	/// @brief 指定ディレクトリのすべてのグループを取得
 	virtual void	GetUnitGroups(int fileunit_num, DiskBasicGroups &group_items);
+	/// @brief グループ数を返す(ファイル一覧画面表示用)
+	virtual int		GetGroupSizeForList() const;
 
 	/// @brief 最初のグループ番号をセット
 	virtual void	SetStartGroup(int fileunit_num, wxUint32 val, int size = 0);
@@ -709,7 +709,7 @@ void DiskBasicDirItemProDOS::GetUnitGroups(int fileunit_num, DiskBasicGroups &gr
 				if (!sector) {
 					break;
 				}
-				wxUint8 *buffer = sector->GetSectorBuffer();
+				const wxUint8 *buffer = sector->PeekSectorBuffer();
 				if (!buffer) {
 					break;
 				}
@@ -764,7 +764,7 @@ int DiskBasicDirItemProDOS::RecalcFileSize(DiskBasicGroups &group_items, int occ
 	if (!sector) return occupied_size;
 
 	int sector_size = sector->GetSectorSize();
-	wxUint8 *buf = sector->GetSectorBuffer();
+	const wxUint8 *buf = sector->PeekSectorBuffer();
 	int remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, buf, sector_size, sector_size);
 
 	occupied_size = occupied_size - sector_size + remain_size;
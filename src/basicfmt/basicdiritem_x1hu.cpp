@@ -352,7 +352,7 @@ int	DiskBasicDirItemX1HU::RecalcFileSize(DiskBasicGroups &group_items, int occup
 
 	int sector_size = sector->GetSectorSize();
 	int remain_size = ((occupied_size + sector_size - 1) % sector_size) + 1;
-	remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, sector->GetSectorBuffer(), sector_size, remain_size);
+	remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, sector->PeekSectorBuffer(), sector_size, remain_size);
 
 	occupied_size = occupied_size - sector_size + remain_size;
 	return occupied_size;
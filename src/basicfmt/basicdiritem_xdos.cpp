@@ -385,7 +385,7 @@ int	DiskBasicDirItemXDOSBase::RecalcFileSize(DiskBasicGroups &group_items, int o
 
 	int sector_size = sector->GetSectorSize();
 	int remain_size = ((occupied_size + sector_size - 1) % sector_size) + 1;
-	remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, sector->GetSectorBuffer(), sector_size, remain_size);
+	remain_size = type->CalcDataSizeOnLastSector(this, NULL, NULL, sector->PeekSectorBuffer(), sector_size, remain_size);
 
 	occupied_size = occupied_size - sector_size + remain_size;
 	return occupied_size;
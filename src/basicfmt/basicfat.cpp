@@ -59,6 +59,19 @@ void DiskBasicAvailabillity::Add(int val, int size, int group)
 	m_free_grps += group;
 }
 
+/// 同じ値をまとめて追加
+/// @param[in] val   値
+/// @param[in] size  1つあたりの空きサイズ
+/// @param[in] group 1つあたりの空きグループ数
+/// @param[in] count 追加する数
+void DiskBasicAvailabillity::Add(int val, int size, int group, size_t count)
+{
+	if (count == 0) return;
+	wxArrayInt::Add(val, count);
+	m_free_size += size * (int)count;
+	m_free_grps += group * (int)count;
+}
+
 /// セット (Safety)
 /// @param[in] idx 位置
 /// @param[in] val 値
@@ -81,12 +94,229 @@ int DiskBasicAvailabillity::Get(size_t idx) const
 	return val;
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+// 空きグループの索引
+//
+//////////////////////////////////////////////////////////////////////
+
+DiskBasicFreeGroupIndex::DiskBasicFreeGroupIndex()
+{
+	m_words = NULL;
+	m_unit_frees = NULL;
+	m_groups = 0;
+	m_unit_groups = 1;
+	m_units = 0;
+}
+
+DiskBasicFreeGroupIndex::~DiskBasicFreeGroupIndex()
+{
+	Clear();
+}
+
+/// 作成 すべて使用済みにする
+/// @param [in] groups      グループ数
+/// @param [in] unit_groups 1単位(トラック)あたりのグループ数
+void DiskBasicFreeGroupIndex::Create(wxUint32 groups, int unit_groups)
+{
+	Clear();
+
+	if (unit_groups < 1) unit_groups = 1;
+	m_groups = groups;
+	m_unit_groups = unit_groups;
+	m_units = (int)((groups + unit_groups - 1) / unit_groups);
+
+	size_t words = (groups + 31) / 32 + 1;
+	m_words = new wxUint32[words];
+	memset(m_words, 0, sizeof(wxUint32) * words);
+	m_unit_frees = new int[m_units + 1];
+	memset(m_unit_frees, 0, sizeof(int) * (m_units + 1));
+}
+
+/// 削除
+void DiskBasicFreeGroupIndex::Clear()
+{
+	delete [] m_words;
+	m_words = NULL;
+	delete [] m_unit_frees;
+	m_unit_frees = NULL;
+	m_groups = 0;
+	m_units = 0;
+}
+
+/// 空きかどうかを設定
+/// @param [in] num グループ番号
+/// @param [in] val 空きならtrue
+void DiskBasicFreeGroupIndex::SetFree(wxUint32 num, bool val)
+{
+	if (!m_words || num >= m_groups) return;
+	wxUint32 bit = (1U << (num & 31));
+	wxUint32 &word = m_words[num >> 5];
+	if (((word & bit) != 0) == val) return;
+	if (val) {
+		word |= bit;
+		m_unit_frees[num / m_unit_groups]++;
+	} else {
+		word &= ~bit;
+		m_unit_frees[num / m_unit_groups]--;
+	}
+}
+
+/// 空きか
+/// @param [in] num グループ番号
+/// @return 空きならtrue
+bool DiskBasicFreeGroupIndex::IsFree(wxUint32 num) const
+{
+	if (!m_words || num >= m_groups) return false;
+	return ((m_words[num >> 5] & (1U << (num & 31))) != 0);
+}
+
+/// 単位内の空き数
+/// @param [in] unit 単位番号(グループ番号 / 1単位あたりのグループ数)
+/// @return 空き数
+int DiskBasicFreeGroupIndex::GetUnitFrees(int unit) const
+{
+	if (!m_unit_frees || unit < 0 || unit >= m_units) return 0;
+	return m_unit_frees[unit];
+}
+
+/// 範囲内で最初の空きをさがす
+/// @param [in] start 開始グループ番号
+/// @param [in] end   終了グループ番号(この番号を含む)
+/// @return 空きグループ番号 / INVALID_GROUP_NUMBER 空きなし
+wxUint32 DiskBasicFreeGroupIndex::FindFree(wxUint32 start, wxUint32 end) const
+{
+	if (!m_words || m_groups == 0) return INVALID_GROUP_NUMBER;
+	if (end >= m_groups) end = m_groups - 1;
+	if (start > end) return INVALID_GROUP_NUMBER;
+
+	wxUint32 pos = (start >> 5);
+	wxUint32 last = (end >> 5);
+	// 開始位置より前のビットは落とす
+	wxUint32 word = m_words[pos] & (0xffffffffU << (start & 31));
+	for(;;) {
+		if (word != 0) {
+			wxUint32 num = (pos << 5) + (wxUint32)Utils::CountTrailingZeros(word);
+			return (num <= end ? num : INVALID_GROUP_NUMBER);
+		}
+		if (pos >= last) break;
+		pos++;
+		word = m_words[pos];
+	}
+	return INVALID_GROUP_NUMBER;
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 // ビット ON/OFF バッファ １つ
 //
 //////////////////////////////////////////////////////////////////////
 
+/// バイト内のビットの並びを逆にする
+static inline wxUint8 ReverseBits8(wxUint8 val)
+{
+	val = (wxUint8)((val >> 4) | (val << 4));
+	val = (wxUint8)(((val & 0xcc) >> 2) | ((val & 0x33) << 2));
+	val = (wxUint8)(((val & 0xaa) >> 1) | ((val & 0x55) << 1));
+	return val;
+}
+
+/// 64ビット値を読む
+///
+/// ビットマップの先頭から数えたビット位置が、値の下位からのビット位置と
+/// 一致するように並べ替える。バッファの範囲外は0になる。
+/// @param[in] buffer   バッファ
+/// @param[in] size     バッファサイズ(bytes)
+/// @param[in] word_pos 位置(64ビット単位)
+/// @param[in] order    ビットの並び en_bitmap_orders
+/// @return 値
+wxUint64 DiskBasicBitmapWords::Load(const wxUint8 *buffer, size_t size, size_t word_pos, int order)
+{
+	wxUint64 val = 0;
+	size_t pos = (word_pos << 3);
+	for(size_t i = 0; i < 8 && pos + i < size; i++) {
+		wxUint8 dat = buffer[pos + i];
+		size_t sft = i;
+		switch(order) {
+		case BITMAP_ORDER_MSB:
+			dat = ReverseBits8(dat);
+			break;
+		case BITMAP_ORDER_LSB32BE:
+			sft = (i & 4) | (3 - (i & 3));
+			break;
+		default:
+			break;
+		}
+		val |= ((wxUint64)dat << (sft << 3));
+	}
+	return val;
+}
+
+/// 範囲内で指定値のビット数を返す
+/// @param[in] buffer バッファ
+/// @param[in] size   バッファサイズ(bytes)
+/// @param[in] start  開始ビット位置
+/// @param[in] end    終了ビット位置(この位置を含む)
+/// @param[in] val    数えるビットの値
+/// @param[in] order  ビットの並び en_bitmap_orders
+/// @return ビット数
+wxUint32 DiskBasicBitmapWords::Count(const wxUint8 *buffer, size_t size, wxUint32 start, wxUint32 end, bool val, int order)
+{
+	wxUint32 bits = (wxUint32)(size << 3);
+	if (!buffer || bits == 0) return 0;
+	if (end >= bits) end = bits - 1;
+	if (start > end) return 0;
+
+	wxUint32 count = 0;
+	size_t first = (start >> 6);
+	size_t last = (end >> 6);
+	for(size_t pos = first; pos <= last; pos++) {
+		wxUint64 word = Load(buffer, size, pos, order);
+		if (!val) word = ~word;
+		if (pos == first) {
+			word &= (~(wxUint64)0 << (start & 63));
+		}
+		if (pos == last && (end & 63) != 63) {
+			word &= (((wxUint64)2 << (end & 63)) - 1);
+		}
+		count += (wxUint32)Utils::PopCount64(word);
+	}
+	return count;
+}
+
+/// 範囲内で最初に指定値となるビット位置を返す
+/// @param[in] buffer バッファ
+/// @param[in] size   バッファサイズ(bytes)
+/// @param[in] start  開始ビット位置
+/// @param[in] end    終了ビット位置(この位置を含む)
+/// @param[in] val    さがすビットの値
+/// @param[in] order  ビットの並び en_bitmap_orders
+/// @return ビット位置 / INVALID_GROUP_NUMBER なし
+wxUint32 DiskBasicBitmapWords::Find(const wxUint8 *buffer, size_t size, wxUint32 start, wxUint32 end, bool val, int order)
+{
+	wxUint32 bits = (wxUint32)(size << 3);
+	if (!buffer || bits == 0) return INVALID_GROUP_NUMBER;
+	if (end >= bits) end = bits - 1;
+	if (start > end) return INVALID_GROUP_NUMBER;
+
+	size_t first = (start >> 6);
+	size_t last = (end >> 6);
+	for(size_t pos = first; pos <= last; pos++) {
+		wxUint64 word = Load(buffer, size, pos, order);
+		if (!val) word = ~word;
+		if (pos == first) {
+			word &= (~(wxUint64)0 << (start & 63));
+		}
+		if (word != 0) {
+			wxUint32 num = (wxUint32)(pos << 6) + (wxUint32)Utils::CountTrailingZeros64(word);
+			return (num <= end ? num : INVALID_GROUP_NUMBER);
+		}
+	}
+	return INVALID_GROUP_NUMBER;
+}
+
+//////////////////////////////////////////////////////////////////////
+
 BitMLBuffer::BitMLBuffer()
 {
 	m_buffer = NULL;
@@ -206,6 +436,78 @@ bool DiskBasicBitMLMap::GetPosInMap(wxUint32 group_num, size_t &idx, wxUint32 &p
 	return valid;
 }
 
+/// サイズ(ビット数)を返す
+wxUint32 DiskBasicBitMLMap::GetBitSize() const
+{
+	wxUint32 bits = 0;
+	for(size_t idx = 0; idx < Count(); idx++) {
+		bits += (wxUint32)Item(idx).GetBitSize();
+	}
+	return bits;
+}
+
+/// 範囲内で指定値のビット数を返す
+/// @param[in] start 開始位置
+/// @param[in] end   終了位置(この位置を含む)
+/// @param[in] val   数えるビットの値
+/// @return ビット数
+wxUint32 DiskBasicBitMLMap::CountBits(wxUint32 start, wxUint32 end, bool val) const
+{
+	wxUint32 count = 0;
+	wxUint32 base = 0;
+	for(size_t idx = 0; idx < Count() && start <= end; idx++) {
+		BitMLBuffer *item = &Item(idx);
+		wxUint32 size = (wxUint32)item->GetBitSize();
+		if (start < base + size) {
+			count += DiskBasicBitmapWords::Count(item->GetBuffer(), item->GetSize(), start - base, end - base, val, BITMAP_ORDER_MSB);
+			if (end < base + size) break;
+			start = base + size;
+		}
+		base += size;
+	}
+	return count;
+}
+
+/// 範囲内で最初に指定値となる位置を返す
+/// @param[in] start 開始位置
+/// @param[in] end   終了位置(この位置を含む)
+/// @param[in] val   さがすビットの値
+/// @return 位置 / INVALID_GROUP_NUMBER なし
+wxUint32 DiskBasicBitMLMap::Find(wxUint32 start, wxUint32 end, bool val) const
+{
+	wxUint32 base = 0;
+	for(size_t idx = 0; idx < Count() && start <= end; idx++) {
+		BitMLBuffer *item = &Item(idx);
+		wxUint32 size = (wxUint32)item->GetBitSize();
+		if (start < base + size) {
+			wxUint32 num = DiskBasicBitmapWords::Find(item->GetBuffer(), item->GetSize(), start - base, end - base, val, BITMAP_ORDER_MSB);
+			if (num != INVALID_GROUP_NUMBER) return base + num;
+			if (end < base + size) break;
+			start = base + size;
+		}
+		base += size;
+	}
+	return INVALID_GROUP_NUMBER;
+}
+
+/// 指定位置から同じ値が続く範囲の次の位置を返す
+/// @param[in] start 開始位置
+/// @param[in] end   終了位置(この位置を含む)
+/// @return 値が変わる位置 / 範囲の最後まで同じなら end + 1
+wxUint32 DiskBasicBitMLMap::FindRunEnd(wxUint32 start, wxUint32 end) const
+{
+	// マップの範囲外はリセットとみなす
+	wxUint32 bits = GetBitSize();
+	if (start >= bits) return end + 1;
+
+	bool val = DiskBasicBitMLMap::IsSet(start);
+	wxUint32 num = Find(start, end, !val);
+	if (num == INVALID_GROUP_NUMBER) {
+		num = (val && end >= bits ? bits : end + 1);
+	}
+	return num;
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 // FATエリア（セクタ）へのポインタを保持
@@ -216,11 +518,16 @@ DiskBasicFatBuffer::DiskBasicFatBuffer()
 {
 	size = 0;
 	buffer = NULL;
+	sector = NULL;
 }
-DiskBasicFatBuffer::DiskBasicFatBuffer(wxUint8 *newbuf, int newsize)
+/// @param[in] newbuf    バッファポインタ（セクタ内の開始ポインタ）
+/// @param[in] newsize   バッファサイズ
+/// @param[in] newsector バッファのあるセクタ
+DiskBasicFatBuffer::DiskBasicFatBuffer(wxUint8 *newbuf, int newsize, DiskImageSector *newsector)
 {
 	size = newsize;
 	buffer = newbuf;
+	sector = newsector;
 }
 /// バッファを指定コードで埋める
 /// @param[in] code コード
@@ -522,18 +829,39 @@ DiskBasicFatArea::DiskBasicFatArea()
 	: ArrayArrayDiskBasicFatBuffer()
 {
 	valid_count = Count();
+	m_decoded = NULL;
+	m_decoded_count = 0;
+	m_decode_type = FAT_DECODE_NONE;
+	m_decoded_disk = NULL;
+	m_decoded_layout_gen = 0;
+	m_decoded_data_gen = 0;
+	m_decoded_sum = 0;
+}
+DiskBasicFatArea::~DiskBasicFatArea()
+{
+	delete [] m_decoded;
 }
 /// コピーコンストラクタ
+/// @note 展開したFATはコピーしない
 DiskBasicFatArea::DiskBasicFatArea(const DiskBasicFatArea &src)
 	: ArrayArrayDiskBasicFatBuffer(src)
 {
 	valid_count = src.valid_count;
+	m_decoded = NULL;
+	m_decoded_count = 0;
+	m_decode_type = FAT_DECODE_NONE;
+	m_decoded_disk = NULL;
+	m_decoded_layout_gen = 0;
+	m_decoded_data_gen = 0;
+	m_decoded_sum = 0;
 }
 /// 代入
+/// @note 展開したFATはコピーしない
 DiskBasicFatArea &DiskBasicFatArea::operator=(const DiskBasicFatArea &src)
 {
 	ArrayArrayDiskBasicFatBuffer::operator=(src);
 	valid_count = src.valid_count;
+	ClearDecoded();
 	return *this;
 }
 /// クリア
@@ -541,6 +869,154 @@ void DiskBasicFatArea::Empty()
 {
 	ArrayArrayDiskBasicFatBuffer::Empty();
 	valid_count = 0;
+	ClearDecoded();
+}
+/// 最初のFATを展開する
+///
+/// セクタごとのバッファを毎回たどらなくて済むように、
+/// FATのエントリを配列に展開しておく。
+/// 書き込みは展開した配列とセクタバッファの両方に行う。
+/// セクタ編集などで他からFATのセクタを書き換えた時は、
+/// 各セクタの書き換え回数が変わるので展開し直す。
+/// @param[in] decode_type 展開形式 en_fat_decode_types
+void DiskBasicFatArea::Decode(int decode_type)
+{
+	ClearDecoded();
+	if (decode_type == FAT_DECODE_NONE || Count() == 0) return;
+
+	// セクタごとのバッファを連結する
+	DiskBasicFatBuffers *fatbufs = &Item(0);
+	size_t total = 0;
+	for(size_t i = 0; i < fatbufs->Count(); i++) {
+		total += fatbufs->Item(i).GetSize();
+	}
+	wxUint32 count = (wxUint32)(decode_type == FAT_DECODE_12LE ? total * 2 / 3 : total / 2);
+	if (count == 0) return;
+
+	wxUint8 *data = new wxUint8[total];
+	size_t pos = 0;
+	for(size_t i = 0; i < fatbufs->Count(); i++) {
+		DiskBasicFatBuffer *buf = &fatbufs->Item(i);
+		if (buf->GetBuffer()) {
+			memcpy(&data[pos], buf->GetBuffer(), buf->GetSize());
+		} else {
+			memset(&data[pos], 0, buf->GetSize());
+		}
+		pos += buf->GetSize();
+	}
+
+	m_decoded = new wxUint32[count];
+	m_decoded_count = count;
+	m_decode_type = decode_type;
+
+	// 展開元のセクタの書き換え回数を覚えておく
+	for(size_t i = 0; i < fatbufs->Count() && !m_decoded_disk; i++) {
+		DiskImageSector *sector = fatbufs->Item(i).GetSector();
+		DiskImageTrack *track = (sector ? sector->GetTrack() : NULL);
+		m_decoded_disk = (track ? track->GetDisk() : NULL);
+	}
+	if (m_decoded_disk) {
+		m_decoded_layout_gen = m_decoded_disk->GetLayoutGeneration();
+		m_decoded_data_gen = m_decoded_disk->GetDataGeneration();
+		m_decoded_sum = SumWriteGenerations();
+	}
+
+	if (decode_type == FAT_DECODE_12LE) {
+		for(wxUint32 n = 0; n < count; n++) {
+			size_t p = n * 3 / 2;
+			if (n & 1) {
+				m_decoded[n] = ((wxUint32)data[p] >> 4) | ((wxUint32)data[p+1] << 4);
+			} else {
+				m_decoded[n] = (wxUint32)data[p] | (((wxUint32)data[p+1] & 0x0f) << 8);
+			}
+		}
+	} else {
+		for(wxUint32 n = 0; n < count; n++) {
+			m_decoded[n] = (wxUint32)data[n * 2] | ((wxUint32)data[n * 2 + 1] << 8);
+		}
+	}
+
+	delete [] data;
+}
+/// 展開し直す
+///
+/// セクタバッファを直接書き換えたときに呼ぶ。
+void DiskBasicFatArea::Redecode()
+{
+	if (m_decode_type != FAT_DECODE_NONE) {
+		Decode(m_decode_type);
+	}
+}
+/// 展開したFATを破棄
+void DiskBasicFatArea::ClearDecoded()
+{
+	delete [] m_decoded;
+	m_decoded = NULL;
+	m_decoded_count = 0;
+	m_decode_type = FAT_DECODE_NONE;
+	m_decoded_disk = NULL;
+	m_decoded_layout_gen = 0;
+	m_decoded_data_gen = 0;
+	m_decoded_sum = 0;
+}
+/// 最初のFATのセクタの書き換え回数の合計
+/// @note 書き換え回数は増える一方なので、いずれかのセクタを書き換えると合計も変わる
+wxUint32 DiskBasicFatArea::SumWriteGenerations() const
+{
+	wxUint32 sum = 0;
+	if (Count() == 0) return sum;
+
+	const DiskBasicFatBuffers *fatbufs = &Item(0);
+	for(size_t i = 0; i < fatbufs->Count(); i++) {
+		const DiskImageSector *sector = fatbufs->Item(i).GetSector();
+		if (sector) sum += sector->GetWriteGeneration();
+	}
+	return sum;
+}
+/// 展開したFATが使えるか
+///
+/// ディスクのどこにも書き込みがなければセクタは調べない。
+/// @return false:展開していないか、FATのセクタが他で書き換えられた
+bool DiskBasicFatArea::IsDecodedValid() const
+{
+	if (!m_decoded) return false;
+	if (!m_decoded_disk) return true;
+	if (m_decoded_disk->GetLayoutGeneration() != m_decoded_layout_gen) {
+		// セクタが削除されているかもしれないので参照しない
+		return false;
+	}
+	if (m_decoded_disk->GetDataGeneration() == m_decoded_data_gen) return true;
+	return (SumWriteGenerations() == m_decoded_sum);
+}
+/// FATのセクタが他で書き換えられていたら展開し直す
+///
+/// FATのセクタ以外への書き込みなら覚えておいたディスクの世代だけ更新する。
+void DiskBasicFatArea::ValidateDecoded()
+{
+	if (!m_decoded || !m_decoded_disk) return;
+	if (m_decoded_disk->GetLayoutGeneration() != m_decoded_layout_gen) {
+		// セクタの並びが変わったら展開をやめてバッファから読む
+		ClearDecoded();
+		return;
+	}
+	if (m_decoded_disk->GetDataGeneration() == m_decoded_data_gen) return;
+	if (SumWriteGenerations() == m_decoded_sum) {
+		m_decoded_data_gen = m_decoded_disk->GetDataGeneration();
+		return;
+	}
+	Redecode();
+}
+/// 展開したFATを更新
+/// @param[in] idx  ミラーリング位置
+/// @param[in] pos  位置
+/// @param[in] val  値
+/// @param[in] mask 有効なビット
+void DiskBasicFatArea::SetDecoded(size_t idx, wxUint32 pos, wxUint32 val, wxUint32 mask)
+{
+	// 展開しているのは最初のFATのみ
+	if (idx == 0 && pos < m_decoded_count) {
+		m_decoded[pos] = (val & mask);
+	}
 }
 /// 追加
 /// @param[in] lItem   追加するアイテム
@@ -629,6 +1105,10 @@ wxUint32 DiskBasicFatArea::GetData12LE(size_t idx, wxUint32 pos) const
 	wxUint32 val = INVALID_GROUP_NUMBER;
 	if (idx >= Count()) return val;
 
+	if (idx == 0 && m_decode_type == FAT_DECODE_12LE && pos < m_decoded_count && IsDecodedValid()) {
+		return m_decoded[pos];
+	}
+
 	DiskBasicFatBuffers *bufs = &Item(idx);
 	val = bufs->GetData12LE(pos);
 	return val;
@@ -652,6 +1132,9 @@ void DiskBasicFatArea::SetData12LE(size_t idx, wxUint32 pos, wxUint32 val)
 
 	DiskBasicFatBuffers *bufs = &Item(idx);
 	bufs->SetData12LE(pos, val);
+	if (m_decode_type == FAT_DECODE_12LE) {
+		SetDecoded(idx, pos, val, 0xfff);
+	}
 }
 /// 16ビットデータ(リトルエンディアン)を返す
 /// @param[in] idx ミラーリング位置
@@ -662,6 +1145,10 @@ wxUint32 DiskBasicFatArea::GetData16LE(size_t idx, wxUint32 pos) const
 	wxUint32 val = INVALID_GROUP_NUMBER;
 	if (idx >= Count()) return val;
 
+	if (idx == 0 && m_decode_type == FAT_DECODE_16LE && pos < m_decoded_count && IsDecodedValid()) {
+		return m_decoded[pos];
+	}
+
 	DiskBasicFatBuffers *bufs = &Item(idx);
 	val = bufs->GetData16LE(pos);
 	return val;
@@ -685,6 +1172,9 @@ void DiskBasicFatArea::SetData16LE(size_t idx, wxUint32 pos, wxUint32 val)
 
 	DiskBasicFatBuffers *bufs = &Item(idx);
 	bufs->SetData16LE(pos, val);
+	if (m_decode_type == FAT_DECODE_16LE) {
+		SetDecoded(idx, pos, val, 0xffff);
+	}
 }
 /// 16ビットデータ(ビッグエンディアン)を返す
 /// @param[in] idx ミラーリング位置
@@ -801,7 +1291,7 @@ double DiskBasicFat::Assign(bool is_formatting)
 					buf += start_pos;
 					ssize -= start_pos;
 				}
-				DiskBasicFatBuffer fatbuf(buf, ssize);
+				DiskBasicFatBuffer fatbuf(buf, ssize, sector);
 				fatbufs.Add(fatbuf);
 			}
 			bufs.Add(fatbufs);
@@ -811,6 +1301,9 @@ double DiskBasicFat::Assign(bool is_formatting)
 		}
 
 		bufs.SetValidCount(vcount);
+
+		// 必要なら最初のFATを展開しておく
+		bufs.Decode(type->GetFatDecodeType());
 	}
 
 	if (valid_ratio >= 0.0) {
@@ -829,6 +1322,7 @@ void DiskBasicFat::Clear()
 	start_pos = 0;
 
 	bufs.Clear();
+	bufs.ClearDecoded();
 }
 /// FATエリアのアサインを解除
 void DiskBasicFat::Empty()
@@ -843,7 +1337,7 @@ wxUint8 DiskBasicFat::Get(int pos) const
 	wxUint8 code = 0;
 	DiskImageSector *sector = basic->GetSectorFromSectorPos(start);
 	if (sector) {
-		wxUint8 *buf = sector->GetSectorBuffer();
+		const wxUint8 *buf = sector->PeekSectorBuffer();
 		int size = sector->GetSectorBufferSize();
 		if (buf && pos < size) {
 			code = buf[pos];
@@ -869,6 +1363,7 @@ void DiskBasicFat::Set(int pos, wxUint8 code)
 		}
 		start_sector += size;
 	}
+	bufs.Redecode();
 }
 
 /// FAT領域の最初のセクタにデータを書く
@@ -884,6 +1379,7 @@ void DiskBasicFat::Copy(const wxUint8 *buf, size_t len)
 		}
 		start_sector += size;
 	}
+	bufs.Redecode();
 }
 
 /// FAT領域を指定コードで埋める
@@ -902,6 +1398,15 @@ void DiskBasicFat::Fill(wxUint8 code)
 		start_sector += size;
 		end_sector += size;
 	}
+	bufs.Redecode();
+}
+
+/// FAT領域を返す
+/// FATのセクタが他で書き換えられていたら展開し直してから返す
+DiskBasicFatArea *DiskBasicFat::GetDiskBasicFatArea()
+{
+	bufs.ValidateDecoded();
+	return &bufs;
 }
 
 /// FATバッファを返す
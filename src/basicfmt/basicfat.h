@@ -28,6 +28,13 @@ enum en_fat_availability {
 	FAT_AVAIL_NULLEND
 };
 
+/// @brief FATの展開形式 enum
+enum en_fat_decode_types {
+	FAT_DECODE_NONE = 0,
+	FAT_DECODE_12LE,
+	FAT_DECODE_16LE
+};
+
 /// @brief 使用状況テーブル
 class DiskBasicAvailabillity : public wxArrayInt
 {
@@ -45,6 +52,8 @@ public:
 	void EmptyInit();
 	/// @brief 追加
 	void Add(int val, int size, int group);
+	/// @brief 同じ値をまとめて追加
+	void Add(int val, int size, int group, size_t count);
 	/// @brief セット (Safety)
 	void Set(size_t idx, int val);
 	/// @brief ゲット (Safety)
@@ -61,6 +70,71 @@ public:
 
 //////////////////////////////////////////////////////////////////////
 
+/// @brief 空きグループの索引
+///
+/// グループを確保する間、空きをさがすたびにFATを走査しないように
+/// 空きグループをビットマップ(1:空き)で保持する。
+/// トラック単位の空き数も保持して空きのないトラックは読み飛ばす。
+class DiskBasicFreeGroupIndex
+{
+private:
+	wxUint32	*m_words;		///< ビットマップ
+	int			*m_unit_frees;	///< 単位ごとの空き数
+	wxUint32	 m_groups;		///< グループ数
+	int			 m_unit_groups;	///< 1単位(トラック)あたりのグループ数
+	int			 m_units;		///< 単位数
+
+	DiskBasicFreeGroupIndex(const DiskBasicFreeGroupIndex &) {}
+	DiskBasicFreeGroupIndex &operator=(const DiskBasicFreeGroupIndex &) { return *this; }
+
+public:
+	DiskBasicFreeGroupIndex();
+	~DiskBasicFreeGroupIndex();
+
+	/// @brief 作成 すべて使用済みにする
+	void		Create(wxUint32 groups, int unit_groups);
+	/// @brief 削除
+	void		Clear();
+	/// @brief 作成済みか
+	bool		IsValid() const { return (m_words != NULL); }
+	/// @brief 空きかどうかを設定
+	void		SetFree(wxUint32 num, bool val);
+	/// @brief 空きか
+	bool		IsFree(wxUint32 num) const;
+	/// @brief 1単位あたりのグループ数
+	int			GetUnitGroups() const { return m_unit_groups; }
+	/// @brief 単位内の空き数
+	int			GetUnitFrees(int unit) const;
+	/// @brief 範囲内で最初の空きをさがす
+	wxUint32	FindFree(wxUint32 start, wxUint32 end) const;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+/// @brief ビットマップ内のビットの並び enum
+enum en_bitmap_orders {
+	BITMAP_ORDER_MSB = 0,	///< バイト内のMSBから
+	BITMAP_ORDER_LSB,		///< バイト内のLSBから
+	BITMAP_ORDER_LSB32BE	///< ビッグエンディアン32ビット値のLSBから
+};
+
+/// @brief ビットマップを64ビット単位で処理する
+///
+/// セクタ上のビットマップを8バイトずつ並びをそろえた64ビット値として読み、
+/// ビット数の計数や検索を1ワードずつ行う。
+class DiskBasicBitmapWords
+{
+public:
+	/// @brief 64ビット値を読む
+	static wxUint64	Load(const wxUint8 *buffer, size_t size, size_t word_pos, int order);
+	/// @brief 範囲内で指定値のビット数を返す
+	static wxUint32	Count(const wxUint8 *buffer, size_t size, wxUint32 start, wxUint32 end, bool val, int order);
+	/// @brief 範囲内で最初に指定値となるビット位置を返す
+	static wxUint32	Find(const wxUint8 *buffer, size_t size, wxUint32 start, wxUint32 end, bool val, int order);
+};
+
+//////////////////////////////////////////////////////////////////////
+
 /// @brief ビット ON/OFF バッファ １つ
 ///
 /// @sa DiskBasicBitMLMap
@@ -109,6 +183,15 @@ public:
 	virtual bool IsSet(wxUint32 group_num) const;
 	/// @brief 指定位置からバッファ内の位置を計算
 	bool GetPosInMap(wxUint32 group_num, size_t &idx, wxUint32 &pos, wxUint32 &bit) const;
+
+	/// @brief サイズ(ビット数)を返す
+	wxUint32 GetBitSize() const;
+	/// @brief 範囲内で指定値のビット数を返す
+	wxUint32 CountBits(wxUint32 start, wxUint32 end, bool val) const;
+	/// @brief 範囲内で最初に指定値となる位置を返す
+	wxUint32 Find(wxUint32 start, wxUint32 end, bool val) const;
+	/// @brief 指定位置から同じ値が続く範囲の次の位置を返す
+	wxUint32 FindRunEnd(wxUint32 start, wxUint32 end) const;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -119,13 +202,16 @@ class DiskBasicFatBuffer
 private:
 	size_t   size;		///< バッファサイズ
 	wxUint8 *buffer;	///< バッファポインタ（セクタ内の開始ポインタ）
+	DiskImageSector *sector;	///< バッファのあるセクタ
 
 public:
 	DiskBasicFatBuffer();
-	DiskBasicFatBuffer(wxUint8 *newbuf, int newsize);
+	DiskBasicFatBuffer(wxUint8 *newbuf, int newsize, DiskImageSector *newsector = NULL);
 	~DiskBasicFatBuffer() {}
 	/// @brief バッファポインタを返す
 	wxUint8 *GetBuffer() const { return buffer; }
+	/// @brief バッファのあるセクタを返す
+	DiskImageSector *GetSector() const { return sector; }
 	/// @brief バッファサイズを返す
 	size_t   GetSize() const { return size; }
 	/// @brief バッファを指定コードで埋める
@@ -197,8 +283,24 @@ class DiskBasicFatArea : public ArrayArrayDiskBasicFatBuffer
 private:
 	size_t	valid_count;	///< 有効なバッファ数
 
+	wxUint32	*m_decoded;			///< 展開したFAT(最初のFATのみ)
+	wxUint32	 m_decoded_count;	///< 展開したエントリ数
+	int			 m_decode_type;		///< 展開形式 en_fat_decode_types
+	DiskImageDisk *m_decoded_disk;		///< 展開元のディスク
+	wxUint32	 m_decoded_layout_gen;	///< 展開時のディスクのトラックやセクタの並びの世代
+	wxUint32	 m_decoded_data_gen;	///< 展開時のディスクのデータの世代
+	wxUint32	 m_decoded_sum;			///< 展開時のFATセクタの書き換え回数の合計
+
+	/// @brief 展開したFATを更新
+	void		SetDecoded(size_t idx, wxUint32 pos, wxUint32 val, wxUint32 mask);
+	/// @brief 最初のFATのセクタの書き換え回数の合計
+	wxUint32	SumWriteGenerations() const;
+	/// @brief 展開したFATが使えるか
+	bool		IsDecodedValid() const;
+
 public:
 	DiskBasicFatArea();
+	~DiskBasicFatArea();
 	/// @brief コピーコンストラクタ
 	DiskBasicFatArea(const DiskBasicFatArea &src);
 	/// @brief 代入
@@ -212,6 +314,17 @@ public:
 	/// @brief 有効なバッファ数を返す
 	size_t	GetValidCount() const { return valid_count; }
 
+	/// @brief 最初のFATを展開する
+	void	Decode(int decode_type);
+	/// @brief 展開し直す
+	void	Redecode();
+	/// @brief 展開したFATを破棄
+	void	ClearDecoded();
+	/// @brief FATのセクタが他で書き換えられていたら展開し直す
+	void	ValidateDecoded();
+	/// @brief 展開形式を返す
+	int		GetDecodeType() const { return m_decode_type; }
+
 	/// @brief 8ビットデータを返す
 	wxUint32 GetData8(size_t idx, wxUint32 pos) const;
 	/// @brief 8ビットデータをセット
@@ -273,6 +386,8 @@ public:
 	DiskBasicFat(DiskBasic *basic);
 	~DiskBasicFat();
 
+	/// @brief 所属するDISK BASICを設定
+	void SetBasic(DiskBasic *val) { basic = val; }
 	/// @brief FAT領域をアサイン
 	double Assign(bool is_formatting);
 	/// @brief FAT領域をクリア
@@ -290,7 +405,7 @@ public:
 	void Fill(wxUint8 code);
 
 	/// @brief FAT領域を返す
-	DiskBasicFatArea	 *GetDiskBasicFatArea() { return &bufs; }
+	DiskBasicFatArea	 *GetDiskBasicFatArea();
 	/// @brief FATバッファを返す
 	DiskBasicFatBuffers	 *GetDiskBasicFatBuffers(size_t idx);
 	/// @brief FATバッファ（セクタ）を返す
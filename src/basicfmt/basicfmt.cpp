@@ -11,6 +11,7 @@
 #include <wx/numformatter.h>
 #include <wx/datetime.h>
 #include "../diskimg/diskimage.h"
+#include "../diskimg/diskdetectcache.h"
 #include "basictemplate.h"
 #include "basicfat.h"
 #include "basicdir.h"
@@ -49,6 +50,9 @@
 #include "basictype_hfs.h"
 #include "../logging.h"
 #include "../utils.h"
+#if wxUSE_THREADS
+#include <wx/thread.h>
+#endif
 
 
 #ifdef DeleteFile
@@ -161,6 +165,64 @@ void DiskBasics::ClearParseAndAssign(int idx)
 	}
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+//
+//
+/// DISK BASIC判定の候補
+class DiskBasicParseCandidate
+{
+public:
+	int						num;			///< BASIC種類一覧の位置
+	const DiskBasicParam	*param;			///< パラメータ
+	DiskBasic				*basic;			///< 解析に使うインスタンス
+	int						probe;			///< 簡易判定の結果 DiskBasicType::en_probe_results
+	double					valid_ratio;	///< 解析結果
+	wxString				log;			///< 解析中のログ 候補の順に出力する
+
+	DiskBasicParseCandidate(int n_num, const DiskBasicParam *n_param, DiskBasic *n_basic)
+	{
+		num = n_num;
+		param = n_param;
+		basic = n_basic;
+		probe = DiskBasicType::PROBE_UNKNOWN;
+		valid_ratio = -1.0;
+	}
+	~DiskBasicParseCandidate()
+	{
+		delete basic;
+	}
+};
+
+#if wxUSE_THREADS
+/// DISK BASIC判定の候補を解析するスレッド
+class DiskBasicParseWorker : public wxThread
+{
+private:
+	DiskImageDisk		*p_disk;
+	wxArrayPtrVoid		*p_candidates;
+	size_t				*p_next;
+	wxCriticalSection	*p_lock;
+	bool				 m_is_formatting;
+
+	ExitCode Entry() {
+		DiskBasic::ParseCandidatesOnThread(p_disk, p_candidates, p_next, p_lock, m_is_formatting);
+		return 0;
+	}
+
+public:
+	DiskBasicParseWorker(DiskImageDisk *disk, wxArrayPtrVoid *candidates, size_t *next, wxCriticalSection *lock, bool is_formatting)
+		: wxThread(wxTHREAD_JOINABLE)
+	{
+		p_disk = disk;
+		p_candidates = candidates;
+		p_next = next;
+		p_lock = lock;
+		m_is_formatting = is_formatting;
+	}
+};
+#endif
+
 //////////////////////////////////////////////////////////////////////
 //
 //
@@ -313,6 +375,46 @@ void DiskBasic::CreateType()
 	}
 }
 
+/// 解析前にディスクが指定のDISK BASICである見込みを簡易判定
+///
+/// 確実にパラメータエリアの解析で失敗するものだけを除外する。
+/// 判定方法を持たない種類は不明とする。
+/// @param [in] newdisk : 新しいディスク
+/// @param [in] match   : DISK BASICのパラメータ
+/// @return DiskBasicType::en_probe_results
+int DiskBasic::ProbeType(DiskImageDisk *newdisk, const DiskBasicParam *match)
+{
+	const DiskBasicFormat *fmt = match->GetFormatType();
+	if (!fmt) return DiskBasicType::PROBE_UNKNOWN;
+
+	// 反転データはセクタを直接見ても判定できない
+	if (match->IsDataInverted()) return DiskBasicType::PROBE_UNKNOWN;
+
+	int probe = DiskBasicType::PROBE_UNKNOWN;
+	switch(fmt->GetTypeNumber()) {
+	case FORMAT_TYPE_MSDOS:
+	case FORMAT_TYPE_LOSA:
+	case FORMAT_TYPE_CDOS2:
+		probe = DiskBasicTypeMSDOS::ProbeParamOnDisk(newdisk, *match);
+		break;
+	case FORMAT_TYPE_OS9:
+		probe = DiskBasicTypeOS9::ProbeParamOnDisk(newdisk, *match);
+		break;
+	case FORMAT_TYPE_MACHFS:
+		probe = DiskBasicTypeHFS::ProbeParamOnDisk(newdisk, *match);
+		break;
+	case FORMAT_TYPE_PRODOS:
+		probe = DiskBasicTypeProDOS::ProbeParamOnDisk(newdisk, *match);
+		break;
+	case FORMAT_TYPE_AMIGA:
+		probe = DiskBasicTypeAmiga::ProbeParamOnDisk(newdisk, *match);
+		break;
+	default:
+		break;
+	}
+	return probe;
+}
+
 /// 最も高い値のインデックスを返す
 int DiskBasic::MaxRatio(wxArrayDouble &values)
 {
@@ -346,6 +448,7 @@ int DiskBasic::ParseBasic(DiskImageDisk *newdisk, int newside, const DiskBasicPa
 
 	p_disk = newdisk;
 	m_formatted = false;
+	file_map.Empty();
 
 	myLog.SetInfo(wxT("Parsing Disk #%d ..."), newdisk->GetNumber());
 
@@ -354,7 +457,7 @@ int DiskBasic::ParseBasic(DiskImageDisk *newdisk, int newside, const DiskBasicPa
 	// 新しいディスクにあるBASIC種類一覧
 	DiskParamNames types = newdisk->GetBasicTypes();
 
-	DiskBasicParamPtrs valid_params;
+	wxArrayPtrVoid     valid_candidates;
 	wxArrayDouble      valid_ratios;
 
 	double valid_ratio = 0.0;
@@ -374,31 +477,125 @@ int DiskBasic::ParseBasic(DiskImageDisk *newdisk, int newside, const DiskBasicPa
 			return errinfo.GetValid();
 		}
 
+		// 候補ごとに別のインスタンスを用意する
+		wxArrayPtrVoid candidates;
 		for(size_t n=0; n<types.Count(); n++) {
 			match = gDiskBasicTemplates.FindType(hint, types.Item(n).GetName());
 			if (match) {
-				// フォーマットされているか？
-				myLog.SetInfo(wxString::Format(wxT("Parsing format #%d: "), (int)n) + match->GetBasicTypeName());
-				valid_ratio = ParseFormattedDisk(newdisk, match, is_formatting);
-				myLog.SetInfo(wxT("  Result => %.2f"), valid_ratio);
-				if (valid_ratio >= 0.0) {
-					// 候補にする
-					valid_params.Add(match);
-					valid_ratios.Add(valid_ratio);
+				candidates.Add(new DiskBasicParseCandidate((int)n, match, NewBasicForParse(newdisk, newside)));
+			}
+		}
+
+		DiskBasicParseCandidate *decided = NULL;
+		bool decided_valid = false;
+
+		// 同じ内容のディスクを判定したことがあればその候補だけ解析する
+		wxString cache_key;
+		wxString cached_name;
+		double cached_ratio = 0.0;
+		if (!is_formatting) {
+			wxArrayInt managed_tracks;
+			for(size_t i=0; i<candidates.Count(); i++) {
+				DiskBasicParseCandidate *candidate = (DiskBasicParseCandidate *)candidates.Item(i);
+				int track_number = candidate->param->GetManagedTrackNumber();
+				if (track_number >= 0 && managed_tracks.Index(track_number) == wxNOT_FOUND) {
+					managed_tracks.Add(track_number);
 				}
 			}
+			cache_key = DiskDetectCache::MakeBasicKey(newdisk, newside, managed_tracks);
+		}
+		if (gDiskDetectCache.FindBasic(cache_key, cached_name, cached_ratio)) {
+			for(size_t i=0; i<candidates.Count(); i++) {
+				DiskBasicParseCandidate *candidate = (DiskBasicParseCandidate *)candidates.Item(i);
+				if (candidate->param->GetBasicTypeName() != cached_name) continue;
+
+				myLog.SetInfo(wxString::Format(wxT("Parsing format #%d (cached): "), candidate->num) + cached_name);
+				candidate->valid_ratio = candidate->basic->ParseFormattedDisk(newdisk, candidate->param, is_formatting);
+				myLog.SetInfo(wxT("  Result => %.2f"), candidate->valid_ratio);
+				double diff = candidate->valid_ratio - cached_ratio;
+				if (candidate->valid_ratio >= 0.0 && diff < 0.00001 && diff > -0.00001) {
+					// 前回と同じ結果になった
+					decided = candidate;
+					decided_valid = true;
+					myLog.SetInfo(wxT("Decided format: ") + cached_name);
+				} else {
+					// 一致しないので判定をやり直す
+					myLog.SetInfo(wxT("  Cache mismatched."));
+					gDiskDetectCache.RemoveBasic(cache_key);
+					delete candidate->basic;
+					candidate->basic = NewBasicForParse(newdisk, newside);
+					candidate->valid_ratio = -1.0;
+				}
+				break;
+			}
 		}
 
-		errinfo.Clear();
-		if (valid_params.Count() > 0) {
-			// それらしいものを候補とする
-			int idx = MaxRatio(valid_ratios);
-			if (idx < 0) idx = 0;
-			match = valid_params.Item(idx);
-			// 再度チェックする
-			myLog.SetInfo(wxT("Decided format: ") + match->GetBasicTypeName());
-			valid_ratio = ParseFormattedDisk(newdisk, match, is_formatting);
-			myLog.SetInfo(wxT("  Result => %.2f"), valid_ratio);
+		if (!decided) {
+			// 簡易判定で該当しないものは解析しない
+			// 見込みのあるものから順に解析する
+			wxArrayPtrVoid parsing;
+			if (!is_formatting) {
+				for(size_t i=0; i<candidates.Count(); i++) {
+					DiskBasicParseCandidate *candidate = (DiskBasicParseCandidate *)candidates.Item(i);
+					// 解析時のログと一緒に出力する
+					myLog.BeginCapture(&candidate->log);
+					candidate->probe = ProbeType(newdisk, candidate->param);
+					myLog.EndCapture();
+				}
+			}
+			for(int probe = DiskBasicType::PROBE_LIKELY; probe > DiskBasicType::PROBE_NO; probe--) {
+				for(size_t i=0; i<candidates.Count(); i++) {
+					DiskBasicParseCandidate *candidate = (DiskBasicParseCandidate *)candidates.Item(i);
+					if (candidate->probe == probe) parsing.Add(candidate);
+				}
+			}
+
+			// フォーマットされているか？ 並列で解析する
+			ParseCandidates(newdisk, parsing, is_formatting);
+
+			for(size_t i=0; i<candidates.Count(); i++) {
+				DiskBasicParseCandidate *candidate = (DiskBasicParseCandidate *)candidates.Item(i);
+				myLog.SetInfo(wxString::Format(wxT("Parsing format #%d: "), candidate->num) + candidate->param->GetBasicTypeName());
+				myLog.WriteCaptured(candidate->log);
+				if (candidate->probe == DiskBasicType::PROBE_NO) {
+					myLog.SetInfo(wxT("  Skipped by probe."));
+				}
+				myLog.SetInfo(wxT("  Result => %.2f"), candidate->valid_ratio);
+				if (candidate->valid_ratio >= 0.0) {
+					// 候補にする
+					valid_candidates.Add(candidate);
+					valid_ratios.Add(candidate->valid_ratio);
+				}
+				decided = candidate;
+			}
+
+			if (valid_candidates.Count() > 0) {
+				// それらしいものを候補とする
+				int idx = MaxRatio(valid_ratios);
+				if (idx < 0) idx = 0;
+				decided = (DiskBasicParseCandidate *)valid_candidates.Item(idx);
+				myLog.SetInfo(wxT("Decided format: ") + decided->param->GetBasicTypeName());
+				myLog.SetInfo(wxT("  Result => %.2f"), decided->valid_ratio);
+				decided_valid = true;
+
+				// 判定結果を覚えておく
+				gDiskDetectCache.SetBasic(cache_key, decided->param->GetBasicTypeName(), decided->valid_ratio);
+			}
+		}
+		if (decided) {
+			if (decided->probe == DiskBasicType::PROBE_NO) {
+				// 解析していないので引き継ぐ前に解析しておく
+				decided->valid_ratio = decided->basic->ParseFormattedDisk(newdisk, decided->param, is_formatting);
+			}
+			// 解析したインスタンスの状態を引き継ぐ
+			valid_ratio = decided->valid_ratio;
+			TakeOver(*decided->basic);
+			if (!decided_valid) {
+				errinfo.Clear();
+			}
+		}
+		for(size_t i=0; i<candidates.Count(); i++) {
+			delete (DiskBasicParseCandidate *)candidates.Item(i);
 		}
 	} else {
 		// すでにフォーマット済み
@@ -487,10 +684,116 @@ double DiskBasic::ParseFormattedDisk(DiskImageDisk *newdisk, const DiskBasicPara
 	return valid_ratio;
 }
 
+/// 候補のDISK BASICでフォーマットされているかを並列で解析する
+/// @param [in] newdisk           : 新しいディスク
+/// @param [in,out] candidates    : 候補 DiskBasicParseCandidate の配列
+/// @param [in] is_formatting     : フォーマット実行時true
+void DiskBasic::ParseCandidates(DiskImageDisk *newdisk, wxArrayPtrVoid &candidates, bool is_formatting)
+{
+	size_t next = 0;
+	wxCriticalSection lock;
+#if wxUSE_THREADS
+	int threads = wxThread::GetCPUCount();
+	if (threads > (int)candidates.Count()) threads = (int)candidates.Count();
+
+	// 各スレッドからはディスクを参照のみ行うので検索用インデックスは先に作っておく
+	if (threads > 1) newdisk->PrepareIndexes();
+
+	// 自スレッドでも解析するので一つ少なく作る
+	wxArrayPtrVoid workers;
+	for(int i = 1; i < threads; i++) {
+		DiskBasicParseWorker *worker = new DiskBasicParseWorker(newdisk, &candidates, &next, &lock, is_formatting);
+		if (worker->Run() != wxTHREAD_NO_ERROR) {
+			delete worker;
+			break;
+		}
+		workers.Add(worker);
+	}
+#endif
+	ParseCandidatesOnThread(newdisk, &candidates, &next, &lock, is_formatting);
+#if wxUSE_THREADS
+	for(size_t i = 0; i < workers.Count(); i++) {
+		DiskBasicParseWorker *worker = (DiskBasicParseWorker *)workers.Item(i);
+		worker->Wait();
+		delete worker;
+	}
+#endif
+}
+
+/// 未解析の候補を順に取り出して解析する
+/// @param [in] newdisk           : 新しいディスク
+/// @param [in,out] candidates    : 候補 DiskBasicParseCandidate の配列
+/// @param [in,out] next          : 次に解析する候補の位置
+/// @param [in] lock              : nextの排他用
+/// @param [in] is_formatting     : フォーマット実行時true
+void DiskBasic::ParseCandidatesOnThread(DiskImageDisk *newdisk, wxArrayPtrVoid *candidates, size_t *next, wxCriticalSection *lock, bool is_formatting)
+{
+	for(;;) {
+		size_t idx;
+		{
+			wxCriticalSectionLocker locker(*lock);
+			idx = (*next)++;
+		}
+		if (idx >= candidates->Count()) break;
+
+		DiskBasicParseCandidate *candidate = (DiskBasicParseCandidate *)candidates->Item(idx);
+		// 他のスレッドのログと混ざらないように溜めておく
+		myLog.BeginCapture(&candidate->log);
+		candidate->valid_ratio = candidate->basic->ParseFormattedDisk(newdisk, candidate->param, is_formatting);
+		myLog.EndCapture();
+	}
+}
+
+/// 候補の解析に使うインスタンスを作成する
+/// @param [in] newdisk : 新しいディスク
+/// @param [in] newside : サイド番号
+/// @return 作成したインスタンス
+DiskBasic *DiskBasic::NewBasicForParse(DiskImageDisk *newdisk, int newside) const
+{
+	DiskBasic *basic = new DiskBasic();
+	basic->p_disk = newdisk;
+	basic->selected_side = newside;
+	basic->m_forcely = m_forcely;
+	basic->SetCharCode(char_code);
+	return basic;
+}
+
+/// 解析済みの候補の状態を引き継ぐ
+/// FATとTYPEは候補のものと入れ替える
+/// @param [in,out] src : 解析した候補
+void DiskBasic::TakeOver(DiskBasic &src)
+{
+	SetBasicParam(src);
+	SetDiskParam(src);
+
+	DiskBasicFat *n_fat = src.fat;
+	src.fat = fat;
+	fat = n_fat;
+	DiskBasicType *n_type = src.type;
+	src.type = type;
+	type = n_type;
+
+	// 入れ替えたクラスの参照先を直す
+	fat->SetBasic(this);
+	dir->SetFat(fat);
+	dir->SetFormatType(GetFormatType());
+	if (type) type->SetBasic(this, dir);
+
+	src.fat->SetBasic(&src);
+	src.dir->SetFat(src.fat);
+	if (src.type) src.type->SetBasic(&src, src.dir);
+
+	m_formatted = src.m_formatted;
+	data_start_sector = src.data_start_sector;
+	skipped_track = src.skipped_track;
+	errinfo = src.errinfo;
+}
+
 /// パラメータをクリア
 void DiskBasic::Clear()
 {
 	p_disk = NULL;
+	file_map.Empty();
 	m_formatted = false;
 	m_parsed = false;
 	m_assigned = false;
@@ -697,6 +1000,7 @@ void DiskBasic::ClearParseAndAssign(bool forcely)
 	m_parsed = false;
 	m_assigned = false;
 	m_forcely = forcely;
+	file_map.Empty();
 	dir->ReleaseRoot(type);
 	dir->SetCurrentAsRoot();
 }
@@ -722,6 +1026,7 @@ bool DiskBasic::LoadFile(int item_number, const wxString &dstpath)
 }
 
 /// 指定したディレクトリアイテムのファイルをロード
+/// @note 途中で失敗した時は書きかけの出力先ファイルを削除する
 /// @param [in] item ディレクトリのアイテム
 /// @param [in] dstpath 出力先パス
 bool DiskBasic::LoadFile(DiskBasicDirItem *item, const wxString &dstpath)
@@ -731,14 +1036,25 @@ bool DiskBasic::LoadFile(DiskBasicDirItem *item, const wxString &dstpath)
 		errinfo.SetError(DiskBasicError::ERR_CANNOT_EXPORT);
 		return false;
 	}
-	return LoadFile(item, file);
+	bool sts = LoadFile(item, file);
+	if (!sts) {
+		file.Close();
+		wxRemoveFile(dstpath);
+	}
+	return sts;
 }
 
 /// 指定したストリームにファイルをロード
+/// @note 変換不要な形式は直接出力するので、途中で失敗した時はそこまでのデータがストリームに残る
 /// @param [in]     item    ディレクトリのアイテム
 /// @param [in,out] ostream 出力先ストリーム
 bool DiskBasic::LoadFile(DiskBasicDirItem *item, wxOutputStream &ostream)
 {
+	if (!type->NeedConvertDataForLoad(item)) {
+		// 変換不要ならディスクイメージから直接出力する
+		return LoadData(item, ostream);
+	}
+
 	// ディスクイメージからデータを取り出す
 	wxMemoryOutputStream otemp;
 	bool sts = LoadData(item, otemp);
@@ -830,7 +1146,7 @@ int DiskBasic::AccessUnitData(int fileunit_num, DiskBasicDirItem *item, wxInputS
 
 	int track_num = 0;
 	int side_num = 0;
-	int sector_start = 0;
+	int sector_num = 0;
 	int sector_end = 0;
 	int rc = 0;
 
@@ -852,50 +1168,55 @@ int DiskBasic::AccessUnitData(int fileunit_num, DiskBasicDirItem *item, wxInputS
 		return -1;
 	}
 
-	int gidx_end = (int)gitems.Count() - 1;
-	for(int gidx = 0; gidx <= gidx_end && remain > 0 && rc == 0; gidx++) {
-		DiskBasicGroupItem *gitem = &gitems.Item(gidx);
+	// グループからセクタ位置の一覧を得る 前回と同じグループなら再計算しない
+	if (!file_map.IsMadeFrom(p_disk, gitems)) {
+		file_map.Make(p_disk, gitems);
+	}
+
+	int error_gidx = -1;
+	for(size_t midx = 0; midx < file_map.Count() && remain > 0; midx++) {
+		const DiskBasicFileMapItem *mitem = &file_map.Item(midx);
+		// セクタがない時はそのグループの残りまで処理する
+		if (rc != 0 && mitem->group_idx != error_gidx) break;
+
+		DiskBasicGroupItem *gitem = &gitems.Item(mitem->group_idx);
 		track_num = gitem->track;
 		side_num = gitem->side;
-		sector_start = gitem->sector_start;
-		sector_end = gitem->sector_end;
-		DiskImageTrack *track = p_disk->GetTrack(track_num, side_num);
-		if (!track) {
+		sector_num = mitem->sector_num;
+		sector_end = mitem->sector_end;
+		if (mitem->no_track) {
 			// トラックがない！
 			errinfo.SetError(DiskBasicError::ERRV_NO_TRACK, gitem->group, track_num, side_num);
 			rc = -1;
 			break;
 		}
-
-		for(int sector_num = sector_start; sector_num <= sector_end && remain > 0; sector_num++) {
-			DiskImageSector *sector = track->GetSector(sector_num);
-			if (!sector) {
-				// セクタがない！
-				errinfo.SetError(DiskBasicError::ERRV_NO_SECTOR, gitem->group, track_num, side_num, sector_num);
+		DiskImageSector *sector = mitem->sector;
+		if (!sector) {
+			// セクタがない！
+			errinfo.SetError(DiskBasicError::ERRV_NO_SECTOR, gitem->group, track_num, side_num, sector_num);
+			rc = -1;
+			error_gidx = mitem->group_idx;
+			continue;
+		}
+		int bufsize = mitem->size;
+		// 読み込み/ベリファイのみなので書き込み用のバッファは使わない
+		const wxUint8 *buf = sector->PeekSectorBuffer(mitem->offset);
+
+		// データの読み込み
+		bufsize = type->AccessFile(fileunit_num, item, istream, ostream, buf, bufsize, remain, sector_num, sector_end);
+		if (bufsize < 0) {
+			if (bufsize == -2) {
+				// セクタがおかしいぞ
+				errinfo.SetError(DiskBasicError::ERRV_INVALID_SECTOR, gitem->group, track_num, side_num, sector_num, bufsize);
 				rc = -1;
-				continue;
-			}
-			int bufsize = sector->GetSectorSize();
-			bufsize /= gitem->div_nums;
-			wxUint8 *buf = sector->GetSectorBuffer();
-			buf += (bufsize * gitem->div_num);
-
-			// データの読み込み
-			bufsize = type->AccessFile(fileunit_num, item, istream, ostream, buf, bufsize, remain, sector_num, sector_end);
-			if (bufsize < 0) {
-				if (bufsize == -2) {
-					// セクタがおかしいぞ
-					errinfo.SetError(DiskBasicError::ERRV_INVALID_SECTOR, gitem->group, track_num, side_num, sector_num, bufsize);
-					rc = -1;
-				} else {
-					// データが異なる
-					errinfo.SetError(DiskBasicError::ERRV_VERIFY_FILE, gitem->group, track_num, side_num, sector_num);
-					rc = 1;
-				}
-				break;
+			} else {
+				// データが異なる
+				errinfo.SetError(DiskBasicError::ERRV_VERIFY_FILE, gitem->group, track_num, side_num, sector_num);
+				rc = 1;
 			}
-			remain -= bufsize;
+			break;
 		}
+		remain -= bufsize;
 	}
 
 	if (ostream) osize = ostream->TellO() - osize;
@@ -1117,6 +1438,8 @@ bool DiskBasic::SaveFile(wxInputStream &istream, DiskBasicDirItem *dir_item, Dis
 		item->SetModify();
 		// グループ数を計算
 		item->CalcFileSize();
+		// ファイル名索引に反映
+		dir_item->UpdateNameIndex(item);
 
 		// ベリファイ
 		int sts = VerifyData(item, *itemp);
@@ -1321,6 +1644,10 @@ bool DiskBasic::DeleteFile(DiskBasicDirItem *item, const DiskBasicGroups &group_
 		return false;
 	}
 
+	// 削除でディレクトリ内の並びが変わる機種があるので索引は作り直す
+	DiskBasicDirItem *parent = item->GetParent();
+	if (parent) parent->InvalidateNameIndex();
+
 	// FATエントリを削除
 	type->DeleteGroups(group_items);
 
@@ -1395,6 +1722,10 @@ bool DiskBasic::RenameFile(DiskBasicDirItem *item, const wxString &newname)
 	// ファイル名を更新した後の個別処理
 	type->AdditionalProcessOnRenamedFile(item);
 
+	// ファイル名索引に反映
+	DiskBasicDirItem *parent = item->GetParent();
+	if (parent) parent->UpdateNameIndex(item);
+
 	return true;
 }
 
@@ -1447,6 +1778,10 @@ bool DiskBasic::ChangeAttr(DiskBasicDirItem *item, DiskBasicDirItemAttr &attr)
 	// 属性変更後の個別処理
 	type->AdditionalProcessOnChangedAttr(item);
 
+	// ファイル名索引に反映
+	DiskBasicDirItem *parent = item->GetParent();
+	if (parent) parent->UpdateNameIndex(item);
+
 	return true;
 }
 
@@ -1497,6 +1832,7 @@ int DiskBasic::FormatDisk(const DiskBasicIdentifiedData &data)
 	m_parsed = true;
 	m_assigned = false;
 	m_forcely = false;
+	file_map.Empty();
 
 	bool rc = true;
 	// セクタを埋める
@@ -1528,6 +1864,8 @@ int DiskBasic::FormatDisk(const DiskBasicIdentifiedData &data)
 			type->FillSector(track, sector);
 		}
 	}
+	// セクタを直接埋めたのでFATを展開し直す
+	fat->GetDiskBasicFatArea()->Redecode();
 
 	// 初期データをセット
 	if (!type->AdditionalProcessOnFormatted(data)) {
@@ -1742,6 +2080,9 @@ int DiskBasic::MakeDirectory(DiskBasicDirItem *dir_item, const wxString &filenam
 	// ディレクトリ作成後の個別処理
 	type->AdditionalProcessOnMadeDirectory(item, group_items, dir_item);
 
+	// ファイル名索引に反映
+	dir_item->UpdateNameIndex(item);
+
 	// グループ数を計算
 	item->CalcFileSize();
 	// 空きサイズを計算
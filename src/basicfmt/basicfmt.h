@@ -33,6 +33,7 @@ class DiskBasicDirItems;
 class DiskBasicDirItemAttr;
 class DiskBasicGroups;
 class AttrControls;
+class wxCriticalSection;
 
 //////////////////////////////////////////////////////////////////////
 
@@ -123,12 +124,24 @@ private:
 
 	DiskBasicError errinfo;				///< エラー情報保存用
 
+	DiskBasicFileMap file_map;			///< 最後にアクセスしたファイルのセクタ位置
+
 	/// BASIC種類を設定
 	void			CreateType();
+	/// 解析前にディスクが指定のDISK BASICである見込みを簡易判定
+	static int		ProbeType(DiskImageDisk *newdisk, const DiskBasicParam *match);
 	/// 指定のDISK BASICでフォーマットされているかを解析＆チェック
 	double			ParseFormattedDisk(DiskImageDisk *newdisk, const DiskBasicParam *match, bool is_formatting); 
 
 	int				MaxRatio(wxArrayDouble &values);
+	/// 候補のDISK BASICでフォーマットされているかを並列で解析する
+	static void		ParseCandidates(DiskImageDisk *newdisk, wxArrayPtrVoid &candidates, bool is_formatting);
+	/// 未解析の候補を順に取り出して解析する
+	static void		ParseCandidatesOnThread(DiskImageDisk *newdisk, wxArrayPtrVoid *candidates, size_t *next, wxCriticalSection *lock, bool is_formatting);
+	/// 候補の解析に使うインスタンスを作成する
+	DiskBasic		*NewBasicForParse(DiskImageDisk *newdisk, int newside) const;
+	/// 解析済みの候補の状態を引き継ぐ
+	void			TakeOver(DiskBasic &src);
 
 public:
 	DiskBasic();
@@ -390,6 +403,10 @@ public:
 	/// エラーメッセージをクリア
 	void			ClearErrorMessage();
 	//@}
+
+#if wxUSE_THREADS
+	friend class DiskBasicParseWorker;
+#endif
 };
 
 WX_DEFINE_ARRAY(DiskBasic *, ArrayOfDiskBasic);
@@ -8,6 +8,7 @@
 #include "basictemplate.h"
 #include "../utils.h"
 #include <wx/xml/xml.h>
+#include "../xmldoccache.h"
 
 
 DiskBasicTemplates gDiskBasicTemplates;
@@ -28,7 +29,7 @@ bool DiskBasicTemplates::Load(const wxString &data_path, const wxString &locale_
 {
 	wxXmlDocument doc;
 
-	if (!doc.Load(data_path + wxT("basic_types.xml"))) return false;
+	if (!gXmlDocCache.LoadDocument(doc, data_path + wxT("basic_types.xml"))) return false;
 
 	// start processing the XML file
 	if (doc.GetRoot()->GetName() != "DiskBasics") return false;
@@ -41,7 +42,7 @@ bool DiskBasicTemplates::Load(const wxString &data_path, const wxString &locale_
 	if (!valid) return false;
 
 
-	if (!doc.Load(data_path + wxT("category_types.xml"))) return false;
+	if (!gXmlDocCache.LoadDocument(doc, data_path + wxT("category_types.xml"))) return false;
 
 	valid = categories.Load(doc.GetRoot(), locale_name, errmsgs);
 
@@ -357,6 +357,36 @@ DiskBasicType::~DiskBasicType()
 {
 }
 
+/// 指定トラック以下にあるセクタから条件に合うものをさがす
+///
+/// 解析前の簡易判定用。セクタを変更済みにしないようにバッファは参照のみ。
+/// @param [in] disk          ディスク
+/// @param [in] max_track_num この番号以下のトラックをさがす(サイドは問わない)
+/// @param [in] match         セクタデータが条件に合うか
+/// @return 条件に合ったセクタのデータ / NULL:なし
+const wxUint8 *DiskBasicType::FindSectorOnTopTracks(DiskImageDisk *disk, int max_track_num, bool (*match)(const wxUint8 *data, int size))
+{
+	DiskImageTracks *tracks = disk->GetTracks();
+	if (!tracks) return NULL;
+
+	for(size_t ti=0; ti<tracks->Count(); ti++) {
+		DiskImageTrack *track = tracks->Item(ti);
+		if (!track || track->GetTrackNumber() > max_track_num) continue;
+		DiskImageSectors *sectors = track->GetSectors();
+		if (!sectors) continue;
+		for(size_t si=0; si<sectors->Count(); si++) {
+			DiskImageSector *sector = sectors->Item(si);
+			if (!sector) continue;
+			const wxUint8 *data = sector->PeekSectorBuffer();
+			if (!data) continue;
+			if (match(data, sector->GetSectorSize())) {
+				return data;
+			}
+		}
+	}
+	return NULL;
+}
+
 /// FAT位置をセット
 /// @param [in] num グループ番号(0...)
 /// @param [in] val 値
@@ -393,16 +423,51 @@ wxUint32 DiskBasicType::GetNextGroupNumber(wxUint32 num, int sector_pos)
 /// @return INVALID_GROUP_NUMBER 空きなし
 wxUint32 DiskBasicType::GetEmptyGroupNumber()
 {
-	wxUint32 new_num = INVALID_GROUP_NUMBER;
 	// 若い番号順に検索
-	for(wxUint32 num = 0; num <= basic->GetFatEndGroup(); num++) {
+	return FindEmptyGroupNumber(0, basic->GetFatEndGroup());
+}
+
+/// 1トラックあたりのグループ数(空きをさがす単位)
+int DiskBasicType::GetGroupsPerTrackUnit() const
+{
+	int secs_per_grp = basic->GetSectorsPerGroup();
+	if (secs_per_grp <= 0) return 1;
+	int sed = basic->GetSectorsPerTrackOnBasic() * basic->GetSidesPerDiskOnBasic() / secs_per_grp;
+	return (sed > 0 ? sed : 1);
+}
+
+/// 空きグループの索引を作成
+///
+/// FATを一度だけ走査して空きグループを登録する。
+void DiskBasicType::CreateFreeGroupIndex()
+{
+	wxUint32 end_group = basic->GetFatEndGroup();
+	free_groups.Create(end_group + 1, GetGroupsPerTrackUnit());
+	for(wxUint32 num = 0; num <= end_group; num++) {
+		if (GetGroupNumber(num) == basic->GetGroupUnusedCode()) {
+			free_groups.SetFree(num, true);
+		}
+	}
+}
+
+/// 範囲内で最初の空きグループをさがす
+///
+/// 索引があればビットマップから、なければFATを走査してさがす。
+/// @param [in] start 開始グループ番号
+/// @param [in] end   終了グループ番号(この番号を含む)
+/// @return INVALID_GROUP_NUMBER 空きなし
+wxUint32 DiskBasicType::FindEmptyGroupNumber(wxUint32 start, wxUint32 end)
+{
+	if (free_groups.IsValid()) {
+		return free_groups.FindFree(start, end);
+	}
+	for(wxUint32 num = start; num <= end; num++) {
 		wxUint32 gnum = GetGroupNumber(num);
 		if (gnum == basic->GetGroupUnusedCode()) {
-			new_num = num;
-			break;
+			return num;
 		}
 	}
-	return new_num;
+	return INVALID_GROUP_NUMBER;
 }
 
 /// 次の空きFAT位置を返す
@@ -413,11 +478,7 @@ wxUint32 DiskBasicType::GetNextEmptyGroupNumber(wxUint32 curr_group)
 	wxUint32 new_num = INVALID_GROUP_NUMBER;
 
 	// 同じトラックでグループが連続するように検索
-	int secs_per_grp = basic->GetSectorsPerGroup();
-	int secs_per_trk = basic->GetSectorsPerTrackOnBasic();
-	int sides = basic->GetSidesPerDiskOnBasic();
-
-	int sed = secs_per_trk * sides / secs_per_grp;
+	int sed = GetGroupsPerTrackUnit();
 	int group_max = (basic->GetFatEndGroup() / sed) + 1;
 	int group_manage = managed_start_group / sed;
 	int group_start = curr_group / sed;
@@ -432,17 +493,25 @@ wxUint32 DiskBasicType::GetNextEmptyGroupNumber(wxUint32 curr_group)
 	for(int i=0; i<2; i++) {
 		group_end = (dir > 0 ? group_max : -1);
 		for(int g = group_start; g != group_end; g += dir) {
-			for(int s = sst; s < sed; s++) {
-				wxUint32 num = g * sed + s;
-				if (num > basic->GetFatEndGroup()) {
-					break;
+			if (free_groups.IsValid()) {
+				// 索引があれば空きのないトラックは読み飛ばす
+				if (free_groups.GetUnitFrees(g) > 0) {
+					new_num = free_groups.FindFree(g * sed + sst, g * sed + sed - 1);
+					found = (new_num != INVALID_GROUP_NUMBER);
 				}
-				wxUint32 gnum = GetGroupNumber(num);
-//				myLog.SetDebug("DiskBasicType::GetNextEmptyGroupNumber num:0x%03x gnum:0x%03x", num, gnum);
-				if (gnum == basic->GetGroupUnusedCode()) {	// 0xff
-					new_num = num;
-					found = true;
-					break;
+			} else {
+				for(int s = sst; s < sed; s++) {
+					wxUint32 num = g * sed + s;
+					if (num > basic->GetFatEndGroup()) {
+						break;
+					}
+					wxUint32 gnum = GetGroupNumber(num);
+//					myLog.SetDebug("DiskBasicType::GetNextEmptyGroupNumber num:0x%03x gnum:0x%03x", num, gnum);
+					if (gnum == basic->GetGroupUnusedCode()) {	// 0xff
+						new_num = num;
+						found = true;
+						break;
+					}
 				}
 			}
 			if (found) break;
@@ -617,7 +686,7 @@ double DiskBasicType::CheckDirectory(bool is_root, const DiskBasicGroups &group_
 				valid = false;
 				break;
 			}
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			if (!buffer) {
 				valid = false;
 				break;
@@ -668,7 +737,8 @@ double DiskBasicType::CheckDirectory(bool is_root, const DiskBasicGroups &group_
 					pos = size;
 					break;
 				}
-				nitem->SetDataPtr(index_number, gitem, sector, pos, buffer, &next_sec);
+				// チェック用のアイテムなので書き込みはしない
+				nitem->SetDataPtr(index_number, gitem, sector, pos, (wxUint8 *)buffer, &next_sec);
 				valid = nitem->Check(last);
 				if (valid) {
 					if (nitem->CheckUsed(false)) {
@@ -1146,6 +1216,10 @@ int DiskBasicType::AllocateUnitGroups(int fileunit_num, DiskBasicDirItem *item,
 	int sizeremain = data_size;
 
 	int bytes_per_group = basic->GetSectorsPerGroup() * basic->GetSectorSize();
+
+	// 確保中は空きをさがすたびにFATを走査しないように索引を作る
+	CreateFreeGroupIndex();
+
 	wxUint32 group_num = GetEmptyGroupNumber();
 	int limit = basic->GetFatEndGroup() + 1;
 	while(rc >= 0 && limit >= 0 && sizeremain > 0) {
@@ -1156,6 +1230,7 @@ int DiskBasicType::AllocateUnitGroups(int fileunit_num, DiskBasicDirItem *item,
 		}
 		// 位置を予約
 		SetGroupNumber(group_num, basic->GetGroupFinalCode());
+		free_groups.SetFree(group_num, false);
 
 		// グループ番号の書き込み
 		if (first_group) {
@@ -1204,6 +1279,7 @@ int DiskBasicType::AllocateUnitGroups(int fileunit_num, DiskBasicDirItem *item,
 		DeleteGroups(group_items);
 		rc = -1;
 	}
+	free_groups.Clear();
 //	myLog.SetDebug("rc: %d }", rc);
 
 	return rc;
@@ -1554,8 +1630,7 @@ int DiskBasicType::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxInputS
 	if (modified_size > 0) {
 		if (ostream) {
 			// 書き出し
-			temp.SetData(sector_buffer, modified_size, basic->IsDataInverted());
-			ostream->Write(temp.GetData(), temp.GetSize());
+			WriteDataToStream(ostream, sector_buffer, modified_size);
 		}
 		if (istream) {
 			// 読み込んで比較
@@ -1572,6 +1647,21 @@ int DiskBasicType::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxInputS
 	return sector_size;
 }
 
+/// セクタ内のデータを出力する
+/// データの反転が必要な時のみテンポラリバッファを経由する
+/// @param [out] ostream 出力先ストリーム
+/// @param [in]  buffer  セクタ内のデータ
+/// @param [in]  size    サイズ
+void DiskBasicType::WriteDataToStream(wxOutputStream *ostream, const wxUint8 *buffer, int size)
+{
+	if (basic->IsDataInverted()) {
+		temp.SetData(buffer, size, true);
+		ostream->Write(temp.GetData(), temp.GetSize());
+	} else {
+		ostream->Write(buffer, size);
+	}
+}
+
 /// 内部ファイルをエクスポートする際に内容を変換
 /// @param [in] item          ディレクトリアイテム
 /// @param [in] istream       入力ストリーム
@@ -1679,6 +1769,7 @@ void DiskBasicType::DeleteGroupNumber(wxUint32 group_num)
 {
 	// FATに未使用コードを設定
 	SetGroupNumber(group_num, basic->GetGroupUnusedCode());
+	free_groups.SetFree(group_num, true);
 }
 
 //
@@ -22,7 +22,9 @@ class wxInputStream;
 class wxOutputStream;
 class DiskImageSector;
 class DiskImageTrack;
+class DiskImageDisk;
 class DiskBasic;
+class DiskBasicParam;
 class DiskBasicFat;
 class DiskBasicDir;
 class DiskBasicDirItem;
@@ -185,16 +187,41 @@ protected:
 //	int			 free_groups;		///< 残りグループサイズ
 	DiskBasicAvailabillity fat_availability;	///< 使用状況(FAT,グループ単位)
 
+	DiskBasicFreeGroupIndex free_groups;	///< 空きグループの索引(グループ確保中のみ有効)
+
 	/// ファイルアクセス時のテンポラリバッファ
 	DiskBasicTempData temp;
 
 	DiskBasicType() {}
 	DiskBasicType(const DiskBasicType &) {}
 	DiskBasicType &operator=(const DiskBasicType &) { return *this; }
+	/// @brief 1トラックあたりのグループ数(空きをさがす単位)
+	int				GetGroupsPerTrackUnit() const;
+	/// @brief 空きグループの索引を作成
+	void			CreateFreeGroupIndex();
+	/// @brief 範囲内で最初の空きグループをさがす
+	wxUint32		FindEmptyGroupNumber(wxUint32 start, wxUint32 end);
+	/// @brief セクタ内のデータを出力する
+	void			WriteDataToStream(wxOutputStream *ostream, const wxUint8 *buffer, int size);
+
+	/// @brief 指定トラック以下にあるセクタから条件に合うものをさがす
+	static const wxUint8 *FindSectorOnTopTracks(DiskImageDisk *disk, int max_track_num, bool (*match)(const wxUint8 *data, int size));
+
+public:
+	/// @brief 簡易判定の結果
+	enum en_probe_results {
+		PROBE_NO = 0,	///< 該当しない
+		PROBE_UNKNOWN,	///< 不明（解析が必要）
+		PROBE_LIKELY,	///< 該当しそう
+	};
+
 public:
 	DiskBasicType(DiskBasic *basic, DiskBasicFat *fat, DiskBasicDir *dir);
 	virtual ~DiskBasicType();
 
+	/// @brief 所属するDISK BASICとDIRクラスを設定
+	void			SetBasic(DiskBasic *n_basic, DiskBasicDir *n_dir) { basic = n_basic; dir = n_dir; }
+
 	/// @name access to FAT area
 	//@{
 	/// @brief FAT位置をセット
@@ -209,10 +236,18 @@ public:
 	virtual wxUint32 GetEmptyGroupNumber();
 	/// @brief 次の空きFAT位置を返す
 	virtual wxUint32 GetNextEmptyGroupNumber(wxUint32 curr_group);
+	/// @brief FATを展開してアクセスする場合の形式
+	/// @return en_fat_decode_types
+	virtual int		GetFatDecodeType() const { return FAT_DECODE_NONE; }
 	//@}
 
 	/// @name check / assign FAT area
 	//@{
+	/// @brief 解析前にディスクがこの形式である見込みを簡易判定
+	/// @param[in] disk  ディスク
+	/// @param[in] param DISK BASICパラメータ
+	/// @return en_probe_results
+	static int		ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param) { return PROBE_UNKNOWN; }
 	/// @brief ディスクから各パラメータを取得＆必要なパラメータを計算
 	/// @param[in] is_formatting フォーマット中か
 	virtual double	ParseParamOnDisk(bool is_formatting) { return 1.0; }
@@ -358,6 +393,8 @@ public:
 	virtual bool	PrepareToAccessFile(int fileunit_num, DiskBasicDirItem *item, wxInputStream *istream, wxOutputStream *ostream, int &file_size, DiskBasicGroups &group_items, DiskBasicError &errinfo) { return true; }
 	/// @brief データの読み込み/比較処理
 	virtual int		AccessFile(int fileunit_num, DiskBasicDirItem *item, wxInputStream *istream, wxOutputStream *ostream, const wxUint8 *sector_buffer, int sector_size, int remain_size, int sector_num, int sector_end);
+	/// @brief エクスポートする際に内容の変換が必要か
+	virtual bool	NeedConvertDataForLoad(DiskBasicDirItem *item) const { return false; }
 	/// @brief 内部ファイルをエクスポートする際に内容を変換
 	virtual bool	ConvertDataForLoad(DiskBasicDirItem *item, wxInputStream &istream, wxOutputStream &ostream);
 	/// @brief エクスポートしたファイルをベリファイする際に内容を変換
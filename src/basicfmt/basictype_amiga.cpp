@@ -86,6 +86,17 @@ void AmigaOneBitmap::FreeAll(wxUint32 block_num)
 	m_map->map[pos] = dat;
 }
 
+/// 範囲内で最初に空き/使用中となる位置を返す
+/// @param[in] start 開始位置(このビットマップ内の位置)
+/// @param[in] end   終了位置(この位置を含む)
+/// @param[in] free  空きをさがす場合true
+/// @return 位置 / INVALID_GROUP_NUMBER なし
+wxUint32 AmigaOneBitmap::Find(wxUint32 start, wxUint32 end, bool free) const
+{
+	// ビットがセットされていれば空き
+	return DiskBasicBitmapWords::Find((const wxUint8 *)m_map->map, (size_t)(m_block_size - 4), start, end, free, BITMAP_ORDER_LSB32BE);
+}
+
 /// ブロック数を返す
 wxUint32 AmigaOneBitmap::GetBlockNums() const
 {
@@ -110,6 +121,7 @@ WX_DEFINE_OBJARRAY(ArrayOfAmigaBitmap);
 AmigaBitmap::AmigaBitmap()
 	: ArrayOfAmigaBitmap()
 {
+	m_nums_per_map = 0;
 }
 
 AmigaBitmap::~AmigaBitmap()
@@ -122,7 +134,35 @@ AmigaBitmap::~AmigaBitmap()
 /// @param[in] block_size バッファサイズ
 void AmigaBitmap::AddBitmap(wxUint32 block_num, void *map, int block_size)
 {
-	Add(AmigaOneBitmap(block_num, map, block_size));
+	AmigaOneBitmap item(block_num, map, block_size);
+	if (Count() == 0) {
+		m_nums_per_map = item.GetBlockNums();
+	} else if (m_nums_per_map != item.GetBlockNums()) {
+		m_nums_per_map = 0;
+	}
+	Add(item);
+}
+
+/// 指定位置のあるビットマップを返す
+/// @param[in,out] block_num  ブロック番号(0..) / ビットマップ内の位置
+/// @return ビットマップ / NULL 範囲外
+AmigaOneBitmap *AmigaBitmap::FindBitmap(wxUint32 &block_num) const
+{
+	if (m_nums_per_map > 0) {
+		// サイズがそろっていれば計算で求める
+		size_t i = block_num / m_nums_per_map;
+		if (i >= Count()) return NULL;
+		block_num %= m_nums_per_map;
+		return &Item(i);
+	}
+	for(size_t i=0; i<Count(); i++) {
+		AmigaOneBitmap *item = &Item(i);
+		if (block_num < item->GetBlockNums()) {
+			return item;
+		}
+		block_num -= item->GetBlockNums();
+	}
+	return NULL;
 }
 
 /// 指定位置のビットを変更する
@@ -133,13 +173,9 @@ void AmigaBitmap::Modify(wxUint32 block_num, bool use)
 	if (block_num < 2) return;
 
 	block_num -= 2;
-	for(size_t i=0; i<Count(); i++) {
-		AmigaOneBitmap *item = &Item(i);
-		if (block_num < item->GetBlockNums()) {
-			item->Modify(block_num, use);
-			break;
-		}
-		block_num -= item->GetBlockNums();
+	AmigaOneBitmap *item = FindBitmap(block_num);
+	if (item) {
+		item->Modify(block_num, use);
 	}
 }
 
@@ -151,14 +187,41 @@ bool AmigaBitmap::IsFree(wxUint32 block_num) const
 	if (block_num < 2) return false;
 
 	block_num -= 2;
-	for(size_t i=0; i<Count(); i++) {
+	AmigaOneBitmap *item = FindBitmap(block_num);
+	return (item ? item->IsFree(block_num) : false);
+}
+
+/// 範囲内で最初に空き/使用中となる位置を返す
+/// @param[in] start 開始ブロック番号
+/// @param[in] end   終了ブロック番号(この番号を含む)
+/// @param[in] free  空きをさがす場合true
+/// @return ブロック番号 / INVALID_GROUP_NUMBER なし
+wxUint32 AmigaBitmap::Find(wxUint32 start, wxUint32 end, bool free) const
+{
+	if (start < 2) {
+		// ブートブロックは使用中
+		if (!free) return start;
+		start = 2;
+	}
+	if (start > end) return INVALID_GROUP_NUMBER;
+
+	wxUint32 sta = start - 2;
+	wxUint32 fin = end - 2;
+	wxUint32 base = 0;
+	for(size_t i=0; i<Count() && sta <= fin; i++) {
 		AmigaOneBitmap *item = &Item(i);
-		if (block_num < item->GetBlockNums()) {
-			return item->IsFree(block_num);
+		wxUint32 nums = item->GetBlockNums();
+		if (sta < base + nums) {
+			wxUint32 num = item->Find(sta - base, fin - base, free);
+			if (num != INVALID_GROUP_NUMBER) return base + num + 2;
+			if (fin < base + nums) return INVALID_GROUP_NUMBER;
+			sta = base + nums;
 		}
-		block_num -= item->GetBlockNums();
+		base += nums;
 	}
-	return false;
+	// ビットマップの範囲外は使用中とみなす
+	if (!free && sta <= fin) return sta + 2;
+	return INVALID_GROUP_NUMBER;
 }
 
 /// 指定ブロックまですべて未使用にする
@@ -227,6 +290,32 @@ double DiskBasicTypeAmiga::CheckFat(bool is_formatting)
 	return valid_ratio;
 }
 
+/// 解析前にディスクがこの形式である見込みを簡易判定
+///
+/// グループ0(トラック0,サイド0の先頭セクタ)がブートブロックでなければ該当しない。
+/// @note ParseParamOnDisk() と同じセクタを参照すること
+/// @param [in] disk  ディスク
+/// @param [in] param DISK BASICパラメータ
+/// @return en_probe_results
+int DiskBasicTypeAmiga::ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param)
+{
+	DiskImageSector *sector = disk->GetSector(disk->GetTrackNumberBaseOnDisk(), disk->GetSideNumberBaseOnDisk(), disk->GetSectorNumberBaseOnDisk());
+	const amiga_boot_block_t *bb = (const amiga_boot_block_t *)(sector ? sector->PeekSectorBuffer() : NULL);
+	if (!bb || sector->GetSectorSize() < 4) {
+		return PROBE_NO;
+	}
+	if (memcmp(bb->type, "DOS", 3) != 0 && memcmp(bb->type, "KICK", 4) != 0) {
+		return PROBE_NO;
+	}
+	// Fast File System か
+	bool disk_is_fast = (bb->type[3] != 'K' && (bb->type[3] & 1) != 0);
+	bool param_is_fast = param.GetVariousBoolParam(wxT(KEY_FAST_FILE_SYSTEM));
+	if (disk_is_fast != param_is_fast) {
+		return PROBE_NO;
+	}
+	return PROBE_LIKELY;
+}
+
 /// ディスクから各パラメータを取得＆必要なパラメータを計算
 /// @param [in] is_formatting フォーマット中か
 /// @retval 1.0       正常
@@ -245,7 +334,7 @@ double DiskBasicTypeAmiga::ParseParamOnDisk(bool is_formatting)
 	if (!sector) {
 		return -1.0;
 	}
-	amiga_boot_block_t *bb = (amiga_boot_block_t *)sector->GetSectorBuffer();
+	const amiga_boot_block_t *bb = (const amiga_boot_block_t *)sector->PeekSectorBuffer();
 	if (!bb) {
 		return -1.0;
 	}
@@ -482,14 +571,22 @@ void DiskBasicTypeAmiga::CalcDiskFreeSize(bool wrote)
 	}
 
 	// BITMAP table
-	for(wxUint32 num = 0; num <= basic->GetFatEndGroup(); num++) {
-		if (num < 2) {
-			fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
-		} else if (m_bitmap.IsFree(num)) {
-			fat_availability.Add(FAT_AVAIL_FREE, block_size, 1);
+	wxUint32 end_group = basic->GetFatEndGroup();
+	wxUint32 num = 0;
+	for(; num <= end_group && num < 2; num++) {
+		fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
+	}
+	// 同じ値が続く範囲ごとにまとめて追加
+	while(num <= end_group) {
+		bool free = m_bitmap.IsFree(num);
+		wxUint32 next = m_bitmap.Find(num, end_group, !free);
+		if (next == INVALID_GROUP_NUMBER) next = end_group + 1;
+		if (free) {
+			fat_availability.Add(FAT_AVAIL_FREE, block_size, 1, next - num);
 		} else {
-			fat_availability.Add(FAT_AVAIL_USED, 0, 0);
+			fat_availability.Add(FAT_AVAIL_USED, 0, 0, next - num);
 		}
+		num = next;
 	}
 
 	fat_availability.Item(m_root.block_num) = FAT_AVAIL_SYSTEM;
@@ -564,13 +661,12 @@ wxUint32 DiskBasicTypeAmiga::GetEmptyGroupNumberM()
 		}
 
 		for(int trk_num = sta_trk; trk_num != end_trk && new_num == INVALID_GROUP_NUMBER; trk_num += ndir) {
-			for(int sec_num = 0; sec_num < num_of_secs; sec_num++) {
-				wxUint32 num = GetSectorPosFromNumS(trk_num, sec_num + basic->GetSectorNumberBase());
-				if (m_bitmap.IsFree(num)) {
-					new_num = num;
-					break;
-				}
-			}
+			// トラック内のブロック番号は連続している
+			int sta_num = GetSectorPosFromNumS(trk_num, basic->GetSectorNumberBase());
+			int end_num = sta_num + num_of_secs - 1;
+			if (end_num < 0) continue;
+			if (sta_num < 0) sta_num = 0;
+			new_num = m_bitmap.Find((wxUint32)sta_num, (wxUint32)end_num, true);
 		}
 	}
 	return new_num;
@@ -769,8 +865,7 @@ int DiskBasicTypeAmiga::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxI
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(buffer, size, basic->IsDataInverted());
-		ostream->Write(temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
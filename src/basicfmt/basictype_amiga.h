@@ -53,6 +53,8 @@ public:
 	bool IsFree(wxUint32 block_num) const;
 	/// @brief 指定ブロックまですべて未使用にする
 	void FreeAll(wxUint32 block_num);
+	/// @brief 範囲内で最初に空き/使用中となる位置を返す
+	wxUint32 Find(wxUint32 start, wxUint32 end, bool free) const;
 	/// @brief ブロック番号をセット
 	void SetBlockNumber(wxUint32 val) { m_block_num = val; }
 	/// @brief ブロック番号を返す
@@ -72,6 +74,12 @@ WX_DECLARE_OBJARRAY(AmigaOneBitmap, ArrayOfAmigaBitmap);
 /// @brief AMIGA ビットマップ AmigaOneBitmapの配列
 class AmigaBitmap : public ArrayOfAmigaBitmap
 {
+private:
+	wxUint32 m_nums_per_map;	///< 1ビットマップあたりのブロック数 サイズがそろっていない時は0
+
+	/// @brief 指定位置のあるビットマップを返す
+	AmigaOneBitmap *FindBitmap(wxUint32 &block_num) const;
+
 public:
 	AmigaBitmap();
 	~AmigaBitmap();
@@ -82,6 +90,8 @@ public:
 	void Modify(wxUint32 block_num, bool use);
 	/// @brief 指定位置が空いているか
 	bool IsFree(wxUint32 block_num) const;
+	/// @brief 範囲内で最初に空き/使用中となる位置を返す
+	wxUint32 Find(wxUint32 start, wxUint32 end, bool free) const;
 	/// @brief 指定ブロックまですべて未使用にする
 	void FreeAll(wxUint32 block_num);
 	/// @brief ブロック数を返す
@@ -144,6 +154,8 @@ public:
 	//@{
 	/// @brief FATエリアをチェック
 	virtual double 	CheckFat(bool is_formatting);
+	/// @brief 解析前にディスクがこの形式である見込みを簡易判定
+	static int		ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param);
 	/// @brief ディスクから各パラメータを取得＆必要なパラメータを計算
 	virtual double	ParseParamOnDisk(bool is_formatting);
 	/// @brief Allocation Mapの開始位置を得る（ダイアログ用）
@@ -78,7 +78,7 @@ double DiskBasicTypeAppleDOS::CheckFat(bool is_formatting)
 			break;
 		}
 
-		apledos_ptr_t *p = (apledos_ptr_t *)sector->GetSectorBuffer();
+		const apledos_ptr_t *p = (const apledos_ptr_t *)sector->PeekSectorBuffer();
 //		dir_cnt++;
 
 		if (p->next_track == 0 && p->next_sector == 0) {
@@ -193,7 +193,7 @@ bool DiskBasicTypeAppleDOS::CalcGroupsOnRootDirectory(int start_sector, int end_
 		}
 		sec_num = sector->GetSectorNumber();
 
-		wxUint8 *buffer = sector->GetSectorBuffer(); 
+		const wxUint8 *buffer = sector->PeekSectorBuffer();
 		if (!buffer) {
 			valid = false;
 			break;
@@ -203,7 +203,7 @@ bool DiskBasicTypeAppleDOS::CalcGroupsOnRootDirectory(int start_sector, int end_
 
 		dir_size += sector->GetSectorSize();
 
-		apledos_ptr_t *p = (apledos_ptr_t *)buffer;
+		const apledos_ptr_t *p = (const apledos_ptr_t *)buffer;
 
 		// 次のセクタなし
 		if (p->next_track == 0 && p->next_sector == 0) {
@@ -785,7 +785,7 @@ bool DiskBasicTypeAppleDOS::AdditionalProcessOnDeletedFile(DiskBasicDirItem *ite
 		SetGroupNumber(gnum, 0);
 		DiskImageSector *sector = basic->GetSectorFromGroup(gnum);
 		if (!sector) break;
-		apledos_chain_t *p = (apledos_chain_t *)sector->GetSectorBuffer();
+		const apledos_chain_t *p = (const apledos_chain_t *)sector->PeekSectorBuffer();
 		if (!p) break;
 		gnum = GetSectorPosFromNumS(p->next.next_track + basic->GetTrackNumberBaseOnDisk(),  p->next.next_sector + basic->GetSectorNumberBase());
 	}
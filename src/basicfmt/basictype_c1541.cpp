@@ -53,6 +53,21 @@ bool C1541Bitmap::IsFree(int track_num, int sector_num) const
 	return ((m_bam->map[track_num].bits[pos] & (1 << bit)) != 0);
 }
 
+/// 指定トラックに空きがあるか
+///
+/// 空き数のバイトではなくビットマップの3バイトをまとめて調べる。
+/// @param[in] track_num  トラック番号(0 ..)
+/// @return 空きがある場合 true
+bool C1541Bitmap::HasFree(int track_num) const
+{
+	if (track_num < 0 || track_num >= (int)(sizeof(m_bam->map) / sizeof(m_bam->map[0]))) {
+		// 範囲外は個別に調べる
+		return true;
+	}
+	const wxUint8 *bits = m_bam->map[track_num].bits;
+	return ((bits[0] | bits[1] | bits[2]) != 0);
+}
+
 /// 指定トラックをすべて未使用にする
 /// @param[in] track_num  トラック番号(0 ..)
 /// @param[in] num_of_sector セクタ数
@@ -268,7 +283,7 @@ bool DiskBasicTypeC1541::CalcGroupsOnRootDirectory(int start_sector, int end_sec
 			break;
 		}
 		sec_num = sector->GetSectorNumber();
-		wxUint8 *buffer = sector->GetSectorBuffer();
+		const wxUint8 *buffer = sector->PeekSectorBuffer();
 		if (!buffer) {
 			valid = false;
 			break;
@@ -279,7 +294,7 @@ bool DiskBasicTypeC1541::CalcGroupsOnRootDirectory(int start_sector, int end_sec
 		dir_size += sector->GetSectorSize();
 
 		// 次のセクタ
-		c1541_ptr_t *next = (c1541_ptr_t *)buffer;
+		const c1541_ptr_t *next = (const c1541_ptr_t *)buffer;
 		if (next->track == 0 || (int)next->track > basic->GetTracksPerSideOnBasic()) {
 			break;
 		}
@@ -437,6 +452,10 @@ wxUint32 DiskBasicTypeC1541::GetEmptyGroupNumberM(int method)
 
 		for(int trk_num = sta_trk; trk_num != end_trk && new_num == INVALID_GROUP_NUMBER; trk_num += ndir) {
 			int trk_anum = trk_num - basic->GetTrackNumberBaseOnDisk();
+			if (!c1541_bam.HasFree(trk_anum)) {
+				// 空きのないトラックは飛ばす
+				continue;
+			}
 			const SectorsPerTrack *item = sector_map.FindByTrackNum(trk_anum);
 			int num_of_secs = item->GetNumOfSectors();
 			for(int sec_pos = 0; sec_pos < num_of_secs; sec_pos++) {
@@ -632,8 +651,7 @@ int DiskBasicTypeC1541::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxI
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(buf, size, basic->IsDataInverted());
-		ostream->Write(temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, buf, size);
 	}
 	if (istream) {
 		// 読み込んで比較
@@ -72,6 +72,8 @@ public:
 	void Modify(int track_num, int sector_num, bool use);
 	/// @brief 指定位置が空いているか
 	bool IsFree(int track_num, int sector_num) const;
+	/// @brief 指定トラックに空きがあるか
+	bool HasFree(int track_num) const;
 	/// @brief 指定トラックをすべて未使用にする
 	void FreeTrack(int track_num, int num_of_sector);
 	/// @brief ディスク名を返す
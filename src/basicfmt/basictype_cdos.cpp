@@ -133,9 +133,7 @@ int DiskBasicTypeCDOS::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxIn
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(sector_buffer, size, basic->IsDataInverted());
-
-		ostream->Write((const void *)temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, sector_buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
@@ -151,6 +149,14 @@ int DiskBasicTypeCDOS::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxIn
 	return size;
 }
 
+/// エクスポートする際に内容の変換が必要か
+/// アスキーファイルは最終バイトを除くので必要
+/// @param [in] item          ディレクトリアイテム
+bool DiskBasicTypeCDOS::NeedConvertDataForLoad(DiskBasicDirItem *item) const
+{
+	return item->GetFileAttr().IsAscii();
+}
+
 /// 内部ファイルをエクスポートする際に内容を変換
 /// @param [in] item          ディレクトリアイテム
 /// @param [in] istream       入力ストリーム
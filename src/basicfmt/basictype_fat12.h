@@ -33,6 +33,8 @@ public:
 	virtual void		SetGroupNumber(wxUint32 num, wxUint32 val);
 	/// @brief FAT位置を返す
 	virtual wxUint32	GetGroupNumber(wxUint32 num) const;
+	/// @brief FATを展開してアクセスする場合の形式
+	virtual int			GetFatDecodeType() const { return FAT_DECODE_12LE; }
 	//@}
 
 	/// @name check / assign FAT area
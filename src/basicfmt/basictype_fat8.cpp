@@ -122,16 +122,8 @@ DiskBasicTypeFAT8F::DiskBasicTypeFAT8F(DiskBasic *basic, DiskBasicFat *fat, Disk
 /// @return INVALID_GROUP_NUMBER: 空きなし
 wxUint32 DiskBasicTypeFAT8F::GetNextEmptyGroupNumber(wxUint32 curr_group)
 {
-	wxUint32 new_num = INVALID_GROUP_NUMBER;
 	// 若い番号順に検索
-	for(wxUint32 num = curr_group; num <= basic->GetFatEndGroup(); num++) {
-		wxUint32 gnum = GetGroupNumber(num);
-		if (gnum == basic->GetGroupUnusedCode()) {
-			new_num = num;
-			break;
-		}
-	}
-	return new_num;
+	return FindEmptyGroupNumber(curr_group, basic->GetFatEndGroup());
 }
 
 /// スキップするトラック番号
@@ -22,26 +22,11 @@ DiskBasicTypeFATBase::DiskBasicTypeFATBase(DiskBasic *basic, DiskBasicFat *fat,
 /// @return INVALID_GROUP_NUMBER: 空きなし
 wxUint32 DiskBasicTypeFATBase::GetNextEmptyGroupNumber(wxUint32 curr_group)
 {
-	wxUint32 new_num = INVALID_GROUP_NUMBER;
-
 	// グループが連続するように検索
-	int group_start = curr_group;
-	int group_end = basic->GetFatEndGroup();
-	bool found = false;
-
-	for(int i=0; i<2; i++) {
-		for(int g = group_start; g <= group_end; g++) {
-			wxUint32 gnum = GetGroupNumber(g);
-//			myLog.SetDebug("DiskBasicTypeFATBase::GetNextEmptyGroupNumber: g:%d gnum:%d", g, gnum);
-			if (gnum == basic->GetGroupUnusedCode()) {
-				new_num = g;
-				found = true;
-				break;
-			}
-		}
-		if (found) break;
+	wxUint32 new_num = FindEmptyGroupNumber(curr_group, basic->GetFatEndGroup());
+	if (new_num == INVALID_GROUP_NUMBER) {
 		// ないときは最初からさがす
-		group_start = 2;
+		new_num = FindEmptyGroupNumber(2, basic->GetFatEndGroup());
 	}
 	return new_num;
 }
@@ -96,7 +96,7 @@ double DiskBasicTypeFLEX::CheckFat(bool is_formatting)
 			break;
 		}
 
-		flex_ptr_t *p = (flex_ptr_t *)sector->GetSectorBuffer(secofs);
+		const flex_ptr_t *p = (const flex_ptr_t *)sector->PeekSectorBuffer(secofs);
 		dir_cnt++;
 
 		if (p->next_track == 0 && p->next_sector == 0) {
@@ -171,7 +171,7 @@ bool DiskBasicTypeFLEX::CalcGroupsOnRootDirectory(int start_sector, int end_sect
 		}
 		sec_num = sector->GetSectorNumber();
 
-		wxUint8 *buffer = sector->GetSectorBuffer(SecBufOfs(div_num + 1)); 
+		const wxUint8 *buffer = sector->PeekSectorBuffer(SecBufOfs(div_num + 1)); 
 		if (!buffer) {
 			valid = false;
 			break;
@@ -181,7 +181,7 @@ bool DiskBasicTypeFLEX::CalcGroupsOnRootDirectory(int start_sector, int end_sect
 
 		dir_size += LogSecSiz(sector->GetSectorSize());
 
-		flex_ptr_t *p = (flex_ptr_t *)buffer;
+		const flex_ptr_t *p = (const flex_ptr_t *)buffer;
 
 		// 次のセクタなし
 		if (p->next_track == 0 && p->next_sector == 0) {
@@ -258,7 +258,7 @@ void DiskBasicTypeFLEX::CalcDiskFreeSize(bool wrote)
 
 //		myLog.SetDebug("trk:%d sec:%d size:%d", track_num, sector_num, fsize);
 
-		flex_ptr_t *p = (flex_ptr_t *)sector->GetSectorBuffer(SecBufOfs(div_num + 1));
+		const flex_ptr_t *p = (const flex_ptr_t *)sector->PeekSectorBuffer(SecBufOfs(div_num + 1));
 		track_num = p->next_track;
 		lsector_num = p->next_sector;
 		limit--;
@@ -602,8 +602,7 @@ int DiskBasicTypeFLEX::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxIn
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(buf, size, basic->IsDataInverted());
-		ostream->Write(temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, buf, size);
 	}
 	if (istream) {
 		// 読み込んで比較
@@ -1005,11 +1004,11 @@ void DiskBasicTypeFLEX::RemakeChainOnFreeArea()
 		int div_num = 0;
 		sector = basic->GetSectorFromSectorPos(GetSectorPosFromNumS(free_track_num, free_sector_num), &div_num);
 		if (!sector) break;
-		p = (flex_ptr_t *)sector->GetSectorBuffer(SecBufOfs(div_num + 1));
-		if (!p) break;
+		const flex_ptr_t *fp = (const flex_ptr_t *)sector->PeekSectorBuffer(SecBufOfs(div_num + 1));
+		if (!fp) break;
 
-		free_track_num = p->next_track;
-		free_sector_num = p->next_sector;
+		free_track_num = fp->next_track;
+		free_sector_num = fp->next_sector;
 	}
 
 	// 空き領域をソートしてチェインを作り直す
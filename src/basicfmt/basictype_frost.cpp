@@ -429,7 +429,7 @@ void DiskBasicTypeFROST::GetIdentifiedData(DiskBasicIdentifiedData &data) const
 	int div_num, div_nums;
 	DiskImageSector *sector = basic->GetManagedSector(basic->GetFatStartSector() - 1 + 3, NULL, NULL, NULL, &div_num, &div_nums);
 	if (sector) {
-		wxUint8 *buf = sector->GetSectorBuffer();
+		const wxUint8 *buf = sector->PeekSectorBuffer();
 		buf += sector->GetSectorSize() * div_num / div_nums + 0x140;
 		if (buf[0] >= 0x20 && buf[0] < 0xff) {
 			wxString dst;
@@ -72,6 +72,24 @@ double DiskBasicTypeHFS::CheckFat(bool is_formatting)
 	return valid_ratio;
 }
 
+/// MDBか
+static bool IsHFSMasterDirectoryBlock(const wxUint8 *data, int size)
+{
+	const hfs_mdb_t *mdb = (const hfs_mdb_t *)data;
+	return (size >= (int)sizeof(hfs_mdb_t) && mdb->sig[0] == 'B' && mdb->sig[1] == 'D');
+}
+
+/// 解析前にディスクがこの形式である見込みを簡易判定
+///
+/// トラック0にHFSのシグニチャがなければ該当しない。
+/// @param [in] disk  ディスク
+/// @param [in] param DISK BASICパラメータ
+/// @return en_probe_results
+int DiskBasicTypeHFS::ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param)
+{
+	return FindSectorOnTopTracks(disk, 0, IsHFSMasterDirectoryBlock) ? PROBE_LIKELY : PROBE_NO;
+}
+
 /// ディスクから各パラメータを取得＆必要なパラメータを計算
 /// @param [in] is_formatting フォーマット中か
 /// @retval 1.0       正常
@@ -89,7 +107,7 @@ double DiskBasicTypeHFS::ParseParamOnDisk(bool is_formatting)
 		return -1.0;
 	}
 
-	hfs_boot_blk_hdr_t *boot = (hfs_boot_blk_hdr_t *)sector->GetSectorBuffer();
+	const hfs_boot_blk_hdr_t *boot = (const hfs_boot_blk_hdr_t *)sector->PeekSectorBuffer();
 	if (!boot) {
 		return -1.0;
 	}
@@ -229,7 +247,7 @@ bool DiskBasicTypeHFS::CalcGroupsOnRootDirectory(int start_sector, int end_secto
 
 		sec_num = sector->GetSectorNumber();
 
-		wxUint8 *buffer = sector->GetSectorBuffer(); 
+		const wxUint8 *buffer = sector->PeekSectorBuffer();
 		if (!buffer) {
 			valid = false;
 			break;
@@ -273,20 +291,20 @@ double DiskBasicTypeHFS::CheckDirectory(bool is_root, const DiskBasicGroups &gro
 			valid = false;
 			break;
 		}
-		wxUint8 *buffer = sector->GetSectorBuffer();
+		const wxUint8 *buffer = sector->PeekSectorBuffer();
 		if (!buffer) {
 			valid = false;
 			break;
 		}
 
-		hfs_node_descriptor_t *node = (hfs_node_descriptor_t *)buffer;
+		const hfs_node_descriptor_t *node = (const hfs_node_descriptor_t *)buffer;
 		if (node->type == ndHdrNode) {
 			// ヘッダノードは常に最初
 			if (idx != 0) {
 				valid = false;
 				break;
 			}
-			hfs_bt_hdr_rec_t *header = (hfs_bt_hdr_rec_t *)&buffer[0xe];
+			const hfs_bt_hdr_rec_t *header = (const hfs_bt_hdr_rec_t *)&buffer[0xe];
 
 			end_idx = (size_t)wxUINT32_SWAP_ON_LE(header->totalNodes) - wxUINT32_SWAP_ON_LE(header->freeNodes);
 			continue;
@@ -310,7 +328,7 @@ double DiskBasicTypeHFS::CheckDirectory(bool is_root, const DiskBasicGroups &gro
 			int pos = (int)rpos;
 
 			// レコードのキー部分
-			hfs_cat_key_rec_t* rec_key = (hfs_cat_key_rec_t *)&buffer[rpos];
+			const hfs_cat_key_rec_t* rec_key = (const hfs_cat_key_rec_t *)&buffer[rpos];
 			if (rec_key->keyLength > 37) {
 				// キー長すぎる
 				continue;
@@ -322,7 +340,7 @@ double DiskBasicTypeHFS::CheckDirectory(bool is_root, const DiskBasicGroups &gro
 				rpos++;
 			}
 			// レコードのデータ部分
-			hfs_cat_data_rec_t *rec_dat = (hfs_cat_data_rec_t *)&buffer[rpos];
+			const hfs_cat_data_rec_t *rec_dat = (const hfs_cat_data_rec_t *)&buffer[rpos];
 			if(rec_dat->recType != FILETYPE_HFS_DIR && rec_dat->recType != FILETYPE_HFS_FILE) {
 				// スレッドは無視
 				continue;
@@ -338,6 +356,7 @@ double DiskBasicTypeHFS::CheckDirectory(bool is_root, const DiskBasicGroups &gro
 				break;
 			}
 
+			// チェック用のアイテムなので書き込みはしない
 			nitem->SetDataPtr(id, gitem, sector, pos, (wxUint8 *)rec_key);
 			valid = nitem->Check(last);
 			if (valid) {
@@ -571,13 +590,20 @@ void DiskBasicTypeHFS::CalcDiskFreeSize(bool wrote)
 
 	// check bitmap
 	int grp_end = (int)basic->GetFatEndGroup();
-	for(int grp = 0; grp < grp_end; grp++) {
+	for(int grp = 0; grp < grp_end; ) {
+		int next = (int)bitmap.FindRunEnd(grp, grp_end - 1);
 		if (!bitmap.IsSet(grp)) {
-			fat_availability.Add(FAT_AVAIL_FREE, size, 1);
-		} else if ((grp >= ctx_sta && grp <= ctx_end) || (grp >= xtx_sta && grp <= xtx_end)) {
-			fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
-		} else {
-			fat_availability.Add(FAT_AVAIL_USED, 0, 0);
+			// 空きはまとめて追加
+			fat_availability.Add(FAT_AVAIL_FREE, size, 1, next - grp);
+			grp = next;
+			continue;
+		}
+		for(; grp < next; grp++) {
+			if ((grp >= ctx_sta && grp <= ctx_end) || (grp >= xtx_sta && grp <= xtx_end)) {
+				fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
+			} else {
+				fat_availability.Add(FAT_AVAIL_USED, 0, 0);
+			}
 		}
 	}
 	// alternate MDB
@@ -137,19 +137,20 @@ void DiskBasicTypeM68FDOS::CalcDiskFreeSize(bool wrote)
 
 	// 使用済みかチェック
 	int grps = 0;
-	int fsts;
-	for(wxUint32 gnum = 0; gnum <= basic->GetFatEndGroup(); gnum++) {
-		if (gnum < data_start_group) {
-//			used++;
-			fsts = FAT_AVAIL_SYSTEM;
-		} else if (!IsUsedGroupNumber(gnum)) {
-			grps++;
-			fsts = FAT_AVAIL_FREE;
-		} else {
-//			used++;
-			fsts = FAT_AVAIL_USED;
-		}
-		fat_availability.Add(fsts, 0, 0);
+	wxUint32 end_group = basic->GetFatEndGroup();
+	wxUint32 gnum = 0;
+	for(; gnum <= end_group && gnum < data_start_group; gnum++) {
+		fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
+	}
+	if (gnum <= end_group) {
+		// 空きグループ数はセットされていないビットの数
+		grps = (int)(end_group - gnum + 1 - m_bitmap.CountBits(gnum, end_group, true));
+	}
+	// 同じ値が続く範囲ごとにまとめて追加
+	while(gnum <= end_group) {
+		wxUint32 next = m_bitmap.FindRunEnd(gnum, end_group);
+		fat_availability.Add(m_bitmap.IsSet(gnum) ? FAT_AVAIL_USED : FAT_AVAIL_FREE, 0, 0, next - gnum);
+		gnum = next;
 	}
 
 	// ディレクトリエントリのグループ
@@ -211,12 +212,11 @@ wxUint32 DiskBasicTypeM68FDOS::GetNextGroupNumber(wxUint32 num, int sector_pos)
 /// 空きFAT位置を返す
 wxUint32 DiskBasicTypeM68FDOS::GetEmptyGroupNumber()
 {
-	wxUint32 found = INVALID_GROUP_NUMBER;
-	for(wxUint32 grp_num = 0; grp_num <= basic->GetFatEndGroup(); grp_num++) {
-		if (!IsUsedGroupNumber(grp_num)) {
-			found = grp_num;
-			break;
-		}
+	wxUint32 end_group = basic->GetFatEndGroup();
+	wxUint32 found = m_bitmap.Find(0, end_group, false);
+	if (found == INVALID_GROUP_NUMBER && m_bitmap.GetBitSize() <= end_group) {
+		// マップの範囲外は空きとみなす
+		found = m_bitmap.GetBitSize();
 	}
 	return found;
 }
@@ -351,9 +351,7 @@ int DiskBasicTypeM68FDOS::AccessFile(int fileunit_num, DiskBasicDirItem *item, w
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(sector_buffer, size, basic->IsDataInverted());
-
-		ostream->Write((const void *)temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, sector_buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
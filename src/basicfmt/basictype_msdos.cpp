@@ -48,6 +48,27 @@ double DiskBasicTypeMSDOS::CheckFat(bool is_formatting)
 	return valid_ratio;
 }
 
+/// 解析前にディスクがこの形式である見込みを簡易判定
+///
+/// ブートセクタがなければ該当しない。ジャンプ命令があれば見込みあり。
+/// @param [in] disk  ディスク
+/// @param [in] param DISK BASICパラメータ
+/// @return en_probe_results
+int DiskBasicTypeMSDOS::ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param)
+{
+	DiskImageSector *sector = disk->GetSector(0, 0, 1);
+	const wxUint8 *datas = (sector ? sector->PeekSectorBuffer() : NULL);
+	if (!datas) {
+		// パラメータを読まない場合は判定できない
+		return param.GetVariousBoolParam(wxT("IgnoreParameter")) ? PROBE_UNKNOWN : PROBE_NO;
+	}
+	if (datas[0] == 0xeb || datas[0] == 0xe9) {
+		// 8086のジャンプ命令
+		return PROBE_LIKELY;
+	}
+	return PROBE_UNKNOWN;
+}
+
 /// ディスクから各パラメータを取得＆必要なパラメータを計算
 /// @param [in] is_formatting フォーマット中か
 /// @retval 1.0       正常
@@ -94,9 +115,9 @@ double DiskBasicTypeMSDOS::ParseMSDOSParamOnDisk(DiskImageDisk *disk, bool is_fo
 	// MS-DOS ディスク上のパラメータを読む
 	DiskImageSector *sector = disk->GetSector(0, 0, 1);
 	if (!sector) return -1.0;
-	wxUint8 *datas = sector->GetSectorBuffer();
+	const wxUint8 *datas = sector->PeekSectorBuffer();
 	if (!datas) return -1.0;
-	fat_bpb_t *bpb = (fat_bpb_t *)datas;
+	const fat_bpb_t *bpb = (const fat_bpb_t *)datas;
 
 	nums++;
 	if (bpb->BPB_SecPerClus != 0) {
@@ -59,6 +59,8 @@ public:
 	//@{
 	/// @brief FATエリアをチェック
 	virtual double 	CheckFat(bool is_formatting);
+	/// @brief 解析前にディスクがこの形式である見込みを簡易判定
+	static int		ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param);
 	/// @brief ディスクから各パラメータを取得＆必要なパラメータを計算
 	virtual double	ParseParamOnDisk(bool is_formatting);
 	/// @brief ディスクからMSDOSパラメータを取得
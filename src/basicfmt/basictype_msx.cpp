@@ -39,7 +39,7 @@ double DiskBasicTypeMSX::ParseParamOnDisk(bool is_formatting)
 	if (valid_ratio >= 0.0) {
 		DiskImageSector *sector = basic->GetSector(0, 0, 1);
 		if (!sector) return -1.0;
-		wxUint8 *datas = sector->GetSectorBuffer();
+		const wxUint8 *datas = sector->PeekSectorBuffer();
 		if (!datas) return -1.0;
 //		fat_bpb_t *bpb = (fat_bpb_t *)datas;
 		// MSXDOSの名前があれば確実
@@ -234,7 +234,7 @@ wxUint32 DiskBasicTypeMZ::GetNextGroupNumber(wxUint32 num, int sector_pos)
 	basic->CalcNumFromSectorPosForGroup(sector_pos, trk_num, sid_num, sec_num);
 	DiskImageSector *sector = basic->GetDisk()->GetSector(trk_num, sid_num, sec_num);
 	if (!sector) return 0;
-	wxUint16 next_sec = *(wxUint16 *)(&sector->GetSectorBuffer()[sector->GetSectorSize()-2]);
+	wxUint16 next_sec = *(const wxUint16 *)(&sector->PeekSectorBuffer()[sector->GetSectorSize()-2]);
 	next_sec = basic->InvertAndOrderUint16(next_sec);	// invert
 	return next_sec / basic->GetSectorsPerGroup();	
 }
@@ -426,9 +426,7 @@ int DiskBasicTypeMZ::AccessFile(int fileunit_num, DiskBasicDirItem *item, wxInpu
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(sector_buffer, size, basic->IsDataInverted());
-
-		ostream->Write((const void *)temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, sector_buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
@@ -46,7 +46,7 @@ double DiskBasicTypeMZFDOS::CheckFat(bool is_formatting)
 	if (!sector) {
 		return -1.0;
 	}
-	struct st_fat_mz_fdos *f = (struct st_fat_mz_fdos *)sector->GetSectorBuffer();
+	const struct st_fat_mz_fdos *f = (const struct st_fat_mz_fdos *)sector->PeekSectorBuffer();
 	if (!f) {
 		return -1.0;
 	}
@@ -78,7 +78,7 @@ wxUint32 DiskBasicTypeMZFDOS::GetNextGroupNumber(wxUint32 num, int sector_pos)
 	DiskImageSector *sector = basic->GetSector(trk_num, sid_num, sec_num);
 	if (!sector) return 0;
 
-	wxUint8 *b = sector->GetSectorBuffer();
+	const wxUint8 *b = sector->PeekSectorBuffer();
 	int s = sector->GetSectorSize();
 	wxUint8 next_trk = basic->InvertUint8(b[s-2]);
 	wxUint8 next_sec = basic->InvertUint8(b[s-1]);
@@ -258,9 +258,7 @@ int DiskBasicTypeMZFDOS::AccessFile(int fileunit_num, DiskBasicDirItem *item, wx
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(sector_buffer, size, basic->IsDataInverted());
-
-		ostream->Write((const void *)temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, sector_buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
@@ -439,7 +437,7 @@ void DiskBasicTypeMZFDOS::GetIdentifiedData(DiskBasicIdentifiedData &data) const
 	if (!sector) {
 		return;
 	}
-	struct st_fat_mz_fdos *f = (struct st_fat_mz_fdos *)sector->GetSectorBuffer();
+	const struct st_fat_mz_fdos *f = (const struct st_fat_mz_fdos *)sector->PeekSectorBuffer();
 	if (!f) {
 		return;
 	}
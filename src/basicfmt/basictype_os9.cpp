@@ -73,27 +73,23 @@ bool OS9AllocMap::AllocMap(DiskBasic *basic, wxUint32 n_map_start_lsn, wxUint32
 /// @param[out] fat : 使用状況
 void OS9AllocMap::MakeAvailable(DiskBasicAvailabillity &fat)
 {
-	wxUint32 bytes = 0;
-	wxUint32 lsn = 0;
+	wxUint32 last_bit = GetLastBit();
+	if (last_bit == INVALID_GROUP_NUMBER) return;
 
-	for(size_t map_idx = 0; map_idx < Count() && bytes < map_bytes; map_idx++) {
-		wxUint8 *buf = Item(map_idx).GetBuffer();
-		int size = (int)Item(map_idx).GetSize();
-
-		for(int pos = 0; pos < size && lsn <= end_lsn && bytes < map_bytes; pos++) {
-			for(int bit = 0; bit < 8 && lsn <= end_lsn && bytes < map_bytes; bit++) {
-				bool used = ((buf[pos] & (0x80 >> bit)) != 0);
-				for(int i=0; i<secs_per_bit && lsn <= end_lsn; i++) {
-					if (!used) {
-						fat.Add(FAT_AVAIL_FREE, sector_size, 1);
-					} else {
-						fat.Add(FAT_AVAIL_USED, 0, 0);
-					}
-					lsn++;
-				}
-			}
-			bytes++;
+	// 同じ値が続く範囲ごとにまとめて追加
+	wxUint32 lsn = 0;
+	for(wxUint32 bit = 0; bit <= last_bit && lsn <= end_lsn; ) {
+		bool used = IsSet(bit);
+		wxUint32 next = FindRunEnd(bit, last_bit);
+		wxUint32 lsns = (next - bit) * (wxUint32)secs_per_bit;
+		if (lsns > end_lsn - lsn + 1) lsns = end_lsn - lsn + 1;
+		if (!used) {
+			fat.Add(FAT_AVAIL_FREE, sector_size, 1, lsns);
+		} else {
+			fat.Add(FAT_AVAIL_USED, 0, 0, lsns);
 		}
+		lsn += lsns;
+		bit = next;
 	}
 }
 
@@ -121,26 +117,26 @@ bool OS9AllocMap::IsUsedLSN(wxUint32 lsn) const
 /// @return LSN or INVALID_GROUP_NUMBER
 wxUint32 OS9AllocMap::FindEmpty() const
 {
-	wxUint32 match_lsn = INVALID_GROUP_NUMBER;
-	wxUint32 bytes = 0;
-	wxUint32 lsn = 0;
-	for(size_t map_idx = 0; map_idx < Count() && bytes < map_bytes && match_lsn == INVALID_GROUP_NUMBER; map_idx++) {
-		wxUint8 *buf = Item(map_idx).GetBuffer();
-		int size = (int)Item(map_idx).GetSize();
-
-		for(int pos = 0; pos < size && lsn <= end_lsn && bytes < map_bytes && match_lsn == INVALID_GROUP_NUMBER; pos++) {
-			for(int bit = 0; bit < 8 && lsn <= end_lsn && bytes < map_bytes && match_lsn == INVALID_GROUP_NUMBER; bit++) {
-				bool used = ((buf[pos] & (0x80 >> bit)) != 0);
-				if (!used) {
-					match_lsn = lsn;
-					break;
-				}
-				lsn += secs_per_bit;
-			}
-			bytes++;
-		}
-	}
-	return match_lsn;
+	wxUint32 last_bit = GetLastBit();
+	if (last_bit == INVALID_GROUP_NUMBER) return INVALID_GROUP_NUMBER;
+
+	wxUint32 bit = Find(0, last_bit, false);
+	if (bit == INVALID_GROUP_NUMBER) return INVALID_GROUP_NUMBER;
+	return bit * (wxUint32)secs_per_bit;
+}
+
+/// Mapで有効な最後のビット位置を返す
+/// @return ビット位置 or INVALID_GROUP_NUMBER
+wxUint32 OS9AllocMap::GetLastBit() const
+{
+	if (secs_per_bit <= 0 || map_bytes == 0) return INVALID_GROUP_NUMBER;
+
+	wxUint32 last_bit = end_lsn / (wxUint32)secs_per_bit;
+	if (last_bit >= map_bytes * 8) last_bit = map_bytes * 8 - 1;
+	wxUint32 bits = GetBitSize();
+	if (bits == 0) return INVALID_GROUP_NUMBER;
+	if (last_bit >= bits) last_bit = bits - 1;
+	return last_bit;
 }
 
 //
@@ -152,6 +148,30 @@ DiskBasicTypeOS9::DiskBasicTypeOS9(DiskBasic *basic, DiskBasicFat *fat, DiskBasi
 	os9_ident = NULL;
 }
 
+/// Ident LSNとして正しそうか
+static bool IsOS9IdentSector(const wxUint8 *data, int size)
+{
+	if (size < (int)sizeof(os9_ident_t)) return false;
+	const os9_ident_t *ident = (const os9_ident_t *)data;
+	if (GET_OS9_LSN(ident->DD_TOT) < 1) return false;
+	if (wxUINT16_SWAP_ON_LE(ident->DD_SPT) == 0) return false;
+	int ival = wxUINT16_SWAP_ON_LE(ident->DD_BIT);
+	return (ival != 0 && Utils::IsPowerOfTwo(ival, 16));
+}
+
+/// 解析前にディスクがこの形式である見込みを簡易判定
+///
+/// 管理トラックまでにIdent LSNらしきセクタがなければ該当しない。
+/// @param [in] disk  ディスク
+/// @param [in] param DISK BASICパラメータ
+/// @return en_probe_results
+int DiskBasicTypeOS9::ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param)
+{
+	int max_track_num = param.GetManagedTrackNumber() + 1;
+	if (max_track_num < 1) max_track_num = 1;
+	return FindSectorOnTopTracks(disk, max_track_num, IsOS9IdentSector) ? PROBE_LIKELY : PROBE_NO;
+}
+
 /// ディスクから各パラメータを取得＆必要なパラメータを計算
 /// @param [in] is_formatting フォーマット中か
 /// @retval 1.0       正常
@@ -231,7 +251,7 @@ double DiskBasicTypeOS9::ParseParamOnDisk(bool is_formatting)
 	if (!sector) {
 		return -1.0;
 	}
-	directory_os9_fd_t *fdd = (directory_os9_fd_t *)sector->GetSectorBuffer();
+	const directory_os9_fd_t *fdd = (const directory_os9_fd_t *)sector->PeekSectorBuffer();
 
 	for(int i = 0; i < 48; i++) {
 		wxUint32 start_lsn = GET_OS9_LSN(fdd->FD_SEG[i].LSN);
@@ -327,7 +347,7 @@ bool DiskBasicTypeOS9::CalcGroupsOnRootDirectory(int start_sector, int end_secto
 	if (!sector) {
 		return false;
 	}
-	directory_os9_fd_t *fdd = (directory_os9_fd_t *)sector->GetSectorBuffer();
+	const directory_os9_fd_t *fdd = (const directory_os9_fd_t *)sector->PeekSectorBuffer();
 	if (!fdd) {
 		return false;
 	}
@@ -51,6 +51,8 @@ private:
 	wxUint32 sector_size;	///< セクタサイズ
 	int secs_per_bit;	///< 1ビット当たりのセクタ数
 
+	wxUint32 GetLastBit() const;
+
 public:
 	OS9AllocMap();
 	~OS9AllocMap();
@@ -107,6 +109,8 @@ public:
 	virtual double 	CheckFat(bool is_formatting);
 	/// @brief ルートディレクトリをアサイン
 	virtual bool	AssignRootDirectory(int start_sector, int end_sector, DiskBasicGroups &group_items, DiskBasicDirItem *dir_item);
+	/// @brief 解析前にディスクがこの形式である見込みを簡易判定
+	static int		ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param);
 	/// @brief ディスクから各パラメータを取得＆必要なパラメータを計算
 	virtual double	ParseParamOnDisk(bool is_formatting);
 	/// @brief Allocation Mapの開始位置を得る（ダイアログ用）
@@ -50,6 +50,15 @@ bool ProDOSBitmap::IsFree(wxUint32 group_num) const
 	return DiskBasicBitMLMap::IsSet(group_num);	// 逆転
 }
 
+/// 範囲内で最初の空き位置を返す
+/// @param[in] start 開始位置
+/// @param[in] end   終了位置(この位置を含む)
+/// @return 位置 / INVALID_GROUP_NUMBER 空きなし
+wxUint32 ProDOSBitmap::FindFree(wxUint32 start, wxUint32 end) const
+{
+	return DiskBasicBitMLMap::Find(start, end, true);	// 逆転
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 // Apple ProDOS 8 / 16 の処理
@@ -95,6 +104,25 @@ double DiskBasicTypeProDOS::CheckFat(bool is_formatting)
 	return valid_ratio;
 }
 
+/// ボリュームディレクトリのヘッダか
+static bool IsProDOSVolumeHeader(const wxUint8 *data, int size)
+{
+	if (size < 4 + (int)sizeof(directory_prodos_t)) return false;
+	const directory_prodos_t *vol = (const directory_prodos_t *)&data[4];
+	return (vol->v.entry_len == (int)sizeof(directory_prodos_t));
+}
+
+/// 解析前にディスクがこの形式である見込みを簡易判定
+///
+/// トラック0にボリュームディレクトリらしきセクタがなければ該当しない。
+/// @param [in] disk  ディスク
+/// @param [in] param DISK BASICパラメータ
+/// @return en_probe_results
+int DiskBasicTypeProDOS::ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param)
+{
+	return FindSectorOnTopTracks(disk, 0, IsProDOSVolumeHeader) ? PROBE_UNKNOWN : PROBE_NO;
+}
+
 /// ディスクから各パラメータを取得＆必要なパラメータを計算
 /// @param [in] is_formatting フォーマット中か
 /// @retval 1.0       正常
@@ -184,7 +212,7 @@ bool DiskBasicTypeProDOS::AssignRootDirectory(int start_sector, int end_sector,
 	// ボリュームヘッダの内容をコピーする
 	DiskBasicGroupItem *gitem = &group_items.Item(0);
 	DiskImageSector *sector = basic->GetSector(gitem->track, gitem->side, gitem->sector_start);
-	directory_t *vol = (directory_t *)sector->GetSectorBuffer(4);
+	const directory_t *vol = (const directory_t *)sector->PeekSectorBuffer(4);
 	dir_item->CopyData(vol);
 	// ディレクトリ属性にしておく
 	dir_item->SetFileAttr(FORMAT_TYPE_UNKNOWN, FILE_TYPE_DIRECTORY_MASK);
@@ -229,7 +257,7 @@ bool DiskBasicTypeProDOS::CalcGroupsOnRootDirectory(int start_sector, int end_se
 				break;
 			}
 			sec_num = sector->GetSectorNumber();
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			if (!buffer) {
 				valid = false;
 				break;
@@ -306,16 +334,27 @@ void DiskBasicTypeProDOS::CalcDiskFreeSize(bool wrote)
 	fat_availability.Empty();
 
 	// BITMAP table
-	for(wxUint32 grp = 0; grp <= basic->GetFatEndGroup(); grp++) {
-		if (grp <= 2) {
-			fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
-		} else if (grp == bitmap.GetMyGroupNumber()) {
+	wxUint32 end_group = basic->GetFatEndGroup();
+	wxUint32 my_group = bitmap.GetMyGroupNumber();
+	int group_size = basic->GetSectorSize() * basic->GetSectorsPerGroup();
+	for(wxUint32 grp = 0; grp <= end_group && grp <= 2; grp++) {
+		fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
+	}
+	// 同じ値が続く範囲ごとにまとめて追加
+	for(wxUint32 grp = 3; grp <= end_group; ) {
+		if (grp == my_group) {
 			fat_availability.Add(FAT_AVAIL_SYSTEM, 0, 0);
-		} else if (bitmap.IsFree(grp)) {
-			fat_availability.Add(FAT_AVAIL_FREE, basic->GetSectorSize() * basic->GetSectorsPerGroup(), 1);
+			grp++;
+			continue;
+		}
+		wxUint32 stop = (grp < my_group && my_group <= end_group ? my_group - 1 : end_group);
+		wxUint32 next = bitmap.FindRunEnd(grp, stop);
+		if (bitmap.IsFree(grp)) {
+			fat_availability.Add(FAT_AVAIL_FREE, group_size, 1, next - grp);
 		} else {
-			fat_availability.Add(FAT_AVAIL_USED, 0, 0);
+			fat_availability.Add(FAT_AVAIL_USED, 0, 0, next - grp);
 		}
+		grp = next;
 	}
 	// Volume directory
 	DiskBasicDirItem *root = dir->GetRootItem();
@@ -360,16 +399,7 @@ wxUint32 DiskBasicTypeProDOS::GetNextGroupNumber(wxUint32 num, int sector_pos)
 /// @return INVALID_GROUP_NUMBER: 空きなし
 wxUint32 DiskBasicTypeProDOS::GetEmptyGroupNumber()
 {
-	wxUint32 new_num = INVALID_GROUP_NUMBER;
-
-	for(wxUint32 grp = 3; grp <= basic->GetFatEndGroup(); grp++) {
-		if (bitmap.IsFree(grp)) {
-			new_num = grp;
-			break;
-		}
-	}
-
-	return new_num;
+	return bitmap.FindFree(3, basic->GetFatEndGroup());
 }
 
 /// 次の空き位置を返す
@@ -642,8 +672,7 @@ int DiskBasicTypeProDOS::AccessFile(int fileunit_num, DiskBasicDirItem *item, wx
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(sector_buffer, size, basic->IsDataInverted());
-		ostream->Write(temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, sector_buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
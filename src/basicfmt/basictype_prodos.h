@@ -31,6 +31,8 @@ public:
 	void Modify(wxUint32 group_num, bool use);
 	/// @brief 指定位置が空いているか
 	bool IsFree(wxUint32 group_num) const;
+	/// @brief 範囲内で最初の空き位置を返す
+	wxUint32 FindFree(wxUint32 start, wxUint32 end) const;
 
 	/// @brief ブロック番号をセット
 	void SetMyGroupNumber(wxUint32 group_num) { m_group_num = group_num; }
@@ -91,6 +93,8 @@ public:
 	//@{
 	/// @brief FATエリアをチェック
 	virtual double 	CheckFat(bool is_formatting);
+	/// @brief 解析前にディスクがこの形式である見込みを簡易判定
+	static int		ProbeParamOnDisk(DiskImageDisk *disk, const DiskBasicParam &param);
 	/// @brief ディスクから各パラメータを取得＆必要なパラメータを計算
 	virtual double	ParseParamOnDisk(bool is_formatting);
 	/// @brief Allocation Mapの開始位置を得る（ダイアログ用）
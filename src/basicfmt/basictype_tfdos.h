@@ -79,6 +79,8 @@ public:
 	//@{
 	/// @brief データの読み込み/比較処理
 	virtual int		AccessFile(int fileunit_num, DiskBasicDirItem *item, wxInputStream *istream, wxOutputStream *ostream, const wxUint8 *sector_buffer, int sector_size, int remain_size, int sector_num, int sector_end);
+	/// @brief エクスポートする際に内容の変換が必要か ベリファイ用にBASEコンパチかを判定するので常に必要
+	virtual bool	NeedConvertDataForLoad(DiskBasicDirItem *item) const { return true; }
 	/// @brief 内部ファイルをエクスポートする際に内容を変換
 	virtual bool	ConvertDataForLoad(DiskBasicDirItem *item, wxInputStream &istream, wxOutputStream &ostream);
 	/// @brief エクスポートしたファイルをベリファイする際に内容を変換
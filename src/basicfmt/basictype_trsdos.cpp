@@ -79,6 +79,39 @@ void TRSDOS_GAT::GetPos(wxUint32 num, wxUint32 &pos, wxUint32 &bit) const
 	bit = num % m_groups_per_track;
 }
 
+/// 範囲内で最初にリセットされている位置を返す
+///
+/// 1トラック分(1バイト)ずつまとめて調べる。
+/// @param[in] start 開始位置
+/// @param[in] end   終了位置(この位置を含む)
+/// @param[in] lock  同じ位置もリセットされている必要があるテーブル(TLT) NULL可
+/// @return 位置 / INVALID_GROUP_NUMBER なし
+wxUint32 TRSDOS_GAT::FindClear(wxUint32 start, wxUint32 end, const TRSDOS_GAT *lock) const
+{
+	if (!m_buffer || m_groups_per_track <= 0 || m_groups_per_track > 8 || start > end) {
+		return INVALID_GROUP_NUMBER;
+	}
+	wxUint32 gpt = (wxUint32)m_groups_per_track;
+	wxUint32 full = (1U << gpt) - 1;
+	wxUint32 first = start / gpt;
+	wxUint32 last = end / gpt;
+	for(wxUint32 pos = first; pos <= last && pos < (wxUint32)m_size; pos++) {
+		wxUint32 used = m_buffer[pos];
+		if (lock && lock->m_buffer && pos < (wxUint32)lock->m_size) {
+			used |= lock->m_buffer[pos];
+		}
+		wxUint32 free = (~used & full);
+		if (pos == first) {
+			free &= (full << (start % gpt));
+		}
+		if (free != 0) {
+			wxUint32 num = pos * gpt + (wxUint32)Utils::CountTrailingZeros(free);
+			return (num <= end ? num : INVALID_GROUP_NUMBER);
+		}
+	}
+	return INVALID_GROUP_NUMBER;
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 // TRSDOS HIT
@@ -183,7 +216,7 @@ double DiskBasicTypeTRSDOS::ParseParamOnDisk(bool is_formatting)
 	if (!sector) {
 		return -1.0;
 	}
-	trsdos_gat_t *gat_sector = (trsdos_gat_t *)sector->GetSectorBuffer();
+	const trsdos_gat_t *gat_sector = (const trsdos_gat_t *)sector->PeekSectorBuffer();
 	wxString volname(gat_sector->name, sizeof(gat_sector->name));
 	if (!volname.IsAscii()) {
 		return -1.0;
@@ -251,7 +284,7 @@ bool DiskBasicTypeTRSDOS::CalcGroupsOnRootDirectory(int start_sector, int end_se
 				break;
 			}
 			sec_num = sector->GetSectorNumber();
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			if (!buffer) {
 				valid = false;
 				break;
@@ -393,12 +426,14 @@ wxUint32 DiskBasicTypeTRSDOS::GetEmptyGroupNumber()
 
 	wxUint32 mng_grp_sta = basic->GetManagedTrackNumber() * basic->GetGroupsPerTrack();
 	wxUint32 mng_grp_end = mng_grp_sta + basic->GetGroupsPerTrack() - 1;
+	wxUint32 end_grp = basic->GetFatEndGroup();
 
-	for(wxUint32 grp = 0; grp <= basic->GetFatEndGroup(); grp++) {
-		if ((grp < mng_grp_sta || mng_grp_end < grp) && !IsUsedGroupNumber(grp)) {
-			new_num = grp;
-			break;
-		}
+	// 管理トラックの前後でGATとTLTの両方が空いている位置をさがす
+	if (mng_grp_sta > 0) {
+		new_num = gat_table.FindClear(0, mng_grp_sta - 1 < end_grp ? mng_grp_sta - 1 : end_grp, &tlt_table);
+	}
+	if (new_num == INVALID_GROUP_NUMBER && mng_grp_end < end_grp) {
+		new_num = gat_table.FindClear(mng_grp_end + 1, end_grp, &tlt_table);
 	}
 	return new_num;
 }
@@ -517,8 +552,7 @@ int DiskBasicTypeTRSDOS::AccessFile(int fileunit_num, DiskBasicDirItem *item, wx
 
 	if (ostream) {
 		// 書き出し
-		temp.SetData(sector_buffer, size, basic->IsDataInverted());
-		ostream->Write(temp.GetData(), temp.GetSize());
+		WriteDataToStream(ostream, sector_buffer, size);
 	}
 	if (istream) {
 		// 読み込んで比較
@@ -944,7 +978,7 @@ void DiskBasicTypeTRSDOS::GetIdentifiedData(DiskBasicIdentifiedData &data) const
 	if (!sector) {
 		return;
 	}
-	trsdos_gat_t *gat_sector = (trsdos_gat_t *)sector->GetSectorBuffer();
+	const trsdos_gat_t *gat_sector = (const trsdos_gat_t *)sector->PeekSectorBuffer();
 
 	// volume name
 	wxString wname;
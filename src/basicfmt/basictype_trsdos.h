@@ -34,6 +34,8 @@ public:
 	bool IsSet(wxUint32 num) const;
 	/// @brief 指定位置のビット位置を計算
 	void GetPos(wxUint32 num, wxUint32 &pos, wxUint32 &bit) const;
+	/// @brief 範囲内で最初にリセットされている位置を返す
+	wxUint32 FindClear(wxUint32 start, wxUint32 end, const TRSDOS_GAT *lock) const;
 	/// @brief バッファを返す
 	wxUint8 *GetBuffer() { return m_buffer; }
 	/// @brief バッファサイズを返す
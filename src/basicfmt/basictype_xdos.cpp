@@ -528,7 +528,7 @@ void DiskBasicTypeXDOS::GetIdentifiedData(DiskBasicIdentifiedData &data) const
 	DiskImageSector *sector = basic->GetSectorFromSectorPos(basic->GetDirStartSector() - 1);
 	if (sector) {
 		wxString dst;
-		basic->GetCharCodes().ConvToString(sector->GetSectorBuffer(), VOLUME_NAME_LENGTH, dst, 0);
+		basic->GetCharCodes().ConvToString(sector->PeekSectorBuffer(), VOLUME_NAME_LENGTH, dst, 0);
 		data.SetVolumeName(dst);
 		data.SetVolumeNameMaxLength(VOLUME_NAME_LENGTH);
 	}
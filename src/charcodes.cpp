@@ -9,6 +9,7 @@
 #include <wx/xml/xml.h>
 #include <wx/translation.h>
 #include "utils.h"
+#include "xmldoccache.h"
 
 
 CharCodeMaps	gCharCodeMaps;
@@ -66,6 +67,31 @@ CharCodeMap::~CharCodeMap()
 	list.Empty();
 }
 
+/// 検索用の索引を作成する
+/// 同じ文字コード、文字が複数ある時はリストの先にあるものを優先する
+void CharCodeMap::Initialize()
+{
+	for(int i=0; i<256; i++) {
+		heads[i].Empty();
+	}
+	strs.clear();
+
+	for(size_t i=0; i<list.Count(); i++) {
+		CharCode *itm = list.Item(i);
+		if (itm->code_len == 0) {
+			// コードなしはどのバイトにも一致する
+			for(int n=0; n<256; n++) {
+				heads[n].Add(itm);
+			}
+		} else {
+			heads[itm->code[0]].Add(itm);
+		}
+		if (strs.find(itm->str) == strs.end()) {
+			strs[itm->str] = itm;
+		}
+	}
+}
+
 /// 文字コードが文字変換テーブルにあるか
 /// @param [in]  src         : 文字コード(1～2バイト)
 /// @param [in]  remain      : srcの残りバイト数
@@ -79,8 +105,10 @@ size_t CharCodeMap::FindString(const wxUint8 *src, size_t remain, wxString &dst,
 
 	if (remain == 0) return len;
 
-	for(size_t i=0; i<list.Count(); i++) {
-		CharCode *itm = list.Item(i);
+	// 先頭バイトが一致するものだけ比較する
+	const CharCodeList &cands = heads[src[0]];
+	for(size_t i=0; i<cands.Count(); i++) {
+		CharCode *itm = cands.Item(i);
 		if (memcmp(itm->code, src, itm->code_len) == 0) {
 			dst += itm->str;
 			len = itm->code_len;
@@ -109,16 +137,14 @@ size_t CharCodeMap::FindString(const wxUint8 *src, size_t remain, wxString &dst,
 bool CharCodeMap::FindCode(const wxString &src, wxUint8 *dst, size_t &pos)
 {
 	bool match = false;
-	for(size_t i=0; i<list.Count(); i++) {
-		CharCode *itm = list.Item(i);
-		if (itm->str == src) {
-			if (dst) {
-				memcpy(&dst[pos], itm->code, itm->code_len);
-			}
-			pos += itm->code_len;
-			match = true;
-			break;
+	CharCodeHash::iterator it = strs.find(src);
+	if (it != strs.end()) {
+		CharCode *itm = it->second;
+		if (dst) {
+			memcpy(&dst[pos], itm->code, itm->code_len);
 		}
+		pos += itm->code_len;
+		match = true;
 	}
 	if (!match) {
 		wxScopedCharBuffer p = src.To8BitData();
@@ -156,6 +182,7 @@ CharCodeMapMB::~CharCodeMapMB()
 }
 void CharCodeMapMB::Initialize()
 {
+	CharCodeMap::Initialize();
 	cs = new wxCSConv((wxFontEncoding)font_encoding);
 }
 
@@ -589,7 +616,7 @@ bool CharCodes::Load(const wxString &data_path, const wxString &locale_name, wxS
 {
 	wxXmlDocument doc;
 
-	if (!doc.Load(data_path + wxT("char_codes.xml"))) return false;
+	if (!gXmlDocCache.LoadDocument(doc, data_path + wxT("char_codes.xml"))) return false;
 
 	// start processing the XML file
 	if (doc.GetRoot()->GetName() != "CharCodes") return false;
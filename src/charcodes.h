@@ -12,6 +12,7 @@
 #include <wx/string.h>
 #include <wx/dynarray.h>
 #include <wx/arrstr.h>
+#include <wx/hashmap.h>
 
 class wxCSConv;
 
@@ -39,6 +40,11 @@ public:
 /// @sa CharCode , CharCodeMap
 WX_DEFINE_ARRAY(CharCode *, CharCodeList);
 
+/// @class CharCodeHash
+///
+/// @brief 文字からCharCodeを引くハッシュ
+WX_DECLARE_STRING_HASH_MAP(CharCode *, CharCodeHash);
+
 /// @brief キャラクターコード変換マップ
 ///
 /// @sa CharCodeList, CharCode
@@ -51,6 +57,9 @@ protected:
 	int          font_encoding;
 	wxString	 description;
 
+	CharCodeList heads[256];	///< 先頭バイトごとのリスト(文字コード→文字用)
+	CharCodeHash strs;			///< 文字→文字コード用
+
 	CharCodeMap(const CharCodeMap &) {}
 
 public:
@@ -59,7 +68,8 @@ public:
 	CharCodeMap(const wxString &n_name, int n_type);
 	virtual ~CharCodeMap();
 
-	virtual void Initialize() {}
+	/// @brief 検索用の索引を作成する
+	virtual void Initialize();
 
 	/// @brief マップ名を返す
 	const wxString &GetName() const { return name; }
@@ -96,6 +106,7 @@ public:
 	CharCodeMapMB(const wxString &n_name, int n_type);
 	virtual ~CharCodeMapMB();
 
+	/// @brief 変換クラスを作成する
 	virtual void Initialize();
 
 	/// @brief 文字コード１文字を(SJIS)を文字列に変換する
@@ -240,6 +251,8 @@ public:
 	void SetMap(const wxString &name);
 	/// @brief マップを設定
 	void SetMap(int idx);
+	/// @brief 設定しているマップを返す
+	const CharCodeMap *GetMap() const { return cache; }
 };
 
 extern CharCodeMaps		gCharCodeMaps;
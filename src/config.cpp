@@ -36,6 +36,7 @@ Params::Params()
 	mShowInterDirItem = false;
 #endif
 	mCheckSideNumber = false;
+	mMapFileOnOpen = false;
 	mDirDepth = 20;
 	mWindowWidth = 1000;
 	mWindowHeight = 600;
@@ -182,6 +183,8 @@ void Config::Load()
 	ini->Read(wxT("ShowInterDirItem"), &mShowInterDirItem);
 	// オープン時サイド番号をチェックするか
 	ini->Read(wxT("CheckSideNumber"), &mCheckSideNumber);
+	// オープン時ファイルをメモリにマッピングするか
+	ini->Read(wxT("MapFileOnOpen"), &mMapFileOnOpen);
 	// 一度に処理できるディレクトリの深さ
 	ival = 0;
 	ini->Read(wxT("DirectoriesDepth"), &ival);
@@ -271,6 +274,8 @@ void Config::Save()
 	ini->Write(wxT("ShowInterDirItem"), mShowInterDirItem);
 	// オープン時サイド番号をチェックするか
 	ini->Write(wxT("CheckSideNumber"), mCheckSideNumber);
+	// オープン時ファイルをメモリにマッピングするか
+	ini->Write(wxT("MapFileOnOpen"), mMapFileOnOpen);
 	// 一度に処理できるディレクトリの深さ
 	ini->Write(wxT("DirectoriesDepth"), mDirDepth);
 	// ウィンドウ幅
@@ -38,6 +38,7 @@ protected:
 	bool		mCurrentDateImport;	///< インポート時に現在日時を設定するか
 	bool		mShowInterDirItem;	///< プロパティで内部データをリストで表示するか
 	bool		mCheckSideNumber;	///< オープン時サイド番号をチェックするか
+	bool		mMapFileOnOpen;		///< オープン時ファイルをメモリにマッピングするか
 	int			mDirDepth;			///< 一度に処理できるディレクトリの深さ
 	int			mWindowWidth;		///< ウィンドウ幅
 	int			mWindowHeight;		///< ウィンドウ高さ
@@ -91,6 +92,8 @@ public:
 	bool			DoesShowInterDirItem() const { return mShowInterDirItem; }
 	void			CheckSideNumber(bool val) { mCheckSideNumber = val; }
 	bool			DoesCheckSideNumber() const { return mCheckSideNumber; }
+	void			MapFileOnOpen(bool val) { mMapFileOnOpen = val; }
+	bool			DoesMapFileOnOpen() const { return mMapFileOnOpen; }
 	void			SetDirDepth(int val) { mDirDepth = val; }
 	int				GetDirDepth() const { return mDirDepth; }
 	void			SetWindowWidth(int val) { mWindowWidth = val; }
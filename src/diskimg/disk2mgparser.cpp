@@ -95,6 +95,15 @@ int Disk2MGParser::Parse(wxInputStream &istream, const DiskParam *disk_param)
 	return rc;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int Disk2MGParser::Probe(const DiskProbeData &data)
+{
+	return data.Match(0, DISK_2MG_HEADER, 4) ? PROBE_SIGNATURE : PROBE_NO;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @param [in] disk_hints    ディスクパラメータヒント("2D"など)
@@ -64,6 +64,27 @@ int DiskADCParser::Parse(wxInputStream &istream, const DiskParam *disk_param)
 	return DiskPlainParser::Parse(istream, disk_param);
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_LIKELY ヘッダの内容がファイルサイズと一致
+/// @retval PROBE_NO     該当しない
+int DiskADCParser::Probe(const DiskProbeData &data)
+{
+	adc_header_t header;
+	if (!data.Copy(0, &header, sizeof(header))) {
+		// too short
+		return PROBE_NO;
+	}
+	if ((size_t)header.label_length > sizeof(header.label) || ((size_t)header.label_length < sizeof(header.label) && header.label[header.label_length] != 0)) {
+		return PROBE_NO;
+	}
+	wxUint32 file_size = (wxUint32)sizeof(header) + wxUINT32_SWAP_ON_LE(header.data_size) + wxUINT32_SWAP_ON_LE(header.resource_size);
+	if (file_size != (wxUint32)data.GetFileSize()) {
+		return PROBE_NO;
+	}
+	return PROBE_LIKELY;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @param [in] disk_hints    ディスクパラメータヒント("2D"など)
@@ -83,8 +104,8 @@ int DiskADCParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 		p_result->SetError(DiskResult::ERRV_DISK_TOO_SMALL, 0);
 		return p_result->GetValid();
 	}
-	// ラベル長の末尾が0かどうか
-	if ((size_t)header.label_length > sizeof(header.label) || header.label[header.label_length] != 0) {
+	// ラベル長の末尾が0かどうか(最大長のときは終端なし)
+	if ((size_t)header.label_length > sizeof(header.label) || ((size_t)header.label_length < sizeof(header.label) && header.label[header.label_length] != 0)) {
 		// not disk
 		p_result->SetError(DiskResult::ERRV_INVALID_DISK, 0);
 		return p_result->GetValid();
@@ -156,6 +156,15 @@ size_t DiskCQMParser::ExpandData(wxInputStream &istream, wxOutputStream &ostream
 	return size;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskCQMParser::Probe(const DiskProbeData &data)
+{
+	return data.Match(0, "CQ\x14", 3) ? PROBE_SIGNATURE : PROBE_NO;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @param [in] disk_hints    ディスクパラメータヒント("2D"など)
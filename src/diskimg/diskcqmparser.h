@@ -36,6 +36,8 @@ public:
 	DiskCQMParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskCQMParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// チェック
 	int Check(wxInputStream &istream, const DiskTypeHints *disk_hints, const DiskParam *disk_param, DiskParamPtrs &disk_params, DiskParam &manual_param);
 	/// 解析
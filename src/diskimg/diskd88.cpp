@@ -14,6 +14,9 @@
 #include "../basicfmt/basicparam.h"
 #include "../basicfmt/basicfmt.h"
 #include "../utils.h"
+#if wxUSE_THREADS
+#include <wx/thread.h>
+#endif
 
 
 /// disk density 0: 2D, 1: 2DD, 2: 2HD, 3: 1DD(unofficial)
@@ -25,6 +28,11 @@ const struct st_disk_density gDiskDensity[] = {
 	{ 0xff, NULL }
 };
 
+#if wxUSE_THREADS
+/// セクタへの書き込み開始を排他する
+static wxCriticalSection gD88SectorWriteLock;
+#endif
+
 static const wxUint8 *c_ibm_mfm_ids[] = {
 	(const wxUint8 *)"\xa1\xa1\xa1\xfe",	// address mark
 	(const wxUint8 *)"\xa1\xa1\xa1\xfb",	// data mark
@@ -218,40 +226,57 @@ DiskD88Sector::DiskD88Sector()
 	: DiskImageSector()
 {
 	data = NULL;
+	m_shared_data = false;
 	data_origin = NULL;
+	m_bound = false;
+	m_settled = false;
 
 	m_rec_crc = -1;
 }
 
 /// ファイルから読み込み用
-DiskD88Sector::DiskD88Sector(int n_num, const DiskImageSectorHeader &n_header, wxUint8 *n_data)
+/// @param[in] n_num         セクタ番号
+/// @param[in] n_header      セクタヘッダ
+/// @param[in] n_data        セクタデータ
+/// @param[in] n_shared_data n_dataがディスクの領域にあるか
+DiskD88Sector::DiskD88Sector(int n_num, const DiskImageSectorHeader &n_header, wxUint8 *n_data, bool n_shared_data)
 	: DiskImageSector(n_num)
 {
 	m_header.New(n_header);
 	data = n_data;
+	m_shared_data = (n_data && n_shared_data);
 
 	m_header_origin.New(n_header);
-	data_origin = new wxUint8[m_header.GetSize()];
-	memcpy(data_origin, data, m_header.GetSize());
+	data_origin = NULL;
+	m_bound = false;
+	m_settled = true;
 
 	m_rec_crc = -1;
 }
 
 /// 新規作成用
-DiskD88Sector::DiskD88Sector(int track_number, int side_number, int sector_number, int sector_size, int number_of_sector, bool single_density, int status)
+/// @param[in] n_shared_data ディスクの領域から確保したバッファ(0クリア済み) NULLなら自分で確保する
+DiskD88Sector::DiskD88Sector(int track_number, int side_number, int sector_number, int sector_size, int number_of_sector, bool single_density, int status, wxUint8 *n_shared_data)
 	: DiskImageSector(sector_number)
 {
 	m_header.New(track_number, side_number, sector_number, sector_size, number_of_sector, single_density, status);
-	this->SetSectorSize(sector_size);
+	m_header.SetIDN(ConvSecSizeToIDN(sector_size));
 
-	data = new wxUint8[m_header.GetSize()];
-	memset(data, 0, m_header.GetSize());
+	if (n_shared_data) {
+		data = n_shared_data;
+		m_shared_data = true;
+	} else {
+		data = new wxUint8[m_header.GetSize()];
+		memset(data, 0, m_header.GetSize());
+		m_shared_data = false;
+	}
 
 //	m_header_origin.Fill(0xff);
 	m_header_origin.New(m_header);
 
-	data_origin = new wxUint8[m_header.GetSize()];
-	memset(data_origin, 0, m_header.GetSize());
+	data_origin = NULL;
+	m_bound = false;
+	m_settled = false;
 
 	m_rec_crc = -1;
 
@@ -261,7 +286,9 @@ DiskD88Sector::DiskD88Sector(int track_number, int side_number, int sector_numbe
 DiskD88Sector::~DiskD88Sector()
 {
 	delete [] data_origin;
-	delete [] data;
+	if (!m_shared_data) {
+		delete [] data;
+	}
 	m_header_origin.Free();
 	m_header.Free();
 }
@@ -273,16 +300,18 @@ bool DiskD88Sector::Replace(DiskImageSector *src_sector)
 	if (!data) {
 		return false;
 	}
-	wxUint8 *src_data = src_sector->GetSectorBuffer();
+	const wxUint8 *src_data = src_sector->PeekSectorBuffer();
 	if (!src_data) {
 		// データなし
 		return false;
 	}
 	size_t sz = src_sector->GetSectorBufferSize() > GetSectorBufferSize() ? GetSectorBufferSize() : src_sector->GetSectorBufferSize();
 	if (sz > 0) {
+		KeepOrigin();
 		memset(data, 0, GetSectorBufferSize());
 		memcpy(data, src_data, sz);
-//		SetModify();
+		SetModify();
+		IncreaseWriteGeneration();
 	}
 	return true;
 }
@@ -306,8 +335,10 @@ bool DiskD88Sector::Fill(wxUint8 code, int len, int start)
 
 	if (len < 0) len = (int)m_header.GetSize() - start;
 	else if ((start + len) > (int)m_header.GetSize()) len = (int)m_header.GetSize() - start;
+	KeepOrigin();
 	memset(&data[start], code, len);
-//	SetModify();
+	SetModify();
+	IncreaseWriteGeneration();
 	return true;
 }
 
@@ -329,8 +360,10 @@ bool DiskD88Sector::Copy(const void *buf, int len, int start)
 	}
 
 	if ((start + len) > (int)m_header.GetSize()) len = (int)m_header.GetSize() - start;
+	KeepOrigin();
 	memcpy(&data[start], buf, len);
-//	SetModify();
+	SetModify();
+	IncreaseWriteGeneration();
 	return true;
 }
 
@@ -396,38 +429,81 @@ int DiskD88Sector::ModifySectorSize(int size)
 		wxUint8 *newdata = new wxUint8[size];
 		memset(newdata, 0, size);
 		memcpy(newdata, data, size < m_header.GetSize() ? size : m_header.GetSize());
-		delete [] data;
+		// ディスクの領域にあるデータは解放しない
+		if (!m_shared_data) {
+			delete [] data;
+		}
 		data = newdata;
-
-		newdata = new wxUint8[size];
-		memset(newdata, 0, size);
-		memcpy(newdata, data_origin, size < m_header.GetSize() ? size : m_header.GetSize());
-		delete [] data_origin;
-		data_origin = newdata;
+		m_shared_data = false;
+
+		if (data_origin) {
+			newdata = new wxUint8[size];
+			memset(newdata, 0, size);
+			memcpy(newdata, data_origin, size < m_header.GetSize() ? size : m_header.GetSize());
+			delete [] data_origin;
+			data_origin = newdata;
+		}
 
 		m_header.SetSize((wxUint16)size);
 		SetSectorSize(size);
 
-//		SetModify();
+		SetModify();
+		IncreaseWriteGeneration();
+		// バッファの位置を保持している側に変更を伝える
+		InvalidateParentIndex();
 	}
 	return diff;
 }
 
-/// 変更済みを設定
-void DiskD88Sector::SetModify()
+/// マッピングしたファイルの領域にあるデータは書き込み前に複製する
+/// マッピングした領域は読み込み専用
+void DiskD88Sector::DetachMappedData()
+{
+	if (!m_shared_data || !data || !parent) return;
+	DiskImageDisk *disk = parent->GetDisk();
+	if (!disk || !disk->IsSectorBufferMapped(data)) return;
+
+	wxUint8 *newdata = new wxUint8[m_header.GetSize()];
+	memcpy(newdata, data, m_header.GetSize());
+	data = newdata;
+	m_shared_data = false;
+}
+
+/// 書き込み前に変更前のデータを保持する
+/// 一度も書き込みのないセクタや保存前の新規セクタは変更前のデータを持たない
+void DiskD88Sector::KeepOrigin()
 {
-//	modified = (memcmp(&header_origin, &header, sizeof(header)) != 0);
-//	if (!modified && data && data_origin) {
-//		modified = (memcmp(data_origin, data, header_origin.size) != 0);
-//	}
+	DetachMappedData();
+	if (data_origin || !data || !m_settled) return;
+	data_origin = new wxUint8[m_header.GetSize()];
+	memcpy(data_origin, data, m_header.GetSize());
+}
+
+/// 書き込み前に変更前のデータを保持して変更済みにする
+/// 渡したポインタからいつ書き込まれるかわからないので以後は常に比較対象とする
+/// @note DISK BASICの判定では複数スレッドから同じセクタのバッファを得るので排他する
+void DiskD88Sector::PrepareWrite()
+{
+#if wxUSE_THREADS
+	wxCriticalSectionLocker locker(gD88SectorWriteLock);
+#endif
+	m_bound = true;
+	KeepOrigin();
+	SetModify();
+	IncreaseWriteGeneration();
 }
 
 /// 変更されているか
+/// 書き込みのなかったセクタは比較しない
 bool DiskD88Sector::IsModified() const
 {
-	if (!data) {
+	if (!data || !m_dirty) {
 		return false;
 	}
+	if (!m_settled) {
+		// 保存前の新規セクタは比較するデータがない
+		return true;
+	}
 //	bool mod = (memcmp(&header_origin, header, sizeof(d88_sector_header_t)) != 0);
 	bool mod = !m_header_origin.IsSame(m_header);
 	if (!mod && data && data_origin) {
@@ -444,17 +520,28 @@ void DiskD88Sector::ClearModify()
 	}
 	m_header_origin.Copy(m_header);
 //	memcpy(&header_origin, header, sizeof(d88_sector_header_t));
-	if (data && data_origin) {
-		memcpy(data_origin, data, m_header_origin.GetSize());
+	m_settled = true;
+	if (m_bound) {
+		// 保持したポインタから書き込まれるので変更前のデータを更新して書き込みありのままにする
+		if (data_origin) {
+			memcpy(data_origin, data, m_header.GetSize());
+		} else {
+			KeepOrigin();
+		}
+		return;
 	}
-//	modified = false;
+	// 次の書き込みまで変更前のデータは不要
+	delete [] data_origin;
+	data_origin = NULL;
+	DiskImageSector::ClearModify();
 }
 /// セクタ番号を設定
 void DiskD88Sector::SetSectorNumber(int val)
 {
 	DiskImageSector::SetSectorNumber(val);
 	m_header.SetIDR((wxUint8)val);
-
+	SetModify();
+	InvalidateParentIndex();
 }
 /// 削除マークがついているか
 bool DiskD88Sector::IsDeleted() const
@@ -465,6 +552,8 @@ bool DiskD88Sector::IsDeleted() const
 void DiskD88Sector::SetDeletedMark(bool val)
 {
 	m_header.SetDeleted(val ? 0x10 : 0);
+	SetModify();
+	InvalidateParentIndex();
 }
 /// 同じセクタか
 /// @param[in] sector_number セクタ番号
@@ -494,6 +583,7 @@ int DiskD88Sector::GetSectorSize() const
 void DiskD88Sector::SetSectorSize(int val)
 {
 	m_header.SetIDN(ConvSecSizeToIDN(val));
+	SetModify();
 }
 
 /// セクタサイズ（バッファのサイズ）を返す
@@ -508,8 +598,22 @@ int DiskD88Sector::GetSize() const
 	return (int)sizeof(d88_sector_header_t) + GetSectorBufferSize();
 }
 
+/// セクタデータへのポインタを返す
+wxUint8 *DiskD88Sector::GetSectorBuffer()
+{
+	PrepareWrite();
+	return data;
+}
+
 /// セクタデータへのポインタを返す
 wxUint8 *DiskD88Sector::GetSectorBuffer(int offset)
+{
+	PrepareWrite();
+	return (data && offset < m_header.GetSize() ? &data[offset] : NULL);
+}
+
+/// 読み込み専用でセクタデータへのポインタを返す
+const wxUint8 *DiskD88Sector::PeekSectorBuffer(int offset) const
 {
 	return (data && offset < m_header.GetSize() ? &data[offset] : NULL);
 }
@@ -523,7 +627,10 @@ wxUint16 DiskD88Sector::GetSectorsPerTrack() const
 /// セクタ数を設定
 void DiskD88Sector::SetSectorsPerTrack(wxUint16 val)
 {
+	// 保存時に毎回揃えるので同じなら変更しない
+	if (m_header.GetNumberOfSectors() == val) return;
 	m_header.SetNumberOfSectors(val);
+	SetModify();
 }
 
 /// セクタのステータスを返す
@@ -536,6 +643,19 @@ wxUint8 DiskD88Sector::GetSectorStatus() const
 void DiskD88Sector::SetSectorStatus(wxUint8 val)
 {
 	m_header.SetStatus(val);
+	SetModify();
+}
+
+/// ディスクの領域が移動したのでセクタデータの位置を移す
+/// @param[in] old_base 移動前の領域
+/// @param[in] size     領域のサイズ
+/// @param[in] new_base 移動後の領域
+void DiskD88Sector::RelocateSharedData(const wxUint8 *old_base, size_t size, wxUint8 *new_base)
+{
+	if (!m_shared_data || !data) return;
+	if (old_base <= data && data < old_base + size) {
+		data = new_base + (data - old_base);
+	}
 }
 
 /// ID Cを返す
@@ -563,21 +683,25 @@ wxUint8	DiskD88Sector::GetIDN() const
 void DiskD88Sector::SetIDC(wxUint8 val)
 {
 	m_header.SetIDC(val);
+	SetModify();
 }
 /// ID Hを設定
 void DiskD88Sector::SetIDH(wxUint8 val)
 {
 	m_header.SetIDH(val);
+	SetModify();
 }
 /// ID Rを設定
 void DiskD88Sector::SetIDR(wxUint8 val)
 {
 	m_header.SetIDR(val);
+	SetModify();
 }
 /// ID Nを設定
 void DiskD88Sector::SetIDN(wxUint8 val)
 {
 	m_header.SetIDN(val);
+	SetModify();
 }
 
 /// 単密度か
@@ -588,6 +712,8 @@ bool DiskD88Sector::IsSingleDensity()
 void DiskD88Sector::SetSingleDensity(bool val)
 {
 	m_header.SetDensity(val ? 0x40 : 0);
+	SetModify();
+	InvalidateParentIndex();
 }
 
 /// CRCを返す
@@ -609,25 +735,20 @@ int DiskD88Sector::CalculateCRC()
 	const wxUint8 *p;
 	if (m_header.GetDensity()) {
 		p = m_header.GetDeleted() ? c_ibm_fm_ids[2] : c_ibm_fm_ids[1];
-		crc = Utils::CRC16(*p, crc);
+		crc = Utils::CRC16(p, 1, crc);
 	} else {
 		p = m_header.GetDeleted() ? c_ibm_mfm_ids[2] : c_ibm_mfm_ids[1];
-		for(int i=0; i<4; i++) {
-			crc = Utils::CRC16(*p, crc);
-			p++;
-		}
+		crc = Utils::CRC16(p, 4, crc);
 	}
 	//
 	int ssiz = 128 << m_header.GetIDN();
 	if (ssiz > (int)m_header.GetSize()) ssiz = (int)m_header.GetSize();
-	p = GetSectorBuffer();
+	// 計算するだけなので書き込みとはみなさない
+	p = PeekSectorBuffer();
 	if (!p || ssiz <= 0) {
 		return -1;
 	}
-	for(int i=0; i<ssiz; i++) {
-		crc = Utils::CRC16(*p, crc);
-		p++;
-	}
+	crc = Utils::CRC16(p, (size_t)ssiz, crc);
 	return crc;
 }
 
@@ -655,14 +776,18 @@ DiskD88Track::~DiskD88Track()
 }
 
 /// インスタンス作成
+/// @note n_data はnewで確保するか、ディスクの領域から確保しておくこと
 DiskImageSector *DiskD88Track::NewImageSector(int n_num, const DiskImageSectorHeader &n_header, wxUint8 *n_data)
 {
-	return new DiskD88Sector(n_num, n_header, n_data);
+	bool shared = (parent && parent->IsSectorBufferInArena(n_data));
+	return new DiskD88Sector(n_num, n_header, n_data, shared);
 }
 /// インスタンス作成
+/// セクタデータはディスクの領域から確保する
 DiskImageSector *DiskD88Track::NewImageSector(int track_number, int side_number, int sector_number, int sector_size, int number_of_sector, bool single_density, int status)
 {
-	return new DiskD88Sector(track_number, side_number, sector_number, sector_size, number_of_sector, single_density, status);
+	wxUint8 *buf = (parent && sector_size > 0 ? parent->AllocSectorBuffer(sector_size) : NULL);
+	return new DiskD88Sector(track_number, side_number, sector_number, sector_size, number_of_sector, single_density, status, buf);
 }
 
 // ----------------------------------------------------------------------
@@ -850,6 +975,7 @@ DiskD88Disk::DiskD88Disk(DiskImageFile *file, int n_num, const DiskParam &n_para
 	m_header.SetWriteProtect(n_write_protect);
 
 	m_modified = true;
+	m_dirty = true;
 }
 
 /// @param[in] file ファイルイメージ
@@ -889,6 +1015,9 @@ DiskImageTrack *DiskD88Disk::NewImageTrack(int n_trk_num, int n_sid_num, int n_o
 void DiskD88Disk::SetModify()
 {
 	m_modified = !m_header_origin.IsSame(m_header);
+	if (m_modified) {
+		DiskImageDisk::SetModify();
+	}
 }
 
 /// 変更済みをクリア
@@ -134,19 +134,29 @@ class DiskD88Sector : public DiskImageSector
 private:
 	DiskD88SectorHeader	 m_header;		///< sector header
 	wxUint8 			*data;			///< sector data
+	bool				 m_shared_data;	///< dataがディスクの領域にあるか(自分で解放しない)
 
 	DiskD88SectorHeader	 m_header_origin;	///< pre-save header
-	wxUint8				*data_origin;		///< pre-save data
+	wxUint8				*data_origin;		///< pre-save data (最初の書き込み時に確保)
+	bool				 m_bound;			///< 書き込み用のバッファを渡したか(保持したポインタから書き込まれる)
+	bool				 m_settled;			///< 読み込み済みまたは保存済みか(新規セクタは変更前のデータを持たない)
 
 	int					 m_rec_crc;		///< recorded CRC
 
+	/// マッピングしたファイルの領域にあるデータは書き込み前に複製する
+	void	DetachMappedData();
+	/// 書き込み前に変更前のデータを保持する
+	void	KeepOrigin();
+	/// 書き込み前に変更前のデータを保持して変更済みにする
+	void	PrepareWrite();
+
 	DiskD88Sector();
 	DiskD88Sector(const DiskD88Sector &src) : DiskImageSector(src) {}
 	DiskD88Sector &operator=(const DiskD88Sector &src) { return *this; }
 
 public:
-	DiskD88Sector(int n_num, const DiskImageSectorHeader &n_header, wxUint8 *n_data);
-	DiskD88Sector(int track_number, int side_number, int sector_number, int sector_size, int number_of_sector, bool single_density = false, int status = 0);
+	DiskD88Sector(int n_num, const DiskImageSectorHeader &n_header, wxUint8 *n_data, bool n_shared_data = false);
+	DiskD88Sector(int track_number, int side_number, int sector_number, int sector_size, int number_of_sector, bool single_density = false, int status = 0, wxUint8 *n_shared_data = NULL);
 	~DiskD88Sector();
 
 	/// セクタのデータを置き換える
@@ -184,10 +194,16 @@ public:
 	int		GetSectorBufferSize() const;
 	/// セクタサイズ（ヘッダ＋バッファのサイズ）を返す
 	int		GetSize() const;
-	/// セクタデータへのポインタを返す
-	wxUint8 *GetSectorBuffer() { return data; }
-	/// セクタデータへのポインタを返す
+	/// セクタデータへのポインタを返す(書き込みありとみなす)
+	wxUint8 *GetSectorBuffer();
+	/// セクタデータへのポインタを返す(書き込みありとみなす)
 	wxUint8 *GetSectorBuffer(int offset);
+	/// 読み込み専用でセクタデータへのポインタを返す(書き込みとはみなさない)
+	const wxUint8 *PeekSectorBuffer() const { return data; }
+	/// 読み込み専用でセクタデータへのポインタを返す(書き込みとはみなさない)
+	const wxUint8 *PeekSectorBuffer(int offset) const;
+	/// イメージ解析時にセクタデータへのポインタを返す(書き込みとはみなさない)
+	wxUint8 *GetSectorBufferForParse() { return data; }
 	/// セクタ数を返す
 	wxUint16 GetSectorsPerTrack() const;
 	/// セクタ数を設定
@@ -196,6 +212,8 @@ public:
 	wxUint8 GetSectorStatus() const;
 	/// セクタのステータスを設定
 	void    SetSectorStatus(wxUint8 val);
+	/// ディスクの領域が移動したのでセクタデータの位置を移す
+	void	RelocateSharedData(const wxUint8 *old_base, size_t size, wxUint8 *new_base);
 
 	/// ヘッダを返す
 	DiskImageSectorHeader *GetHeader() { return &m_header; }
@@ -229,8 +247,6 @@ public:
 
 	/// 変更されているか
 	bool	IsModified() const;
-	/// 変更済みを設定
-	void	SetModify();
 	/// 変更済みをクリア
 	void	ClearModify();
 };
@@ -7,10 +7,13 @@
 
 #include "diskd88parser.h"
 #include <wx/stream.h>
+#include <wx/mstream.h>
+#include <wx/wfstream.h>
 #include "diskd88.h"
 #include "diskparser.h"
 #include "fileparam.h"
 #include "diskresult.h"
+#include "diskmapfile.h"
 #include "../config.h"
 
 
@@ -71,6 +74,94 @@ int	DiskD88ParseOffset::CmpByOffset(DiskD88ParseOffset **item1, DiskD88ParseOffs
 #include <wx/arrimpl.cpp>
 WX_DEFINE_OBJARRAY(DiskD88ParseOffsets);
 
+//
+//
+//
+DiskD88ParseEntry::DiskD88ParseEntry(size_t n_start_pos, int n_disk_number)
+{
+	start_pos	= n_start_pos;
+	disk_number	= n_disk_number;
+	disk		= NULL;
+}
+
+DiskD88ParseEntry::~DiskD88ParseEntry()
+{
+	delete disk;
+}
+
+/// ディスクの所有権を渡す
+DiskImageDisk *DiskD88ParseEntry::ReleaseDisk()
+{
+	DiskImageDisk *p = disk;
+	disk = NULL;
+	return p;
+}
+
+#if wxUSE_THREADS
+//
+//
+//
+DiskD88ParseWorker::DiskD88ParseWorker(DiskImageFile *file, short mod_flags, const wxString &file_path, DiskD88ParseEntries *entries, size_t *next, wxCriticalSection *lock)
+	: wxThread(wxTHREAD_JOINABLE)
+{
+	p_file = file;
+	m_mod_flags = mod_flags;
+	m_file_path = file_path;
+	p_entries = entries;
+	p_next = next;
+	p_lock = lock;
+}
+
+/// スレッド
+wxThread::ExitCode DiskD88ParseWorker::Entry()
+{
+	ParseEntries(p_file, m_mod_flags, m_file_path, p_entries, p_next, p_lock);
+	return 0;
+}
+
+/// エントリを順に取り出して解析する
+/// 読み込み位置はスレッドごとに持つ
+/// @param [in]     file      ディスクイメージ
+/// @param [in]     mod_flags 変更フラグ
+/// @param [in]     file_path 解析するファイル
+/// @param [in,out] entries   解析するディスクのリスト
+/// @param [in,out] next      次に解析するエントリ
+/// @param [in]     lock      nextの排他
+void DiskD88ParseWorker::ParseEntries(DiskImageFile *file, short mod_flags, const wxString &file_path, DiskD88ParseEntries *entries, size_t *next, wxCriticalSection *lock)
+{
+	DiskD88Parser ps(file, mod_flags, NULL);
+
+	wxInputStream *istream;
+	if (ps.m_map_buffer) {
+		// マッピングした領域を読む
+		istream = new wxMemoryInputStream(ps.m_map_buffer, ps.m_map_size);
+	} else {
+		istream = new wxFileInputStream(file_path);
+	}
+
+	for(;;) {
+		size_t idx;
+		{
+			wxCriticalSectionLocker locker(*lock);
+			idx = (*next)++;
+		}
+		if (idx >= entries->Count()) break;
+
+		DiskD88ParseEntry *entry = entries->Item(idx);
+		ps.p_result = &entry->GetResult();
+		if (!istream->IsOk()) {
+			ps.p_result->SetError(DiskResult::ERR_CANNOT_OPEN);
+			continue;
+		}
+		DiskImageDisk *disk = NULL;
+		ps.ParseDisk(*istream, entry->GetStartPos(), entry->GetDiskNumber(), disk);
+		entry->SetDisk(disk);
+	}
+
+	delete istream;
+}
+#endif
+
 //
 //
 //
@@ -79,6 +170,18 @@ DiskD88Parser::DiskD88Parser(DiskImageFile *file, short mod_flags, DiskResult *r
 	p_file = file;
 	m_mod_flags = mod_flags;
 	p_result = result;
+
+	m_map_buffer = NULL;
+	m_map_size = 0;
+	m_disk_start = 0;
+	m_disk_end = 0;
+	// 開いたファイルがマッピングされていればセクタデータはその領域を指す
+	// (追加するディスクは別ファイルなので対象外)
+	DiskMapFile *map = (p_file ? p_file->GetMapFile() : NULL);
+	if (m_mod_flags == DiskImageFile::MODIFY_NONE && map && map->IsOpened()) {
+		m_map_buffer = map->GetBuffer();
+		m_map_size = map->GetSize();
+	}
 }
 
 DiskD88Parser::~DiskD88Parser()
@@ -133,6 +236,7 @@ wxUint32 DiskD88Parser::ParseSector(wxInputStream &istream, int disk_number, int
 {
 	DiskD88SectorHeader sector_header;
 	sector_header.Alloc();
+	wxFileOffset sector_pos = istream.TellI();
 	size_t header_size = istream.Read((void *)sector_header.GetHeader(), sector_header.GetHeaderSize()).LastRead();
 
 //	d88_sector_header_t *sector_header = new d88_sector_header_t;
@@ -165,11 +269,21 @@ wxUint32 DiskD88Parser::ParseSector(wxInputStream &istream, int disk_number, int
 	size_t data_size = sector_header.GetSize();
 	if (p_result->GetValid() >= 0) {
 		wxUint8 *sector_data = NULL;
-		if (data_size > 0) {
-			sector_data = new wxUint8[data_size];
+		size_t pos = (size_t)istream.TellI();
+		if (data_size > 0 && m_disk_start <= pos && pos + data_size <= m_disk_end) {
+			// マッピングした領域を直接指す
+			sector_data = m_map_buffer + pos;
+			istream.SeekI((wxFileOffset)data_size, wxFromCurrent);
+		} else if (data_size > 0) {
+			// ディスクの領域から確保
+			sector_data = track->GetDisk()->AllocSectorBuffer(data_size);
 			istream.Read((void *)sector_data, data_size);
 		}
 		DiskImageSector *sector = track->NewImageSector(sector_number, sector_header, sector_data);
+		if (m_mod_flags == DiskImageFile::MODIFY_NONE) {
+			// 変更部分だけ保存するときに使う
+			sector->SetFilePosition(sector_pos);
+		}
 		track->Add(sector);
 
 	} else {
@@ -305,9 +419,15 @@ wxUint32 DiskD88Parser::ParseTrack(wxInputStream &istream, size_t start_pos, int
 }
 
 /// ディスクデータの解析
+/// @param [in]  istream     解析対象データ
+/// @param [in]  start_pos   ディスクの開始位置
+/// @param [in]  disk_number ディスク番号
+/// @param [out] new_disk    解析したディスク(追加はしない) 解析できなければNULL
 /// @return ディスクサイズ
-wxUint32 DiskD88Parser::ParseDisk(wxInputStream &istream, size_t start_pos, int disk_number)
+wxUint32 DiskD88Parser::ParseDisk(wxInputStream &istream, size_t start_pos, int disk_number, DiskImageDisk *&new_disk)
 {
+	new_disk = NULL;
+
 	DiskD88DiskHeader disk_header;
 	disk_header.Alloc();
 //	d88_header_t *disk_header = new d88_header_t;
@@ -419,6 +539,27 @@ wxUint32 DiskD88Parser::ParseDisk(wxInputStream &istream, size_t start_pos, int
 		DiskImageDisk *disk = p_file->NewImageDisk(disk_number, disk_header);
 
 		disk->SetOffsetStart(offset_start);
+		if (m_mod_flags == DiskImageFile::MODIFY_NONE) {
+			disk->SetFilePosition((wxFileOffset)start_pos);
+		}
+		m_disk_start = 0;
+		m_disk_end = 0;
+		if (m_map_buffer && start_pos + disk_size <= m_map_size) {
+			// マッピングしたファイルの領域をそのまま使う
+			m_disk_start = start_pos;
+			m_disk_end = start_pos + disk_size;
+			disk->AttachMappedBuffer(m_map_buffer + start_pos, disk_size);
+		} else {
+			// セクタデータの領域をまとめて確保
+			// ストリームの残りと4MBを超えないようにする
+			wxUint32 reserve_size = disk_size;
+			wxUint32 remain_size = (stream_size > start_pos ? stream_size - (wxUint32)start_pos : 0);
+			if (reserve_size > remain_size) reserve_size = remain_size;
+			if (reserve_size > (1024*1024*4)) reserve_size = (1024*1024*4);
+			if (reserve_size > offset_start) {
+				disk->ReserveSectorBuffers((int)(reserve_size - offset_start));
+			}
+		}
 
 		// parse tracks
 		for(int pos = 0; pos < offsets_count && p_result->GetValid() >= 0; pos++) {
@@ -435,11 +576,10 @@ wxUint32 DiskD88Parser::ParseDisk(wxInputStream &istream, size_t start_pos, int
 		}
 
 		if (p_result->GetValid() >= 0) {
-			// ディスクを追加
 			disk->CalcMajorNumber();
-			p_file->Add(disk, m_mod_flags);
 			// ディスクイメージのパラメータチェック
 			CheckParamInDisk(disk_number, disk);
+			new_disk = disk;
 		} else {
 			delete disk;
 		}
@@ -452,6 +592,86 @@ wxUint32 DiskD88Parser::ParseDisk(wxInputStream &istream, size_t start_pos, int
 	return size;
 }
 
+/// ディスクヘッダからディスクサイズだけを求める
+/// @note ParseDisk()が返すサイズと同じになること
+/// @return ディスクサイズ
+wxUint32 DiskD88Parser::PeekDiskSize(wxInputStream &istream, size_t start_pos)
+{
+	DiskD88DiskHeader disk_header;
+	disk_header.Alloc();
+
+	istream.SeekI(start_pos);
+	wxUint32 header_size = (wxUint32)istream.Read((void *)disk_header.GetHeader(), disk_header.GetHeaderSize()).LastRead();
+
+	// EOF(0x1a)ならスキップ
+	wxByte *p = (wxByte *)disk_header.GetHeader();
+	bool all_eot = true;
+	for(wxUint32 pos = 0; pos < header_size; pos++) {
+		if (p[pos] != 0x1a) {
+			all_eot = false;
+			break;
+		}
+	}
+	if (all_eot || header_size < disk_header.GetHeaderSize()) {
+		return header_size;
+	}
+
+	wxUint32 disk_size = disk_header.GetDiskSize();
+	if (disk_size < disk_header.GetHeaderSize()) {
+		return header_size;
+	}
+
+	wxUint32 stream_size = (wxUint32)istream.GetLength();
+	if (stream_size < disk_size || (1024*1024*4) < disk_size) {
+		disk_size = stream_size;
+	}
+	return disk_size;
+}
+
+/// 複数のディスクを並列で解析する
+/// 結果はディスクの順に追加し、エラーのあったディスク以降は捨てる
+/// @param [in,out] entries 解析するディスクのリスト
+/// @retval  0 正常
+/// @retval -1 エラーあり
+/// @retval  1 警告あり
+int DiskD88Parser::ParseDisksInParallel(DiskD88ParseEntries &entries)
+{
+#if wxUSE_THREADS
+	size_t next = 0;
+	wxCriticalSection lock;
+
+	int threads = wxThread::GetCPUCount();
+	if (threads > (int)entries.Count()) threads = (int)entries.Count();
+
+	// 自スレッドでも解析するので一つ少なく作る
+	wxArrayPtrVoid workers;
+	for(int i = 1; i < threads; i++) {
+		DiskD88ParseWorker *worker = new DiskD88ParseWorker(p_file, m_mod_flags, m_file_path, &entries, &next, &lock);
+		if (worker->Run() != wxTHREAD_NO_ERROR) {
+			delete worker;
+			break;
+		}
+		workers.Add(worker);
+	}
+	DiskD88ParseWorker::ParseEntries(p_file, m_mod_flags, m_file_path, &entries, &next, &lock);
+	for(size_t i = 0; i < workers.Count(); i++) {
+		DiskD88ParseWorker *worker = (DiskD88ParseWorker *)workers.Item(i);
+		worker->Wait();
+		delete worker;
+	}
+#endif
+
+	// ディスクの順に結果をまとめる
+	for(size_t idx = 0; idx < entries.Count() && p_result->GetValid() >= 0; idx++) {
+		DiskD88ParseEntry *entry = entries.Item(idx);
+		p_result->Merge(entry->GetResult());
+		if (entry->GetDisk() && p_result->GetValid() >= 0) {
+			p_file->Add(entry->ReleaseDisk(), m_mod_flags);
+		}
+	}
+	return p_result->GetValid();
+}
+
 /// ディスクイメージができた後のパラメータチェック
 /// @param [in] disk_number ディスク番号
 /// @param [in] disk        ディスクイメージ
@@ -594,8 +814,41 @@ int DiskD88Parser::Parse(wxInputStream &istream, const DiskParam *disk_param)
 		p_result->SetError(DiskResult::ERRV_INVALID_DISK, disk_number);
 		return p_result->GetValid();
 	}
+
+#if wxUSE_THREADS
+	if ((m_map_buffer || !m_file_path.IsEmpty()) && wxThread::GetCPUCount() > 1) {
+		// 先にディスクの位置を調べる
+		DiskD88ParseEntries entries;
+		for(; read_size < stream_size; disk_number++) {
+			wxUint32 size = PeekDiskSize(istream, read_size);
+			if (size == 0) break;
+			entries.Add(new DiskD88ParseEntry(read_size, disk_number));
+			read_size += size;
+		}
+		int rc = 0;
+		if (entries.Count() > 1) {
+			// ディスクごとに並列で解析
+			rc = ParseDisksInParallel(entries);
+		}
+		for(size_t idx = 0; idx < entries.Count(); idx++) {
+			delete entries.Item(idx);
+		}
+		if (entries.Count() > 1) {
+			return rc;
+		}
+		// ディスクが１つなら順に解析
+		read_size = 0;
+		disk_number = (int)p_file->Count();
+	}
+#endif
+
 	for(; read_size < stream_size && p_result->GetValid() >= 0; disk_number++) {
-		wxUint32 size = ParseDisk(istream, read_size, disk_number);
+		DiskImageDisk *disk = NULL;
+		wxUint32 size = ParseDisk(istream, read_size, disk_number, disk);
+		if (disk) {
+			// ディスクを追加
+			p_file->Add(disk, m_mod_flags);
+		}
 		if (size == 0) break;
 		read_size += size;
 	}
@@ -607,6 +860,36 @@ int DiskD88Parser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_LIKELY トラックのオフセットが妥当
+/// @retval PROBE_NO     該当しない
+int DiskD88Parser::Probe(const DiskProbeData &data)
+{
+	d88_header_t header;
+	wxUint32 header_size_min = (wxUint32)sizeof(header) - 32;
+	wxUint32 header_size_max = (wxUint32)sizeof(header) + 16;
+
+	if (data.GetSize() < (size_t)header_size_min) {
+		// too short
+		return PROBE_NO;
+	}
+	data.Copy(0, &header, sizeof(header));
+
+	// check offset
+	int all_zero = 0;
+	for(int i=0; i < DISKD88_MAX_TRACKS; i++) {
+		wxUint32 offset = header.offsets[i];
+		offset = wxUINT32_SWAP_ON_BE(offset);
+		if (offset >= header_size_min && offset <= header_size_max && (offset & 0xf) == 0) {
+			return PROBE_LIKELY;
+		} else if (offset == 0) {
+			all_zero++;
+		}
+	}
+	return (all_zero == DISKD88_MAX_TRACKS ? PROBE_LIKELY : PROBE_NO);
+}
+
 /// チェック
 /// @return 0 
 int DiskD88Parser::Check(wxInputStream &istream)
@@ -10,7 +10,9 @@
 
 #include "../common.h"
 #include <wx/dynarray.h>
+#include <wx/thread.h>
 #include "diskparser.h"
+#include "diskresult.h"
 
 
 class wxInputStream;
@@ -50,14 +52,75 @@ public:
 /// @brief オフセット解析 DiskD88ParseOffset のリスト
 WX_DECLARE_OBJARRAY(DiskD88ParseOffset, DiskD88ParseOffsets);
 
+/// 並列解析用 ディスク1つ分の解析結果
+class DiskD88ParseEntry
+{
+private:
+	size_t			 start_pos;		///< ファイル上の開始位置
+	int				 disk_number;	///< ディスク番号
+	DiskImageDisk	*disk;			///< 解析したディスク
+	DiskResult		 result;		///< このディスクの解析結果
+
+	DiskD88ParseEntry() {}
+	DiskD88ParseEntry(const DiskD88ParseEntry &src) {}
+	DiskD88ParseEntry &operator=(const DiskD88ParseEntry &src) { return *this; }
+
+public:
+	DiskD88ParseEntry(size_t n_start_pos, int n_disk_number);
+	~DiskD88ParseEntry();
+
+	size_t			GetStartPos() const { return start_pos; }
+	int				GetDiskNumber() const { return disk_number; }
+	DiskImageDisk	*GetDisk() const { return disk; }
+	void			SetDisk(DiskImageDisk *val) { disk = val; }
+	/// ディスクの所有権を渡す
+	DiskImageDisk	*ReleaseDisk();
+	DiskResult		&GetResult() { return result; }
+};
+
+/// @class DiskD88ParseEntries
+///
+/// @brief 並列解析用 DiskD88ParseEntry のリスト
+WX_DEFINE_ARRAY(DiskD88ParseEntry *, DiskD88ParseEntries);
+
+#if wxUSE_THREADS
+/// 並列解析用ワーカースレッド
+class DiskD88ParseWorker : public wxThread
+{
+private:
+	DiskImageFile		*p_file;
+	short				 m_mod_flags;
+	wxString			 m_file_path;
+	DiskD88ParseEntries	*p_entries;
+	size_t				*p_next;	///< 次に解析するエントリ
+	wxCriticalSection	*p_lock;	///< p_nextの排他
+
+	ExitCode Entry();
+
+public:
+	DiskD88ParseWorker(DiskImageFile *file, short mod_flags, const wxString &file_path, DiskD88ParseEntries *entries, size_t *next, wxCriticalSection *lock);
+
+	/// エントリを順に取り出して解析する
+	static void ParseEntries(DiskImageFile *file, short mod_flags, const wxString &file_path, DiskD88ParseEntries *entries, size_t *next, wxCriticalSection *lock);
+};
+#endif
+
 /// D88ディスクパーサー
 class DiskD88Parser : public DiskImageParser
 {
 private:
+	wxUint8 *m_map_buffer;	///< マッピングしたファイルの領域
+	size_t	 m_map_size;	///< マッピングした領域のサイズ
+	size_t	 m_disk_start;	///< 解析中ディスクのマッピング領域内の開始位置
+	size_t	 m_disk_end;	///< 解析中ディスクのマッピング領域内の終了位置
+	wxString m_file_path;	///< 解析するファイル(並列解析時に各スレッドで開く)
+
 	void	 PreParseSectors(wxInputStream &istream, int disk_number, int &track_number, int &side_number, int &sector_nums, int &sector_size);
 	wxUint32 ParseSector(wxInputStream &istream, int disk_number, int track_number, int side_number, int sector_nums, int sector_size, DiskImageTrack *track);
 	wxUint32 ParseTrack(wxInputStream &istream, size_t start_pos, int offset_pos, wxUint32 offset, int disk_number, int track_size, DiskImageDisk *disk);
-	wxUint32 ParseDisk(wxInputStream &istream, size_t start_pos, int disk_number);
+	wxUint32 ParseDisk(wxInputStream &istream, size_t start_pos, int disk_number, DiskImageDisk *&new_disk);
+	wxUint32 PeekDiskSize(wxInputStream &istream, size_t start_pos);
+	int		 ParseDisksInParallel(DiskD88ParseEntries &entries);
 	void	 CheckParamInSector(int disk_number, DiskImageDisk *disk, DiskImageTrack *track, DiskImageSector *sector);
 	void	 CheckParamInTrack(int disk_number, DiskImageDisk *disk, DiskImageTrack *track);
 	void	 CheckParamInDisk(int disk_number, DiskImageDisk *disk);
@@ -68,10 +131,19 @@ public:
 	DiskD88Parser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskD88Parser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
+	/// 解析するファイルのパスを設定
+	void SetFilePath(const wxString &val) { m_file_path = val; }
+
 	/// チェック
 	int Check(wxInputStream &istream);
 	/// 解析
 	int Parse(wxInputStream &istream, const DiskParam *disk_param = NULL);
+
+#if wxUSE_THREADS
+	friend class DiskD88ParseWorker;
+#endif
 };
 
 #endif /* DISKD88_PARSER_H */
@@ -7,6 +7,7 @@
 
 #include "diskd88writer.h"
 #include <wx/stream.h>
+#include <wx/file.h>
 #include "diskd88.h"
 //#include "diskd88creator.h"
 #include "diskresult.h"
@@ -89,13 +90,13 @@ int DiskD88Writer::SaveDisk(DiskImage *image, int disk_number, int side_number,
 		}
 		for(size_t disk_num = 0; disk_num < disks->Count(); disk_num++) {
 			DiskImageDisk *disk = disks->Item(disk_num);
-			SaveDisk(disk, -1, ostream); 
+			SaveDisk(disk, -1, true, ostream); 
 		}
 	} else {
 		// 指定したディスクを保存
 		DiskImageDisk *disk = file->GetDisk(disk_number);
 
-		SaveDisk(disk, side_number, ostream); 
+		SaveDisk(disk, side_number, false, ostream); 
 	}
 
 	return p_result->GetValid();
@@ -104,8 +105,11 @@ int DiskD88Writer::SaveDisk(DiskImage *image, int disk_number, int side_number,
 /// ディスク1つを保存
 /// @param [in]  disk        ディスク
 /// @param [in]  side_number サイド 両面なら -1
+/// @param [in]  whole_file  ファイル全体を保存しているか
 /// @param [out] ostream     出力先
-int DiskD88Writer::SaveDisk(DiskImageDisk *disk, int side_number, wxOutputStream *ostream)
+/// @note ファイル上の位置と変更済みの解除はファイル全体を保存したときだけ行う
+/// ディスク1つを別ファイルに保存しても元のファイルは変わらないため
+int DiskD88Writer::SaveDisk(DiskImageDisk *disk, int side_number, bool whole_file, wxOutputStream *ostream)
 {
 	if (!disk) {
 		p_result->SetError(DiskResult::ERR_NO_DISK);
@@ -114,6 +118,11 @@ int DiskD88Writer::SaveDisk(DiskImageDisk *disk, int side_number, wxOutputStream
 
 	DiskD88DiskHeader newheader;
 
+	// ファイル全体を保存するときは変更部分だけ書き換えられるように位置を覚えておく
+	if (whole_file) {
+		disk->SetFilePosition(ostream->TellO());
+	}
+
 	// オフセットを再計算する
 	size_t new_size = 0;
 	disk->SetOffsetStart(newheader.GetHeaderSize());
@@ -166,12 +175,16 @@ int DiskD88Writer::SaveDisk(DiskImageDisk *disk, int side_number, wxOutputStream
 				secheader.SetIDH(0);
 			}
 
+			if (whole_file) {
+				sector->SetFilePosition(ostream->TellO());
+			}
+
 			// write sector header
 			ostream->Write(secheader.GetHeader(), secheader.GetHeaderSize());
 			track_size += secheader.GetHeaderSize();
 
 			// write sector body
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			size_t buffer_size = sector->GetSectorBufferSize();
 			if (buffer && buffer_size) {
 				ostream->Write((void *)buffer, buffer_size);	
@@ -203,8 +216,180 @@ int DiskD88Writer::SaveDisk(DiskImageDisk *disk, int side_number, wxOutputStream
 		ostream->Write(newheader.GetHeader(), newheader.GetHeaderSize());
 	}
 
-	if (p_result->GetValid() >= 0) {
+	if (whole_file && p_result->GetValid() >= 0) {
 		disk->ClearModify();
 	}
 	return p_result->GetValid();
 }
+
+/// 既存のファイルの変更部分だけを書き換える
+/// @param [in,out] image   ディスクイメージ
+/// @param [in]     path    ファイルパス
+/// @param [out]    support 書き換えられたらtrue (falseならファイル全体を保存し直す)
+/// @retval  0 正常
+/// @retval -1 エラー
+/// @note トラックの配置やセクタサイズが変わっていないときのみ書き換える
+int DiskD88Writer::Overwrite(DiskImage *image, const wxString &path, bool &support)
+{
+	p_result->Clear();
+	support = false;
+
+	DiskImageFile *file = image->GetFile();
+	if (!file) {
+		return p_result->GetValid();
+	}
+	DiskImageDisks *disks = file->GetDisks();
+	if (!disks || disks->Count() <= 0) {
+		return p_result->GetValid();
+	}
+
+	wxFile fio;
+	if (!wxFile::Exists(path) || !fio.Open(path, wxFile::read_write)) {
+		return p_result->GetValid();
+	}
+
+	// 全ディスクの配置が読み込み時(前回保存時)と同じか
+	wxFileOffset file_pos = 0;
+	for(size_t disk_num = 0; disk_num < disks->Count(); disk_num++) {
+		if (!CanOverwriteDisk(disks->Item(disk_num), file_pos)) {
+			return p_result->GetValid();
+		}
+	}
+	if (file_pos != fio.Length()) {
+		return p_result->GetValid();
+	}
+
+	support = true;
+	for(size_t disk_num = 0; disk_num < disks->Count() && p_result->GetValid() >= 0; disk_num++) {
+		OverwriteDisk(disks->Item(disk_num), fio);
+	}
+
+	return p_result->GetValid();
+}
+
+/// ファイル上の配置が変わっていないか
+/// @param [in]     disk     ディスク
+/// @param [in,out] file_pos ディスクの開始位置 / 次のディスクの開始位置を返す
+/// @return 変わっていなければtrue
+bool DiskD88Writer::CanOverwriteDisk(DiskImageDisk *disk, wxFileOffset &file_pos)
+{
+	if (!disk) return false;
+	if (disk->GetFilePosition() < 0 || disk->GetFilePosition() != file_pos) return false;
+
+	DiskImageTracks *tracks = disk->GetTracks();
+	if (!tracks || tracks->Count() > DISKD88_MAX_TRACKS) return false;
+
+	DiskD88DiskHeader newheader;
+	if (disk->GetOffsetStart() != (wxUint32)newheader.GetHeaderSize()) return false;
+
+	// 全体を保存したときと同じ位置になるか
+	size_t track_offset = newheader.GetHeaderSize();
+	for(size_t track_num = 0; track_num < tracks->Count(); track_num++) {
+		DiskImageTrack *track = tracks->Item(track_num);
+		if (!track) continue;
+		size_t track_size = 0;
+		DiskImageSectors *sectors = track->GetSectors();
+		size_t count = sectors ? sectors->Count() : 0;
+		for(size_t sector_num = 0; sector_num < count; sector_num++) {
+			DiskImageSector *sector = sectors->Item(sector_num);
+			if (!sector) continue;
+			if (sector->GetFilePosition() != file_pos + (wxFileOffset)(track_offset + track_size)) return false;
+			track_size += sector->GetHeaderSize();
+			if (sector->PeekSectorBuffer() && sector->GetSectorBufferSize() > 0) {
+				track_size += sector->GetSectorBufferSize();
+			}
+		}
+		if (!p_dw->IsTrimUnusedData() && track->GetExtraData()) {
+			track_size += track->GetExtraDataSize();
+		}
+		if (track_size > 0) {
+			if (disk->GetOffset(track->GetOffsetPos()) != (wxUint32)track_offset) return false;
+			track_offset += track_size;
+		}
+	}
+	if (disk->GetSize() != (wxUint32)track_offset) return false;
+
+	file_pos += (wxFileOffset)track_offset;
+	return true;
+}
+
+/// ディスク1つの変更部分を書き換える
+/// @param [in]     disk ディスク
+/// @param [in,out] fio  出力先
+int DiskD88Writer::OverwriteDisk(DiskImageDisk *disk, wxFile &fio)
+{
+	DiskImageTracks *tracks = disk->GetTracks();
+
+	// 全体を保存するときと同じくセクタ数を揃える
+	// 書き込みのないトラックはファイルの内容のままにする(変更済みにしない)
+	for(size_t track_num = 0; track_num < tracks->Count(); track_num++) {
+		DiskImageTrack *track = tracks->Item(track_num);
+		if (!track || !track->IsDirty()) continue;
+		DiskImageSectors *sectors = track->GetSectors();
+		size_t count = sectors ? sectors->Count() : 0;
+		for(size_t sector_num = 0; sector_num < count; sector_num++) {
+			DiskImageSector *sector = sectors->Item(sector_num);
+			if (sector && sector->GetSectorsPerTrack() != (wxUint16)count) {
+				sector->SetSectorsPerTrack((wxUint16)count);
+			}
+		}
+	}
+
+	if (!disk->IsDirty()) {
+		// 書き込みなし
+		return p_result->GetValid();
+	}
+
+	bool ok = true;
+
+	// ディスクヘッダ
+	DiskD88DiskHeader newheader;
+	newheader.New(*disk->GetHeader());
+	ok = ok && (fio.Seek(disk->GetFilePosition()) != wxInvalidOffset);
+	ok = ok && (fio.Write(newheader.GetHeader(), newheader.GetHeaderSize()) == newheader.GetHeaderSize());
+
+	for(size_t track_num = 0; track_num < tracks->Count() && ok; track_num++) {
+		DiskImageTrack *track = tracks->Item(track_num);
+		if (!track || !track->IsDirty()) continue;
+		DiskImageSectors *sectors = track->GetSectors();
+		size_t count = sectors ? sectors->Count() : 0;
+		wxFileOffset next_pos = -1;
+		for(size_t sector_num = 0; sector_num < count && ok; sector_num++) {
+			DiskImageSector *sector = sectors->Item(sector_num);
+			if (!sector) continue;
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
+			size_t buffer_size = sector->GetSectorBufferSize();
+			next_pos = sector->GetFilePosition() + (wxFileOffset)sector->GetHeaderSize() + (buffer ? (wxFileOffset)buffer_size : 0);
+			// 書き込み用のバッファを渡しただけのセクタは内容を比べる
+			if (!sector->IsModified()) continue;
+
+			// セクタヘッダ
+			DiskD88SectorHeader secheader;
+			secheader.New(*sector->GetHeader());
+			ok = ok && (fio.Seek(sector->GetFilePosition()) != wxInvalidOffset);
+			ok = ok && (fio.Write(secheader.GetHeader(), secheader.GetHeaderSize()) == secheader.GetHeaderSize());
+
+			// セクタデータ
+			if (buffer && buffer_size) {
+				ok = ok && (fio.Write(buffer, buffer_size) == buffer_size);
+			}
+		}
+		if (!p_dw->IsTrimUnusedData() && next_pos >= 0) {
+			// 余分なデータ(セクタサイズを変更すると変わる)
+			wxUint8 *extra_data = track->GetExtraData();
+			size_t   extra_size = track->GetExtraDataSize();
+			if (extra_data && extra_size > 0) {
+				ok = ok && (fio.Seek(next_pos) != wxInvalidOffset);
+				ok = ok && (fio.Write(extra_data, extra_size) == extra_size);
+			}
+		}
+	}
+
+	if (!ok) {
+		p_result->SetError(DiskResult::ERR_CANNOT_SAVE);
+		return p_result->GetValid();
+	}
+
+	disk->ClearModify();
+	return p_result->GetValid();
+}
@@ -13,6 +13,7 @@
 
 
 class wxOutputStream;
+class wxFile;
 class DiskWriter;
 class DiskImage;
 class DiskImageDisk;
@@ -23,7 +24,11 @@ class DiskD88Writer : public DiskImageWriter
 {
 private:
 	/// ディスク1つを保存
-	int SaveDisk(DiskImageDisk *disk, int side_number, wxOutputStream *ostream);
+	int SaveDisk(DiskImageDisk *disk, int side_number, bool whole_file, wxOutputStream *ostream);
+	/// ファイル上の配置が変わっていないか
+	bool CanOverwriteDisk(DiskImageDisk *disk, wxFileOffset &file_pos);
+	/// ディスク1つの変更部分を書き換える
+	int OverwriteDisk(DiskImageDisk *disk, wxFile &file);
 
 public:
 	DiskD88Writer(DiskWriter *dw_, DiskResult *result_);
@@ -32,6 +37,8 @@ public:
 	int ValidateDisk(DiskImage *image, int disk_number, int side_number);
 	/// ストリームの内容をファイルに保存
 	int SaveDisk(DiskImage *image, int disk_number, int side_number, wxOutputStream *ostream);
+	/// 既存のファイルの変更部分だけを書き換える
+	int Overwrite(DiskImage *image, const wxString &path, bool &support);
 };
 
 #endif /* DISKD88_WRITER_H */
@@ -0,0 +1,276 @@
+﻿/// @file diskdetectcache.cpp
+///
+/// @brief ディスクイメージの判定結果キャッシュ
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#include "diskdetectcache.h"
+#include <wx/stream.h>
+#include <wx/fileconf.h>
+#include "diskimage.h"
+#include "diskparser.h"
+#include "../utils.h"
+
+
+/// 値の区切り
+#define DISK_DETECT_CACHE_SEPARATOR	wxT('|')
+
+DiskDetectCache gDiskDetectCache;
+
+//
+//
+//
+/// キーに対応する値を返す
+/// @param [in]  key   キー
+/// @param [out] value 値
+/// @return true:あり
+bool DiskDetectCacheList::Find(const wxString &key, wxString &value) const
+{
+	DiskDetectCacheValues::const_iterator it = m_values.find(key);
+	if (it == m_values.end()) return false;
+	value = it->second;
+	return true;
+}
+
+/// 値を設定（最大件数を超えたら古いものから削除）
+/// @param [in] key   キー
+/// @param [in] value 値
+void DiskDetectCacheList::Set(const wxString &key, const wxString &value)
+{
+	if (m_values.find(key) == m_values.end()) {
+		while(m_keys.Count() >= DISK_DETECT_CACHE_MAX) {
+			m_values.erase(m_keys.Item(0));
+			m_keys.RemoveAt(0);
+		}
+		m_keys.Add(key);
+	}
+	m_values[key] = value;
+}
+
+/// 値を削除
+/// @param [in] key キー
+/// @return true:削除した
+bool DiskDetectCacheList::Remove(const wxString &key)
+{
+	if (m_values.erase(key) == 0) return false;
+	m_keys.Remove(key);
+	return true;
+}
+
+/// 全削除
+void DiskDetectCacheList::Clear()
+{
+	m_keys.Clear();
+	m_values.clear();
+}
+
+//
+//
+//
+DiskDetectCache::DiskDetectCache()
+{
+	m_modified = false;
+}
+
+/// ファイルから読み込む
+/// @param [in] file ファイルパス
+void DiskDetectCache::Load(const wxString &file)
+{
+	m_file = file;
+	m_images.Clear();
+	m_basics.Clear();
+	m_modified = false;
+
+	if (!wxFileExists(m_file)) return;
+
+	wxFileConfig *ini = new wxFileConfig(wxEmptyString,wxEmptyString,m_file,wxEmptyString
+		,wxCONFIG_USE_LOCAL_FILE | wxCONFIG_USE_RELATIVE_PATH | wxCONFIG_USE_NO_ESCAPE_CHARACTERS);
+	Load(ini, wxT("/Image"), m_images);
+	Load(ini, wxT("/Basic"), m_basics);
+	delete ini;
+}
+
+/// リストを読み込む
+/// @param [in]  ini   設定ファイル
+/// @param [in]  group グループ名
+/// @param [out] list  リスト
+void DiskDetectCache::Load(wxConfigBase *ini, const wxString &group, DiskDetectCacheList &list)
+{
+	ini->SetPath(group);
+	wxString key;
+	long idx;
+	bool cont = ini->GetFirstEntry(key, idx);
+	while(cont) {
+		wxString value;
+		ini->Read(key, &value);
+		list.Set(key, value);
+		cont = ini->GetNextEntry(key, idx);
+	}
+	ini->SetPath(wxT("/"));
+}
+
+/// ファイルに保存する
+void DiskDetectCache::Save()
+{
+	if (m_file.IsEmpty() || !m_modified) return;
+
+	wxFileConfig *ini = new wxFileConfig(wxEmptyString,wxEmptyString,m_file,wxEmptyString
+		,wxCONFIG_USE_LOCAL_FILE | wxCONFIG_USE_RELATIVE_PATH | wxCONFIG_USE_NO_ESCAPE_CHARACTERS);
+	ini->DeleteGroup(wxT("/Image"));
+	ini->DeleteGroup(wxT("/Basic"));
+	Save(ini, wxT("/Image"), m_images);
+	Save(ini, wxT("/Basic"), m_basics);
+	delete ini;
+
+	m_modified = false;
+}
+
+/// リストを保存
+/// @param [in] ini   設定ファイル
+/// @param [in] group グループ名
+/// @param [in] list  リスト
+void DiskDetectCache::Save(wxConfigBase *ini, const wxString &group, const DiskDetectCacheList &list)
+{
+	ini->SetPath(group);
+	for(size_t i=0; i<list.Count(); i++) {
+		const wxString &key = list.GetKey(i);
+		wxString value;
+		if (list.Find(key, value)) {
+			ini->Write(key, value);
+		}
+	}
+	ini->SetPath(wxT("/"));
+}
+
+/// ファイル形式のキーを作成
+///
+/// ファイルサイズと判定用に読み込んだ先頭部分(ヘッダと最初のブロック)のCRC32から作る。
+/// ファイル全体は読まないので別の内容でも一致しうるが、値は使う前に解析で確かめる。
+/// @param [in] data ファイル先頭部分
+/// @return キー 空の時は作成できない
+wxString DiskDetectCache::MakeImageKey(const DiskProbeData &data)
+{
+	if (data.GetSize() == 0) return wxEmptyString;
+
+	wxFileOffset file_size = data.GetFileSize();
+	wxUint32 crc = Utils::CRC32(data.GetData(), (int)data.GetSize(), 0);
+
+	return wxString::Format(wxT("%x%08x-%08x"), (wxUint32)(file_size >> 32), (wxUint32)file_size, crc);
+}
+
+/// ファイル形式の判定結果を返す
+/// @param [in]  key            キー
+/// @param [out] file_format    ファイルの形式名("d88","plain"など)
+/// @param [out] disk_type_name ディスクテンプレートの名前("2D"など) なければ空
+/// @return true:あり
+bool DiskDetectCache::FindImage(const wxString &key, wxString &file_format, wxString &disk_type_name) const
+{
+	wxString value;
+	if (key.IsEmpty() || !m_images.Find(key, value)) return false;
+	file_format = value.BeforeFirst(DISK_DETECT_CACHE_SEPARATOR, &disk_type_name);
+	return !file_format.IsEmpty();
+}
+
+/// ファイル形式の判定結果を設定
+/// @param [in] key            キー
+/// @param [in] file_format    ファイルの形式名("d88","plain"など)
+/// @param [in] disk_type_name ディスクテンプレートの名前("2D"など)
+void DiskDetectCache::SetImage(const wxString &key, const wxString &file_format, const wxString &disk_type_name)
+{
+	if (key.IsEmpty() || file_format.IsEmpty()) return;
+	wxString value = file_format;
+	value += DISK_DETECT_CACHE_SEPARATOR;
+	value += disk_type_name;
+	m_images.Set(key, value);
+	m_modified = true;
+}
+
+/// ファイル形式の判定結果を削除
+/// @param [in] key キー
+void DiskDetectCache::RemoveImage(const wxString &key)
+{
+	if (m_images.Remove(key)) m_modified = true;
+}
+
+/// DISK BASICのキーを作成
+///
+/// ディスクの形状と全セクタのID、システム領域とファイル管理エリアのあるトラックのデータのCRC32から作る。
+/// 一致しても解析し直して確かめるので、データ領域までは含めない。
+/// セクタは参照のみで変更済みにしない。
+/// @param [in] disk           ディスク
+/// @param [in] side_number    サイド番号 両面なら-1
+/// @param [in] managed_tracks 候補のファイル管理エリアのあるトラック番号
+/// @return キー 空の時は作成できない
+wxString DiskDetectCache::MakeBasicKey(DiskImageDisk *disk, int side_number, const wxArrayInt &managed_tracks)
+{
+	DiskImageTracks *tracks = disk->GetTracks();
+	if (!tracks) return wxEmptyString;
+
+	wxUint32 crc = 0;
+	for(size_t ti=0; ti<tracks->Count(); ti++) {
+		DiskImageTrack *track = tracks->Item(ti);
+		if (!track) continue;
+		DiskImageSectors *sectors = track->GetSectors();
+		if (!sectors) continue;
+		for(size_t si=0; si<sectors->Count(); si++) {
+			DiskImageSector *sector = sectors->Item(si);
+			if (!sector) continue;
+			int size = sector->GetSectorSize();
+			wxUint8 id[5];
+			id[0] = (wxUint8)track->GetTrackNumber();
+			id[1] = (wxUint8)track->GetSideNumber();
+			id[2] = (wxUint8)sector->GetSectorNumber();
+			id[3] = (wxUint8)(size >> 8);
+			id[4] = (wxUint8)size;
+			crc = Utils::CRC32(id, (int)sizeof(id), crc);
+			int track_number = track->GetTrackNumber() - disk->GetTrackNumberBaseOnDisk();
+			if (track_number >= DISK_DETECT_CACHE_SYSTEM_TRACKS && managed_tracks.Index(track_number) == wxNOT_FOUND) {
+				continue;
+			}
+			const wxUint8 *data = sector->PeekSectorBuffer();
+			if (!data) continue;
+			crc = Utils::CRC32(data, size, crc);
+		}
+	}
+
+	return wxString::Format(wxT("%d-%d-%d-%d-%d-%08x")
+		, disk->GetSidesPerDisk(), disk->GetTracksPerSide(), disk->GetSectorsPerTrack(), disk->GetSectorSize()
+		, side_number, crc);
+}
+
+/// DISK BASICの判定結果を返す
+/// @param [in]  key             キー
+/// @param [out] basic_type_name DISK BASIC種類の名前
+/// @param [out] valid_ratio     判定時の解析結果
+/// @return true:あり
+bool DiskDetectCache::FindBasic(const wxString &key, wxString &basic_type_name, double &valid_ratio) const
+{
+	wxString value;
+	if (key.IsEmpty() || !m_basics.Find(key, value)) return false;
+	wxString ratio;
+	basic_type_name = value.BeforeFirst(DISK_DETECT_CACHE_SEPARATOR, &ratio);
+	if (basic_type_name.IsEmpty() || !ratio.ToCDouble(&valid_ratio)) return false;
+	return true;
+}
+
+/// DISK BASICの判定結果を設定
+/// @param [in] key             キー
+/// @param [in] basic_type_name DISK BASIC種類の名前
+/// @param [in] valid_ratio     解析結果
+void DiskDetectCache::SetBasic(const wxString &key, const wxString &basic_type_name, double valid_ratio)
+{
+	if (key.IsEmpty() || basic_type_name.IsEmpty()) return;
+	wxString value = basic_type_name;
+	value += DISK_DETECT_CACHE_SEPARATOR;
+	value += wxString::FromCDouble(valid_ratio, 6);
+	m_basics.Set(key, value);
+	m_modified = true;
+}
+
+/// DISK BASICの判定結果を削除
+/// @param [in] key キー
+void DiskDetectCache::RemoveBasic(const wxString &key)
+{
+	if (m_basics.Remove(key)) m_modified = true;
+}
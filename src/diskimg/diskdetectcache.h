@@ -0,0 +1,102 @@
+﻿/// @file diskdetectcache.h
+///
+/// @brief ディスクイメージの判定結果キャッシュ
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#ifndef DISK_DETECT_CACHE_H
+#define DISK_DETECT_CACHE_H
+
+#include "../common.h"
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <wx/dynarray.h>
+#include <wx/hashmap.h>
+
+
+/// キャッシュに保持する最大件数
+#define DISK_DETECT_CACHE_MAX	4096
+/// DISK BASICのキーで常にデータを含めるトラック数(ブート/システム領域)
+#define DISK_DETECT_CACHE_SYSTEM_TRACKS	2
+
+class wxConfigBase;
+class DiskImageDisk;
+class DiskProbeData;
+
+WX_DECLARE_STRING_HASH_MAP(wxString, DiskDetectCacheValues);
+
+/// 判定結果の保持リスト(形式ごと)
+class DiskDetectCacheList
+{
+private:
+	wxArrayString			m_keys;		///< キー(古い順)
+	DiskDetectCacheValues	m_values;	///< キーに対応する値
+
+public:
+	DiskDetectCacheList() {}
+	~DiskDetectCacheList() {}
+
+	/// キーに対応する値を返す
+	bool	Find(const wxString &key, wxString &value) const;
+	/// 値を設定（最大件数を超えたら古いものから削除）
+	void	Set(const wxString &key, const wxString &value);
+	/// 値を削除
+	bool	Remove(const wxString &key);
+	/// 件数
+	size_t	Count() const { return m_keys.Count(); }
+	/// キーを返す
+	const wxString &GetKey(size_t idx) const { return m_keys.Item(idx); }
+	/// 全削除
+	void	Clear();
+};
+
+/// ディスクイメージの判定結果キャッシュ
+///
+/// 同じ内容のファイルを開いた時にファイル形式やDISK BASICの判定を省略するため、
+/// 内容のハッシュをキーにして判定結果を設定ファイルと同じ場所に保存する。
+/// 値は使う前に必ず実際の解析で確かめ、一致しなければ削除する。
+class DiskDetectCache
+{
+private:
+	wxString			m_file;		///< 保存先ファイル
+	DiskDetectCacheList	m_images;	///< ファイル形式の判定結果
+	DiskDetectCacheList	m_basics;	///< DISK BASICの判定結果
+	bool				m_modified;	///< 変更したか
+
+	/// リストを読み込む
+	static void Load(wxConfigBase *ini, const wxString &group, DiskDetectCacheList &list);
+	/// リストを保存
+	static void Save(wxConfigBase *ini, const wxString &group, const DiskDetectCacheList &list);
+
+public:
+	DiskDetectCache();
+	~DiskDetectCache() {}
+
+	/// ファイルから読み込む
+	void Load(const wxString &file);
+	/// ファイルに保存する
+	void Save();
+
+	/// ファイル形式のキーを作成
+	static wxString MakeImageKey(const DiskProbeData &data);
+	/// ファイル形式の判定結果を返す
+	bool FindImage(const wxString &key, wxString &file_format, wxString &disk_type_name) const;
+	/// ファイル形式の判定結果を設定
+	void SetImage(const wxString &key, const wxString &file_format, const wxString &disk_type_name);
+	/// ファイル形式の判定結果を削除
+	void RemoveImage(const wxString &key);
+
+	/// DISK BASICのキーを作成
+	static wxString MakeBasicKey(DiskImageDisk *disk, int side_number, const wxArrayInt &managed_tracks);
+	/// DISK BASICの判定結果を返す
+	bool FindBasic(const wxString &key, wxString &basic_type_name, double &valid_ratio) const;
+	/// DISK BASICの判定結果を設定
+	void SetBasic(const wxString &key, const wxString &basic_type_name, double valid_ratio);
+	/// DISK BASICの判定結果を削除
+	void RemoveBasic(const wxString &key);
+};
+
+extern DiskDetectCache gDiskDetectCache;
+
+#endif /* DISK_DETECT_CACHE_H */
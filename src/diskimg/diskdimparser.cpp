@@ -121,6 +121,20 @@ int DiskDIMParser::Parse(wxInputStream &istream, const DiskParam *disk_param)
 	return p_result->GetValid();
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskDIMParser::Probe(const DiskProbeData &data)
+{
+	dim_dsk_header_t header;
+	if (!data.Copy(0, &header, sizeof(header))) {
+		// too short
+		return PROBE_NO;
+	}
+	return (memcmp(header.ident, DISK_DIM_HEADER, sizeof(header.ident)) == 0 ? PROBE_SIGNATURE : PROBE_NO);
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @param [in] disk_hints    ディスクパラメータヒント("2D"など)
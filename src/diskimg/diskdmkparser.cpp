@@ -159,7 +159,7 @@ wxUint32 DiskDmkParser::ParseSector(wxInputStream &istream, int sector_nums, int
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, false);
 	track->Add(sector);
 
-	wxUint8 *buf = sector->GetSectorBuffer();
+	wxUint8 *buf = sector->GetSectorBufferForParse();
 	int siz = sector->GetSectorBufferSize();
 
 	len = istream.Read(buf, siz).LastRead();
@@ -298,6 +298,29 @@ int DiskDmkParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_LIKELY ヘッダの内容が妥当
+/// @retval PROBE_NO     該当しない
+int DiskDmkParser::Probe(const DiskProbeData &data)
+{
+	trs_dmk_header_t header;
+	if (!data.Copy(0, &header, sizeof(header))) {
+		// too short
+		return PROBE_NO;
+	}
+	if (header.write_protected != 0x00 && header.write_protected != 0xff) {
+		return PROBE_NO;
+	}
+	if (header.signature != wxUINT32_SWAP_ON_BE(DMK_DISK_REAL) && header.signature != wxUINT32_SWAP_ON_BE(DMK_DISK_VIRTUAL)) {
+		return PROBE_NO;
+	}
+	if (((wxUint32)header.num_of_tracks * wxUINT16_SWAP_ON_BE(header.track_length) + sizeof(header)) < (wxUint32)data.GetFileSize()) {
+		return PROBE_NO;
+	}
+	return PROBE_LIKELY;
+}
+
 /// TRS-80 DMKファイルかどうかをチェック
 /// @param [in] istream    解析対象データ
 /// @return 0:Ok -1:NG
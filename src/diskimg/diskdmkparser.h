@@ -39,6 +39,8 @@ public:
 	DiskDmkParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskDmkParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// TRS-80 DMKファイルかどうかをチェック
 	int Check(wxInputStream &istream);
 	/// TRS-80 DMKファイルを解析
@@ -85,7 +85,7 @@ wxUint32 DiskDskParser::ParseSector(wxInputStream &istream, int sector_nums, voi
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, false);
 	track->Add(sector);
 
-	wxUint8 *buf = sector->GetSectorBuffer();
+	wxUint8 *buf = sector->GetSectorBufferForParse();
 	int siz = sector->GetSectorBufferSize();
 
 	size_t len = istream.Read(buf, siz).LastRead();
@@ -199,6 +199,20 @@ int DiskDskParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskDskParser::Probe(const DiskProbeData &data)
+{
+	cpc_dsk_header_t header;
+	if (data.Match(0, "MV - CPCEMU Disk-File\r\nDisk-Info\r\n", sizeof(header.ident))
+	 || data.Match(0, "EXTENDED CPC DSK File\r\nDisk-Info\r\n", sizeof(header.ident))) {
+		return PROBE_SIGNATURE;
+	}
+	return PROBE_NO;
+}
+
 /// CPC DSKファイルかどうかをチェック
 /// @param [in] istream    解析対象データ
 /// @return 0:Ok -1:NG
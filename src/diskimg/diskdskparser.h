@@ -38,6 +38,8 @@ public:
 	DiskDskParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskDskParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// CPC DSKファイルかどうかをチェック
 	int Check(wxInputStream &istream);
 	/// CPC DSKファイルを解析
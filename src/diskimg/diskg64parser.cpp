@@ -84,40 +84,101 @@ static wxUint8 gcr_bin_map[] = {
 	0xff, 0x9  ,0xa  ,0xb  ,0xff, 0xd  ,0xe  ,0xff ,
 };
 
+/// Commodore GCR 10-bit -> 8-bit テーブル
+class GCRDecodeTable
+{
+public:
+	wxUint8 bin[1024];
+
+	GCRDecodeTable();
+};
+
+/// 5ビット2つ分をまとめて変換できるようにする
+GCRDecodeTable::GCRDecodeTable()
+{
+	for(int n = 0; n < 1024; n++) {
+		bin[n] = (wxUint8)((gcr_bin_map[n >> 5] << 4) | gcr_bin_map[n & 0x1f]);
+	}
+}
+
+static GCRDecodeTable cGCRDecodeTable;
+
 /// GCRデータをデコード
+///
+/// 40ビット(5バイト)ずつ4バイトに変換する
+///
 /// @param [in]  indata		入力データ
-/// @param [in]  inbitlen	入力データ長さ(bit単位)
+/// @param [in]  inlen		入力データ長さ(byte単位)
 /// @param [out] outdata	出力データ
 /// @param [in]  outlen		出力データバッファサイズ
-size_t DiskG64Parser::DecodeGCR(const wxUint8 *indata, int inbitlen, wxUint8 *outdata, size_t outlen)
+/// @return 出力したデータ長さ
+size_t DiskG64Parser::DecodeGCR(const wxUint8 *indata, size_t inlen, wxUint8 *outdata, size_t outlen)
 {
-	int bitpos = 0;
+	const wxUint8 *bin = cGCRDecodeTable.bin;
+	size_t inpos = 0;
 	size_t outpos = 0;
-	while(bitpos < inbitlen && outpos < outlen) {
-		wxUint8 adat = 0;
-		for(int i=0; i<2; i++) {
-			int pos = (bitpos >> 3);
-			int bit = (bitpos & 7);
-
-			wxUint32 dat = (wxUint32)indata[pos] << 8 | indata[pos+1];
-
-			wxUint16 idat = (wxUint16)(dat >> (11 - bit));
-			idat &= 0x1f;
-
-			// 5ビットを4ビットに変換
-			wxUint8 ndat = gcr_bin_map[idat];
-
-			adat <<= 4;
-			adat |= ndat;
-
-			bitpos += 5;
-		}
-		outdata[outpos] = adat;
-		outpos++;
+	// 5バイト単位
+	while(inpos + 5 <= inlen && outpos + 4 <= outlen) {
+		wxUint64 grp = ((wxUint64)indata[inpos] << 32)
+			| ((wxUint32)indata[inpos + 1] << 24)
+			| ((wxUint32)indata[inpos + 2] << 16)
+			| ((wxUint32)indata[inpos + 3] << 8)
+			| indata[inpos + 4];
+		outdata[outpos    ] = bin[(grp >> 30) & 0x3ff];
+		outdata[outpos + 1] = bin[(grp >> 20) & 0x3ff];
+		outdata[outpos + 2] = bin[(grp >> 10) & 0x3ff];
+		outdata[outpos + 3] = bin[grp & 0x3ff];
+		inpos += 5;
+		outpos += 4;
+	}
+	if (inpos >= inlen || outpos >= outlen) {
+		return outpos;
+	}
+	// 残り 足りない部分は0とする
+	wxUint64 grp = 0;
+	for(size_t i = 0; i < 5; i++) {
+		grp <<= 8;
+		if (inpos + i < inlen) grp |= indata[inpos + i];
+	}
+	size_t remain = ((inlen - inpos) * 8 + 9) / 10;
+	for(size_t i = 0; i < remain && outpos < outlen; i++) {
+		outdata[outpos++] = bin[(grp >> (30 - i * 10)) & 0x3ff];
 	}
 	return outpos;
 }
 
+/// 同期マーク($ff)の終わりをさがす
+/// @param [in] indata 入力データ
+/// @param [in] pos    開始位置
+/// @param [in] len    入力データ長さ
+/// @return $ff以外の位置 なければlen
+size_t DiskG64Parser::SkipSyncMark(const wxUint8 *indata, size_t pos, size_t len)
+{
+	// 8バイトずつ比較
+	while(pos + 8 <= len) {
+		wxUint64 val;
+		memcpy(&val, &indata[pos], 8);
+		if (val != ~(wxUint64)0) break;
+		pos += 8;
+	}
+	while(pos < len && indata[pos] == 0xff) {
+		pos++;
+	}
+	return pos;
+}
+
+/// 同期マーク($ff)をさがす
+/// @param [in] indata 入力データ
+/// @param [in] pos    開始位置
+/// @param [in] len    入力データ長さ
+/// @return $ffの位置 なければlen
+size_t DiskG64Parser::FindSyncMark(const wxUint8 *indata, size_t pos, size_t len)
+{
+	if (pos >= len) return len;
+	const wxUint8 *p = (const wxUint8 *)memchr(&indata[pos], 0xff, len - pos);
+	return p ? (size_t)(p - indata) : len;
+}
+
 /// トラックデータの作成
 /// @param [in] istream         ディスクイメージ
 /// @param [in] disk_number     ディスク番号
@@ -156,43 +217,40 @@ int DiskG64Parser::ParseTrack(wxInputStream &istream, int disk_number, int side_
 
 	size_t inpos = 0;
 	size_t outpos = 0;
+	size_t inlen = (size_t)track_size;
 	// トラックデータの解析
-	while(inpos < (size_t)track_size) {
+	while(inpos < inlen) {
 		// skip header sync($ff) usually 4-5bytes
-		while(indata[inpos] == 0xff && inpos < (size_t)track_size) {
-			inpos++;
-		}
-		if (inpos >= (size_t)track_size) break;
+		inpos = SkipSyncMark(indata, inpos, inlen);
+		if (inpos >= inlen) break;
 
 		// header info CGR usually 10bytes
-		len = DecodeGCR(&indata[inpos], 80, &outdata[outpos], outsize - outpos);
+		len = insize - inpos;
+		if (len > 10) len = 10;
+		len = DecodeGCR(&indata[inpos], len, &outdata[outpos], outsize - outpos);
 		sector_headers.Add(&outdata[outpos]);
 		inpos += 10;
 		outpos += len;
 
 		// skip header gap
-		while(indata[inpos] != 0xff && inpos < (size_t)track_size) {
-			inpos++;
-		}
-		if (inpos >= (size_t)track_size) break;
+		inpos = FindSyncMark(indata, inpos, inlen);
+		if (inpos >= inlen) break;
 
 		// skip data sync($ff) usually 4-5bytes
-		while(indata[inpos] == 0xff && inpos < (size_t)track_size) {
-			inpos++;
-		}
-		if (inpos >= (size_t)track_size) break;
+		inpos = SkipSyncMark(indata, inpos, inlen);
+		if (inpos >= inlen) break;
 
 		// data CGR usually 325bytes
-		len = DecodeGCR(&indata[inpos], 2600, &outdata[outpos], outsize - outpos);
+		len = insize - inpos;
+		if (len > 325) len = 325;
+		len = DecodeGCR(&indata[inpos], len, &outdata[outpos], outsize - outpos);
 		sector_datas.Add(&outdata[outpos]);
 		inpos += 325;
 		outpos += len;
 
 		// skip data gap
-		while(indata[inpos] != 0xff && inpos < (size_t)track_size) {
-			inpos++;
-		}
-		if (inpos >= (size_t)track_size) break;
+		inpos = FindSyncMark(indata, inpos, inlen);
+		if (inpos >= inlen) break;
 	}
 
 	// トラック番号を計算
@@ -356,6 +414,15 @@ int DiskG64Parser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskG64Parser::Probe(const DiskProbeData &data)
+{
+	return data.Match(0, "GCR-1541", 8) ? PROBE_SIGNATURE : PROBE_NO;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @retval 1 選択ダイアログ表示
@@ -52,7 +52,11 @@ private:
 	/// ヘッダ解析
 	int ParseHeader(wxInputStream &istream, int disk_number);
 	/// GCRデータをデコード
-	static size_t DecodeGCR(const wxUint8 *indata, int inbitlen, wxUint8 *outdata, size_t outlen);
+	static size_t DecodeGCR(const wxUint8 *indata, size_t inlen, wxUint8 *outdata, size_t outlen);
+	/// 同期マーク($ff)の終わりをさがす
+	static size_t SkipSyncMark(const wxUint8 *indata, size_t pos, size_t len);
+	/// 同期マーク($ff)をさがす
+	static size_t FindSyncMark(const wxUint8 *indata, size_t pos, size_t len);
 
 	int Check(wxInputStream &istream, const DiskTypeHints *disk_hints, const DiskParam *disk_param, DiskParamPtrs &disk_params, DiskParam &manual_param);
 
@@ -60,6 +64,8 @@ public:
 	DiskG64Parser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskG64Parser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// チェック
 	int Check(wxInputStream &istream);
 	/// 解析
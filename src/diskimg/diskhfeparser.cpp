@@ -74,16 +74,121 @@ typedef struct st_hfe_track_offset_list {
 } hfe_track_offset_list_t;
 #pragma pack()
 
+/// MFM/FMデコード用テーブル
+class RunLengthLimitedTables
+{
+public:
+	wxUint8 mfm[65536];	///< MFM 16ビット -> 8ビット
+	wxUint8 fm[65536];	///< FM 16ビット -> 4ビット
+
+	RunLengthLimitedTables();
+};
+
+/// 16ビット分のビット列をデコードした値をテーブルにしておく
+RunLengthLimitedTables::RunLengthLimitedTables()
+{
+	for(int n = 0; n < 65536; n++) {
+		wxUint8 lo = (n & 0xff);
+		wxUint8 hi = ((n >> 8) & 0xff);
+		// MFM 2bytes -> 8bits
+		mfm[n] = ((lo & 0x80) >> 3) | ((lo & 0x20)) | ((lo & 0x08) << 3) | ((lo & 0x02) << 6)
+			| ((hi & 0x80) >> 7) | ((hi & 0x20) >> 4) | ((hi & 0x08) >> 1) | ((hi & 0x02) << 2);
+		// FM 2bytes -> 4bits
+		fm[n] = ((lo & 0x80) >> 5) | ((lo & 0x08) << 0)
+			| ((hi & 0x80) >> 7) | ((hi & 0x08) >> 2);
+	}
+}
+
+static RunLengthLimitedTables cRLLTables;
+
+//
+// Run-length limited(RLL)ビットストリーム
+//
+/// @param [in] n_data     解析対象データ
+/// @param [in] n_data_len データサイズ
+RunLengthLimitedStream::RunLengthLimitedStream(const wxUint8 *n_data, size_t n_data_len)
+{
+	data = n_data;
+	data_len = (n_data ? n_data_len : 0);
+	bit_len = data_len * 8;
+	bit_pos = 0;
+}
+
+/// 読み込み位置を進める
+/// @param [in] bits ビット数
+void RunLengthLimitedStream::Skip(size_t bits)
+{
+	bit_pos += bits;
+	if (bit_pos > bit_len) bit_pos = bit_len;
+}
+
+/// 読み込み位置からのオフセット位置の16ビットを返す
+/// @param [in] offset オフセット(ビット)
+/// @return 先頭のビットがb0になる 終端以降は0
+wxUint16 RunLengthLimitedStream::Peek16(size_t offset) const
+{
+	size_t pos = bit_pos + offset;
+	size_t idx = (pos >> 3);
+	wxUint32 val = (wxUint32)ByteAt(idx) | ((wxUint32)ByteAt(idx + 1) << 8) | ((wxUint32)ByteAt(idx + 2) << 16);
+	return (wxUint16)(val >> (pos & 7));
+}
+
+/// 読み込み位置からのオフセット位置の64ビットを返す
+/// @param [in] offset オフセット(ビット)
+/// @return 先頭のビットがb0になる 終端以降は0
+wxUint64 RunLengthLimitedStream::Peek64(size_t offset) const
+{
+	size_t pos = bit_pos + offset;
+	size_t idx = (pos >> 3);
+	int sft = (int)(pos & 7);
+	wxUint64 val = 0;
+	for(int i = 7; i >= 0; i--) {
+		val = (val << 8) | ByteAt(idx + i);
+	}
+	if (sft > 0) {
+		val = (val >> sft) | ((wxUint64)ByteAt(idx + 8) << (64 - sft));
+	}
+	return val;
+}
+
+/// ビットパターンを1ビットずつずらしてさがす
+///
+/// 64ビットの窓を1ビットずつずらして比較する
+///
+/// @param [in]  pattern パターン(先頭のビットがb0)
+/// @param [in]  bits    パターンのビット数(64まで)
+/// @param [out] offset  見つかった位置(読み込み位置からのビット数)
+/// @return パターンがあった
+bool RunLengthLimitedStream::FindBits(wxUint64 pattern, int bits, size_t &offset) const
+{
+	wxUint64 mask = (bits >= 64 ? ~(wxUint64)0 : (((wxUint64)1 << bits) - 1));
+	pattern &= mask;
+
+	size_t remain = GetRemainBits();
+	wxUint64 window = Peek64(0);
+	size_t next = bit_pos + 64;
+	for(size_t pos = 0; pos < remain; pos++) {
+		if ((window & mask) == pattern) {
+			offset = pos;
+			return true;
+		}
+		// 1ビットずらす
+		window >>= 1;
+		window |= ((wxUint64)((ByteAt(next >> 3) >> (next & 7)) & 1) << 63);
+		next++;
+	}
+	return false;
+}
+
 //
 // Run-length limited(RLL)パーサ
 //
 RunLengthLimitedParser::RunLengthLimitedParser()
+	: stream(NULL, 0)
 {
 	disk = NULL;
 	track = NULL;
 	track_size = 0;
-	data = NULL;
-	data_len = 0;
 	track_number = 0;
 	side_number = 0;
 	sector_nums = 0;
@@ -94,16 +199,15 @@ RunLengthLimitedParser::RunLengthLimitedParser()
 /// @param [in]     n_track_number トラック番号
 /// @param [in]     n_side_number  サイド番号
 /// @param [in]     n_d88_offset_pos D88オフセット番号
-/// @param [in,out] n_data         解析対象データ
+/// @param [in]     n_data         解析対象データ
 /// @param [in]     n_data_len     データサイズ
 /// @param [in,out] n_result       解析エラー情報
-RunLengthLimitedParser::RunLengthLimitedParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, wxUint8 *n_data, int n_data_len, DiskResult *n_result)
+RunLengthLimitedParser::RunLengthLimitedParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, const wxUint8 *n_data, int n_data_len, DiskResult *n_result)
+	: stream(n_data, n_data_len > 0 ? (size_t)n_data_len : 0)
 {
 	disk = n_disk;
 	track = NULL;
 	track_size = 0;
-	data = n_data;
-	data_len = n_data_len;
 	track_number = n_track_number;
 	side_number = n_side_number;
 	sector_nums = 0;
@@ -121,7 +225,7 @@ wxUint32 RunLengthLimitedParser::Parse()
 	track = disk->NewImageTrack(track_number, side_number, d88_offset_pos, 1);
 	track_size = 0;
 
-	while(data_len > 0) {
+	while(!stream.IsEnd()) {
 		if (!AdjustGap()) {
 			break;
 		}
@@ -146,11 +250,11 @@ bool RunLengthLimitedParser::GetData()
 }
 
 /// セクタデータをセット
-/// @param [in,out] indata       解析対象データ
+/// @param [in]     offset       データの位置(読み込み位置からのビット数)
 /// @param [in]     single       single sided?
 /// @param [in]     deleted      Deleted mark?
 /// @return セクタサイズ
-int RunLengthLimitedParser::SetSectorData(wxUint8 *indata, bool single, bool deleted)
+int RunLengthLimitedParser::SetSectorData(size_t offset, bool single, bool deleted)
 {
 	int track_number = curr_ids.C;
 	int side_number = curr_ids.H;
@@ -169,13 +273,14 @@ int RunLengthLimitedParser::SetSectorData(wxUint8 *indata, bool single, bool del
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, 1, false);
 	track->Add(sector);
 
-	wxUint8 *buf = sector->GetSectorBuffer();
+	wxUint8 *buf = sector->GetSectorBufferForParse();
 	int siz = sector->GetSectorBufferSize();
-	int unit = GetDecodeUnit();
+	size_t unit_bits = (size_t)GetDecodeUnit() * 8;
 	for(int i=0; i<siz; i++) {
-		buf[i] = DecodeData(&indata[i * unit]);
+		buf[i] = DecodeData(offset);
+		offset += unit_bits;
 	}
-	wxUint16 crc = ((wxUint16)DecodeData(&indata[siz * unit]) << 8) | DecodeData(&indata[(siz + 1) * unit]);
+	wxUint16 crc = ((wxUint16)DecodeData(offset) << 8) | DecodeData(offset + unit_bits);
 	sector->SetRecordedCRC(crc);
 	sector->SetSingleDensity(single);
 	sector->SetDeletedMark(deleted);
@@ -185,63 +290,11 @@ int RunLengthLimitedParser::SetSectorData(wxUint8 *indata, bool single, bool del
 	return sector->GetSize();
 }
 /// データをデコード
-wxUint8 RunLengthLimitedParser::DecodeData(const wxUint8 *indata)
+wxUint8 RunLengthLimitedParser::DecodeData(size_t offset) const
 {
 	return 0;
 }
 
-/// バッファをシフト
-/// @param [in,out] data         データ
-/// @param [in]     len          データ長さ
-/// @param [in]     sftcnt       シフト数
-/// @return シフトした後のデータ数
-int RunLengthLimitedParser::ShiftBytes(wxUint8 *data, int len, int sftcnt)
-{
-	if (sftcnt <= 0) return len;
-
-	int endpos = len - sftcnt;
-
-	for(int i=0; i<endpos; i++) {
-		data[i] = data[i + sftcnt];
-	}
-	data[endpos] = 0x00;
-
-	len -= sftcnt;
-
-	return len;
-}
-
-/// バッファをビットシフト
-/// @param [in,out] data         データ
-/// @param [in]     len          データ長さ
-/// @param [in]     sftcnt       シフト数
-/// @return シフトした後のデータ数
-int RunLengthLimitedParser::ShiftBits(wxUint8 *data, int len, int sftcnt)
-{
-	if (sftcnt <= 0) return len;
-
-	int divn = (sftcnt >> 3);
-	int modn = (sftcnt & 7);
-
-	// lshift bytes
-	if (divn > 0) {
-		len = ShiftBytes(data, len, divn);
-	}
-
-	if (modn == 0) return len;
-
-	// bit shift
-	wxUint8 carry = 0x00;
-	for(int i=len-1; i>=0; i--) {
-		wxUint8 c = (data[i] << (8-modn));
-		data[i] >>= modn;
-		data[i] |= carry;
-		carry = c;
-	}
-
-	return len;
-}
-
 //
 // IBM MFMパーサ
 //
@@ -253,13 +306,13 @@ FormatMFMParser::FormatMFMParser()
 /// @param [in]     n_track_number トラック番号
 /// @param [in]     n_side_number  サイド番号
 /// @param [in]     n_d88_offset_pos D88オフセット番号
-/// @param [in,out] n_data         解析対象データ
+/// @param [in]     n_data         解析対象データ
 /// @param [in]     n_data_len     データサイズ
 /// @param [in,out] n_result       解析エラー情報
 ///
 /// @note Bit stream order is:
 /// first <- b0 <- b1 <- b2 <- ... <- b7 <- next byte b0 <- b1 ...
-FormatMFMParser::FormatMFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, wxUint8 *n_data, int n_data_len, DiskResult *n_result)
+FormatMFMParser::FormatMFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, const wxUint8 *n_data, int n_data_len, DiskResult *n_result)
 	: RunLengthLimitedParser(n_disk, n_track_number, n_side_number, n_d88_offset_pos, n_data, n_data_len, n_result)
 {
 }
@@ -280,65 +333,24 @@ FormatMFMParser::FormatMFMParser(DiskImageDisk *n_disk, int n_track_number, int
 /// @return GAP and SYNCフィールドあり
 bool FormatMFMParser::AdjustGap()
 {
-	bool found = false;
-	int maxlen = data_len;
-	wxUint8 buf[6];
-	int pos = 0;
+	size_t offset = 0;
 	// search GAP field
-	for(; pos<maxlen; pos++) {
-		memcpy(buf, &data[pos], 3);
-		int cnt = 0;
-		for(; cnt<8; cnt++) {
-			if (memcmp(buf, "\x49\x2a", 2) == 0) {
-				found = true;
-				break;
-			}
-
-			// bit shift left
-			ShiftBits(buf, 3, 1);
-		}
-		if (found) {
-			data_len = ShiftBits(data, data_len, pos * 8 + cnt);
-			break;
-		}
-	}
-	if (!found) {
-		data_len = 0;
-		return found;
+	if (!stream.FindBits(0x2a49, 16, offset)) {
+		stream.SkipToEnd();
+		return false;
 	}
-	// search the terminate of SYNC field
-	found =false;
-	pos = 0;
-	for(; pos<maxlen; pos++) {
-		memcpy(buf, &data[pos], 4);
-		int cnt = 0;
-		for(; cnt<8; cnt++) {
-			if (memcmp(buf, "\x55\x55\x25", 3) == 0
-			 || memcmp(buf, "\x55\x55\xa5", 3) == 0) {
-				found = true;
-				break;
-			}
+	stream.Skip(offset);
 
-			// bit shift left
-			ShiftBits(buf, 4, 1);
-		}
-		if (found) {
-			if (cnt >= 4) {
-				cnt -= 4;
-			} else {
-				pos--;
-				cnt += 4;
-			}
-			if (pos >= 0) {
-				data_len = ShiftBits(data, data_len, pos * 8 + cnt);
-			}
-			break;
-		}
+	// search the terminate of SYNC field
+	// 55 55 25 or 55 55 a5 (differ only in the last bit)
+	if (!stream.FindBits(0x255555, 23, offset)) {
+		stream.SkipToEnd();
+		return false;
 	}
-	if (!found) {
-		data_len = 0;
+	if (offset >= 4) {
+		stream.Skip(offset - 4);
 	}
-	return found;
+	return true;
 }
 /** データの解析(MFM)
 
@@ -381,64 +393,52 @@ bool FormatMFMParser::AdjustGap()
 /// @return AMフィールドあり
 bool FormatMFMParser::GetData()
 {
-	bool found = false;
-	int maxlen = data_len;
-	int pos = 0;
-	for(; pos<maxlen && !found; pos++) {
-		if (memcmp(&data[pos], "\x55\x55\x4a\x24\x4a\x24\x4a\x24\xaa\x4a", 10) == 0) {
+	// SYNC(00 00) + C2 C2 C2 / A1 A1 A1
+	const wxUint64 pre_idx = wxULL(0x244a244a244a5555);
+	const wxUint64 pre_am  = wxULL(0x9122912291225555);
+
+	size_t maxlen = stream.GetRemainBits();
+	for(size_t pos = 0; pos < maxlen; pos += 8) {
+		wxUint64 pre = stream.Peek64(pos);
+		if (pre != pre_idx && pre != pre_am) {
+			continue;
+		}
+		wxUint16 mark = stream.Peek16(pos + 64);
+		if (pre == pre_idx && mark == 0x4aaa) {
 			// INDEX MARK
-			found = true;
-			data_len = ShiftBytes(data, data_len, pos + 10);
-			break;
-		} else if (memcmp(&data[pos], "\x55\x55\x22\x91\x22\x91\x22\x91\xaa\x2a", 10) == 0) {
+			stream.Skip(pos + 10 * 8);
+			return true;
+		} else if (pre == pre_am && mark == 0x2aaa) {
 			// ID MARK
-			found = true;
 			// Get C,H,R,N,CRC
-			curr_ids.C = DecodeData(&data[pos+10]);
-			curr_ids.H = DecodeData(&data[pos+12]);
-			curr_ids.R = DecodeData(&data[pos+14]);
-			curr_ids.N = DecodeData(&data[pos+16]);
-			curr_ids.CRC = (wxUint16)DecodeData(&data[pos+18]) * 256 + DecodeData(&data[pos+20]);
-
-			data_len = ShiftBytes(data, data_len, pos + 22);
-			break;
-		} else if (memcmp(&data[pos], "\x55\x55\x22\x91\x22\x91\x22\x91\xaa\xa2", 10) == 0) {
-			// DATA MARK
-			found = true;
+			curr_ids.C = DecodeData(pos + 10 * 8);
+			curr_ids.H = DecodeData(pos + 12 * 8);
+			curr_ids.R = DecodeData(pos + 14 * 8);
+			curr_ids.N = DecodeData(pos + 16 * 8);
+			curr_ids.CRC = (wxUint16)DecodeData(pos + 18 * 8) * 256 + DecodeData(pos + 20 * 8);
+
+			stream.Skip(pos + 22 * 8);
+			return true;
+		} else if (pre == pre_am && (mark == 0xa2aa || mark == 0x52aa)) {
+			// DATA MARK / DELETED DATA MARK
 			// Get Data
-			int siz = SetSectorData(&data[pos+10], false, false);
+			int siz = SetSectorData(pos + 10 * 8, false, mark == 0x52aa);
 			track_size += (wxUint32)siz;
 
 			int unit = GetDecodeUnit();
-			data_len = ShiftBytes(data, data_len, pos + ((siz + 2) * unit) + 10);
-			break;
-		} else if (memcmp(&data[pos], "\x55\x55\x22\x91\x22\x91\x22\x91\xaa\x52", 10) == 0) {
-			// DELETED DATA MARK
-			found = true;
-			// Get Data
-			int siz = SetSectorData(&data[pos+10], false, true);
-			track_size += (wxUint32)siz;
-
-			int unit = GetDecodeUnit();
-			data_len = ShiftBytes(data, data_len, pos + ((siz + 2) * unit) + 10);
-			break;
+			stream.Skip(pos + (((siz + 2) * unit) + 10) * 8);
+			return true;
 		}
 	}
-	if (!found) {
-		data_len = 0;
-	}
-	return found;
+	stream.SkipToEnd();
+	return false;
 }
 /// データをデコード(MFM)
-/// @param [in] indata 解析対象データ(2bytes)
+/// @param [in] offset 解析対象データの位置(2bytes)
 /// @return デコード後のデータ
-wxUint8 FormatMFMParser::DecodeData(const wxUint8 *indata)
+wxUint8 FormatMFMParser::DecodeData(size_t offset) const
 {
-	wxUint8 outdata;
-	outdata = ((indata[0] & 0x80) >> 3) | ((indata[0] & 0x20)) | ((indata[0] & 0x08) << 3) | ((indata[0] & 0x02) << 6);
-	outdata |= ((indata[1] & 0x80) >> 7) | ((indata[1] & 0x20) >> 4) | ((indata[1] & 0x08) >> 1) | ((indata[1] & 0x02) << 2);
-
-	return outdata;
+	return cRLLTables.mfm[stream.Peek16(offset)];
 }
 
 //
@@ -452,13 +452,13 @@ FormatFMParser::FormatFMParser()
 /// @param [in]     n_track_number トラック番号
 /// @param [in]     n_side_number  サイド番号
 /// @param [in]     n_d88_offset_pos D88オフセット番号
-/// @param [in,out] n_data         解析対象データ
+/// @param [in]     n_data         解析対象データ
 /// @param [in]     n_data_len     データサイズ
 /// @param [in,out] n_result       解析エラー情報
 ///
 /// @note Bit stream order is:
 /// first <- b0 <- b1 <- b2 <- ... <- b7 <- next byte b0 <- b1 ...
-FormatFMParser::FormatFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, wxUint8 *n_data, int n_data_len, DiskResult *n_result)
+FormatFMParser::FormatFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, const wxUint8 *n_data, int n_data_len, DiskResult *n_result)
 	: RunLengthLimitedParser(n_disk, n_track_number, n_side_number, n_d88_offset_pos, n_data, n_data_len, n_result)
 {
 }
@@ -479,67 +479,24 @@ FormatFMParser::FormatFMParser(DiskImageDisk *n_disk, int n_track_number, int n_
 /// @return GAP and SYNCフィールドあり
 bool FormatFMParser::AdjustGap()
 {
-	bool found = false;
-	int maxlen = data_len;
-	wxUint8 buf[8];
-	int pos = 0;
+	size_t offset = 0;
 	// search GAP field
-	for(; pos<maxlen; pos++) {
-		memcpy(buf, &data[pos], 5);
-		int cnt = 0;
-		for(; cnt<8; cnt++) {
-			if (memcmp(buf, "\xaa\xaa\xaa\xaa", 4) == 0) {
-				found = true;
-				break;
-			}
-
-			// bit shift left
-			ShiftBits(buf, 5, 1);
-		}
-		if (found) {
-			data_len = ShiftBits(data, data_len, pos * 8 + cnt);
-			break;
-		}
-	}
-	if (!found) {
-		data_len = 0;
-		return found;
+	if (!stream.FindBits(0xaaaaaaaa, 32, offset)) {
+		stream.SkipToEnd();
+		return false;
 	}
-	// search the terminate of SYNC field
-	found =false;
-	pos = 0;
-	for(; pos<maxlen; pos++) {
-//		if (pos == 0xb3) {
-//			int nn=0;
-//		}
-		memcpy(buf, &data[pos], 6);
-		int cnt = 0;
-		for(; cnt<8; cnt++) {
-			if (memcmp(buf, "\x22\x22\x22\x22\xa2", 5) == 0) {
-				found = true;
-				break;
-			}
+	stream.Skip(offset);
 
-			// bit shift left
-			ShiftBits(buf, 6, 1);
-		}
-		if (found) {
-			if (cnt >= 4) {
-				cnt -= 4;
-			} else {
-				pos--;
-				cnt += 4;
-			}
-			if (pos >= 0) {
-				data_len = ShiftBits(data, data_len, pos * 8 + cnt);
-			}
-			break;
-		}
+	// search the terminate of SYNC field
+	// 22 22 22 22 a2
+	if (!stream.FindBits(wxULL(0xa222222222), 40, offset)) {
+		stream.SkipToEnd();
+		return false;
 	}
-	if (!found) {
-		data_len = 0;
+	if (offset >= 4) {
+		stream.Skip(offset - 4);
 	}
-	return found;
+	return true;
 }
 /** データの解析(FM)
 
@@ -570,66 +527,50 @@ bool FormatFMParser::AdjustGap()
 /// @return AMフィールドあり
 bool FormatFMParser::GetData()
 {
-	bool found = false;
-	int maxlen = data_len;
-	int pos = 0;
-	for(; pos<maxlen && !found; pos++) {
-		if (memcmp(&data[pos], "\x22\x22\x22\x22\xaa\xa8\xa8\x22", 8) == 0) {
+	// SYNC(00) + mark
+	const wxUint64 idx_mark = wxULL(0x22a8a8aa22222222);
+	const wxUint64 id_mark  = wxULL(0x2aa888aa22222222);
+	const wxUint64 dat_mark = wxULL(0xaa2888aa22222222);
+	const wxUint64 del_mark = wxULL(0x222888aa22222222);
+
+	size_t maxlen = stream.GetRemainBits();
+	for(size_t pos = 0; pos < maxlen; pos += 8) {
+		wxUint64 mark = stream.Peek64(pos);
+		if (mark == idx_mark) {
 			// INDEX MARK
-			found = true;
-			data_len = ShiftBytes(data, data_len, pos + 8);
-			break;
-		} else if (memcmp(&data[pos], "\x22\x22\x22\x22\xaa\x88\xa8\x2a", 8) == 0) {
+			stream.Skip(pos + 8 * 8);
+			return true;
+		} else if (mark == id_mark) {
 			// ID MARK
-			found = true;
 			// Get C,H,R,N,CRC
-			curr_ids.C = DecodeData(&data[pos+8]);
-			curr_ids.H = DecodeData(&data[pos+12]);
-			curr_ids.R = DecodeData(&data[pos+16]);
-			curr_ids.N = DecodeData(&data[pos+20]);
-			curr_ids.CRC = (wxUint16)DecodeData(&data[pos+24]) * 256 + DecodeData(&data[pos+28]);
-
-			data_len = ShiftBytes(data, data_len, pos + 32);
-			break;
-		} else if (memcmp(&data[pos], "\x22\x22\x22\x22\xaa\x88\x28\xaa", 8) == 0) {
-			// DATA MARK
-			found = true;
+			curr_ids.C = DecodeData(pos + 8 * 8);
+			curr_ids.H = DecodeData(pos + 12 * 8);
+			curr_ids.R = DecodeData(pos + 16 * 8);
+			curr_ids.N = DecodeData(pos + 20 * 8);
+			curr_ids.CRC = (wxUint16)DecodeData(pos + 24 * 8) * 256 + DecodeData(pos + 28 * 8);
+
+			stream.Skip(pos + 32 * 8);
+			return true;
+		} else if (mark == dat_mark || mark == del_mark) {
+			// DATA MARK / DELETED DATA MARK
 			// Get Data
-			int siz = SetSectorData(&data[pos+8], true, false);
+			int siz = SetSectorData(pos + 8 * 8, true, mark == del_mark);
 			track_size += (wxUint32)siz;
 
 			int unit = GetDecodeUnit();
-			data_len = ShiftBytes(data, data_len, pos + ((siz + 2) * unit) + 8);
-			break;
-		} else if (memcmp(&data[pos], "\x22\x22\x22\x22\xaa\x88\x28\x22", 8) == 0) {
-			// DELETED DATA MARK
-			found = true;
-			// Get Data
-			int siz = SetSectorData(&data[pos+8], true, true);
-			track_size += (wxUint32)siz;
-
-			int unit = GetDecodeUnit();
-			data_len = ShiftBytes(data, data_len, pos + ((siz + 2) * unit) + 8);
-			break;
+			stream.Skip(pos + (((siz + 2) * unit) + 8) * 8);
+			return true;
 		}
 	}
-	if (!found) {
-		data_len = 0;
-	}
-	return found;
+	stream.SkipToEnd();
+	return false;
 }
 /// データをデコード(FM)
-/// @param [in] indata 解析対象データ(4bytes)
+/// @param [in] offset 解析対象データの位置(4bytes)
 /// @return デコード後のデータ
-wxUint8 FormatFMParser::DecodeData(const wxUint8 *indata)
+wxUint8 FormatFMParser::DecodeData(size_t offset) const
 {
-	wxUint8 outdata;
-	outdata = ((indata[0] & 0x80) >> 1) | ((indata[0] & 0x08) << 4);
-	outdata |= ((indata[1] & 0x80) >> 3) | ((indata[1] & 0x08) << 2);
-	outdata |= ((indata[2] & 0x80) >> 5) | ((indata[2] & 0x08));
-	outdata |= ((indata[3] & 0x80) >> 7) | ((indata[3] & 0x08) >> 2);
-
-	return outdata;
+	return (cRLLTables.fm[stream.Peek16(offset)] << 4) | cRLLTables.fm[stream.Peek16(offset + 16)];
 }
 
 //
@@ -827,6 +768,20 @@ int DiskHfeParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 //
 //};
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskHfeParser::Probe(const DiskProbeData &data)
+{
+	hfe_header_t header;
+	if (data.Match(0, DISK_HFE_HEADER, sizeof(header.signature))
+	 || data.Match(0, DISK_HFE_HEADV3, sizeof(header.signature))) {
+		return PROBE_SIGNATURE;
+	}
+	return PROBE_NO;
+}
+
 /// HxC HFEファイルかどうかをチェック
 /// @param [in,out] istream    解析対象データ
 /// @return 0:Ok -1:NG
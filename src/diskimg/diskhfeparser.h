@@ -19,6 +19,43 @@ class DiskImageFile;
 class DiskResult;
 class FileParamFormat;
 
+/// @brief Run-length limited(RLL)ビットストリーム
+///
+/// バッファをシフトせずに読み込み位置(ビット)を進める
+///
+/// @note Bit stream order is:
+/// first <- b0 <- b1 <- b2 <- ... <- b7 <- next byte b0 <- b1 ...
+class RunLengthLimitedStream
+{
+private:
+	const wxUint8 *data;
+	size_t data_len;	///< データサイズ(バイト)
+	size_t bit_len;		///< データサイズ(ビット)
+	size_t bit_pos;		///< 読み込み位置(ビット)
+
+	/// 指定位置のバイトを返す 範囲外は0
+	wxUint8 ByteAt(size_t idx) const { return idx < data_len ? data[idx] : 0; }
+
+public:
+	RunLengthLimitedStream(const wxUint8 *n_data, size_t n_data_len);
+
+	/// 終端に達したか
+	bool IsEnd() const { return (bit_pos >= bit_len); }
+	/// 残りのビット数
+	size_t GetRemainBits() const { return IsEnd() ? 0 : bit_len - bit_pos; }
+	/// 読み込み位置を進める
+	void Skip(size_t bits);
+	/// 終端まで進める
+	void SkipToEnd() { bit_pos = bit_len; }
+
+	/// 読み込み位置からのオフセット位置の16ビットを返す
+	wxUint16 Peek16(size_t offset) const;
+	/// 読み込み位置からのオフセット位置の64ビットを返す
+	wxUint64 Peek64(size_t offset) const;
+	/// ビットパターンを1ビットずつずらしてさがす
+	bool FindBits(wxUint64 pattern, int bits, size_t &offset) const;
+};
+
 /// @brief Run-length limited(RLL)パーサ
 ///
 /// 1トラック分を解析
@@ -28,8 +65,7 @@ protected:
 	DiskImageDisk  *disk;
 	DiskImageTrack *track;
 	wxUint32 track_size;
-	wxUint8 *data;
-	int data_len;
+	RunLengthLimitedStream stream;
 	int track_number;
 	int side_number;
 	int sector_nums;
@@ -46,12 +82,12 @@ protected:
 
 	virtual bool AdjustGap();
 	virtual bool GetData();
-	virtual int SetSectorData(wxUint8 *indata, bool single, bool deleted);
-	virtual wxUint8 DecodeData(const wxUint8 *indata);
+	virtual int SetSectorData(size_t offset, bool single, bool deleted);
+	virtual wxUint8 DecodeData(size_t offset) const;
 
 public:
 	RunLengthLimitedParser();
-	RunLengthLimitedParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, wxUint8 *n_data, int n_data_len, DiskResult *n_result);
+	RunLengthLimitedParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, const wxUint8 *n_data, int n_data_len, DiskResult *n_result);
 	virtual ~RunLengthLimitedParser();
 
 	virtual wxUint32 Parse();
@@ -60,11 +96,6 @@ public:
 
 	DiskImageTrack *GetTrack() { return track; }
 	int GetSectorNums() const { return sector_nums; }
-
-	/// バッファをシフト
-	static int ShiftBytes(wxUint8 *data, int len, int sftcnt);
-	/// バッファをビットシフト
-	static int ShiftBits(wxUint8 *data, int len, int sftcnt);
 };
 
 /// @brief IBM MFMパーサ
@@ -75,11 +106,11 @@ class FormatMFMParser : public RunLengthLimitedParser
 private:
 	bool AdjustGap();
 	bool GetData();
-	wxUint8 DecodeData(const wxUint8 *indata);
+	wxUint8 DecodeData(size_t offset) const;
 
 public:
 	FormatMFMParser();
-	FormatMFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, wxUint8 *n_data, int n_data_len, DiskResult *n_result);
+	FormatMFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, const wxUint8 *n_data, int n_data_len, DiskResult *n_result);
 	int GetDecodeUnit() const { return 2; }
 };
 
@@ -91,11 +122,11 @@ class FormatFMParser : public RunLengthLimitedParser
 private:
 	bool AdjustGap();
 	bool GetData();
-	wxUint8 DecodeData(const wxUint8 *indata);
+	wxUint8 DecodeData(size_t offset) const;
 
 public:
 	FormatFMParser();
-	FormatFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, wxUint8 *n_data, int n_data_len, DiskResult *n_result);
+	FormatFMParser(DiskImageDisk *n_disk, int n_track_number, int n_side_number, int n_d88_offset_pos, const wxUint8 *n_data, int n_data_len, DiskResult *n_result);
 	int GetDecodeUnit() const { return 4; }
 };
 
@@ -114,6 +145,8 @@ public:
 	DiskHfeParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskHfeParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// HxC HFEファイルかどうかをチェック
 	int Check(wxInputStream &istream);
 	/// HxC HFEファイルを解析
@@ -12,9 +12,14 @@
 #include "diskparser.h"
 #include "diskwriter.h"
 #include "diskimagecreator.h"
+#include "diskmapfile.h"
+#include "diskverify.h"
+#include "../config.h"
 #include "../basicfmt/basicparam.h"
 #include "../basicfmt/basicfmt.h"
 
+/// セクタデータの領域を追加で確保するときの最小サイズ
+#define DISK_ARENA_MIN_SIZE	0x10000
 
 // ----------------------------------------------------------------------
 //
@@ -62,12 +67,45 @@ int IntHashMapUtil::MinValue(int src, int value)
 //
 DiskImageSector::DiskImageSector(int n_num)
 {
+	parent = NULL;
 	m_num = n_num;
+	m_dirty = false;
+	m_file_pos = -1;
+	m_write_gen = 0;
 }
 
 DiskImageSector::~DiskImageSector()
 {
 }
+/// トラックのセクタ検索用インデックスを無効にする
+void DiskImageSector::InvalidateParentIndex()
+{
+	if (parent) parent->InvalidateSectorIndex();
+}
+/// データを書き換えたことを記録
+/// ディスクにも伝える
+void DiskImageSector::IncreaseWriteGeneration()
+{
+	m_write_gen++;
+	DiskImageDisk *disk = (parent ? parent->GetDisk() : NULL);
+	if (disk) disk->IncreaseDataGeneration();
+}
+/// 変更済みを設定
+/// 書き込みがあったことをトラックに伝える
+void DiskImageSector::SetModify()
+{
+	if (m_dirty) return;
+	m_dirty = true;
+	if (parent) parent->IncreaseDirtySectors();
+}
+/// 変更済みをクリア
+/// 書き込みがなくなったことをトラックに伝える
+void DiskImageSector::ClearModify()
+{
+	if (!m_dirty) return;
+	m_dirty = false;
+	if (parent) parent->DecreaseDirtySectors();
+}
 /// セクタ番号の比較
 int DiskImageSector::Compare(DiskImageSector *item1, DiskImageSector *item2)
 {
@@ -113,9 +151,12 @@ DiskImageTrack::DiskImageTrack(DiskImageDisk *disk)
 	m_interleave = 1;
 
 	m_orig_sectors = 0;
+	m_dirty_sectors = 0;
 
 	extra_data = NULL;
 	extra_size = 0;
+
+	m_sector_index_valid = false;
 }
 
 /// @param [in] disk            ディスク
@@ -134,9 +175,12 @@ DiskImageTrack::DiskImageTrack(DiskImageDisk *disk, int n_trk_num, int n_sid_num
 	m_interleave = n_interleave;
 
 	m_orig_sectors = 0;
+	m_dirty_sectors = 0;
 
 	extra_data = NULL;
 	extra_size = 0;
+
+	m_sector_index_valid = false;
 }
 
 DiskImageTrack::~DiskImageTrack()
@@ -157,6 +201,14 @@ size_t DiskImageTrack::Add(DiskImageSector *newsec)
 {
 	if (!sectors) sectors = new DiskImageSectors;
 	sectors->Add(newsec);
+	newsec->SetTrack(this);
+	if (newsec->IsDirty()) {
+		IncreaseDirtySectors();
+	}
+	if (m_sector_index_valid) {
+		AddSectorIndex(newsec, (int)sectors->Count() - 1);
+	}
+	if (parent) parent->IncreaseLayoutGeneration();
 	m_orig_sectors = sectors->Count();
 	return m_orig_sectors;
 }
@@ -220,6 +272,9 @@ int DiskImageTrack::DeleteSectorByIndex(int pos)
 	removed_size += sector->GetSize();
 	delete sector;
 	sectors->RemoveAt(pos);
+	InvalidateSectorIndex();
+	// 削除も書き込みとして数える
+	IncreaseDirtySectors();
 
 	// 余りバッファ領域のサイズを増やす
 	IncreaseExtraDataSize(removed_size);
@@ -253,6 +308,9 @@ int DiskImageTrack::DeleteSectors(int start_sector_num, int end_sector_num)
 		}
 	}
 	if (removed) {
+		InvalidateSectorIndex();
+		// 削除も書き込みとして数える
+		IncreaseDirtySectors();
 		// 余りバッファ領域のサイズを増やす
 		IncreaseExtraDataSize(removed_size);
 		// トラックのサイズを再計算&オフセットを再計算する
@@ -379,17 +437,86 @@ int DiskImageTrack::GetSectorsPerTrack() const
 /// @return セクタ or NULL
 DiskImageSector *DiskImageTrack::GetSector(int sector_number, int density)
 {
-	DiskImageSector *sector = NULL;
+	if (!sectors) return NULL;
+
+	if (!m_sector_index_valid) {
+		RebuildSectorIndex();
+	}
+	IntHashMap::iterator it = m_sector_index.find(SectorIndexKey(sector_number, density));
+	if (it == m_sector_index.end()) {
+		return NULL;
+	}
+	DiskImageSector *sector = sectors->Item(it->second);
+	if (sector->IsSameSector(sector_number, density)) {
+		return sector;
+	}
+
+	// インデックスと一致しない場合は順に探す
+	sector = NULL;
+	for(size_t pos=0; pos<sectors->Count(); pos++) {
+		DiskImageSector *s = sectors->Item(pos);
+		if (s->IsSameSector(sector_number, density)) {
+			sector = s;
+			break;
+		}
+	}
+	return sector;
+}
+
+/// セクタ検索用インデックスのキーを返す
+/// @param[in] sector_number セクタ番号
+/// @param[in] density       密度 0:倍密度 1:単密度 -1:条件から除外
+int DiskImageTrack::SectorIndexKey(int sector_number, int density)
+{
+	return sector_number * 4 + (density < 0 ? 2 : (density & 1));
+}
+
+/// セクタ検索用インデックスに追加する
+/// @note 同じキーがある場合は先にあるセクタを優先する
+/// @param[in] sector セクタ
+/// @param[in] pos    セクタリスト内の位置
+void DiskImageTrack::AddSectorIndex(DiskImageSector *sector, int pos)
+{
+	// 削除マーク付きのセクタはGetSector()の対象外
+	if (sector->IsDeleted()) return;
+
+	int num = sector->GetSectorNumber();
+	int keys[2];
+	keys[0] = SectorIndexKey(num, sector->IsSingleDensity() ? 1 : 0);
+	keys[1] = SectorIndexKey(num, -1);
+	for(int i=0; i<2; i++) {
+		if (m_sector_index.find(keys[i]) == m_sector_index.end()) {
+			m_sector_index[keys[i]] = pos;
+		}
+	}
+}
+
+/// セクタ検索用インデックスを作り直す
+void DiskImageTrack::RebuildSectorIndex()
+{
+	m_sector_index.clear();
 	if (sectors) {
 		for(size_t pos=0; pos<sectors->Count(); pos++) {
-			DiskImageSector *s = sectors->Item(pos);
-			if (s->IsSameSector(sector_number, density)) {
-				sector = s;
-				break;
-			}
+			AddSectorIndex(sectors->Item(pos), (int)pos);
 		}
 	}
-	return sector;
+	m_sector_index_valid = true;
+}
+
+/// セクタ検索用インデックスを無効にする
+/// セクタの並びが変わったことをディスクに伝える
+void DiskImageTrack::InvalidateSectorIndex()
+{
+	m_sector_index_valid = false;
+	if (parent) parent->IncreaseLayoutGeneration();
+}
+
+/// セクタ検索用インデックスを作成しておく
+void DiskImageTrack::PrepareSectorIndex()
+{
+	if (!m_sector_index_valid) {
+		RebuildSectorIndex();
+	}
 }
 
 /// 指定位置のセクタを返す
@@ -402,6 +529,20 @@ DiskImageSector *DiskImageTrack::GetSectorByIndex(int pos)
 	return sector;
 }
 
+/// トラック番号を設定
+void DiskImageTrack::SetTrackNumber(int val)
+{
+	m_trk_num = val;
+	if (parent) parent->InvalidateTrackIndex();
+}
+
+/// サイド番号を設定
+void DiskImageTrack::SetSideNumber(int val)
+{
+	m_sid_num = val;
+	if (parent) parent->InvalidateTrackIndex();
+}
+
 /// トラック内のもっともらしいID Cを返す
 wxUint8	DiskImageTrack::GetMajorIDC() const
 {
@@ -588,15 +729,17 @@ int DiskImageTrack::GetMaxSectorSize() const
 }
 
 /// 変更されているか
+/// 書き込みがあったセクタのみ調べる
 bool DiskImageTrack::IsModified() const
 {
 	if (!sectors) return false;
 	if (m_orig_sectors != sectors->Count()) return true;
+	if (m_dirty_sectors == 0) return false;
 
 	bool modified = false;
 	for(size_t sector_num = 0; sector_num < sectors->Count() && !modified; sector_num++) {
 		DiskImageSector *sector = sectors->Item(sector_num);
-		if (!sector) continue;
+		if (!sector || !sector->IsDirty()) continue;
 
 		modified = sector->IsModified();
 		if (modified) {
@@ -607,16 +750,42 @@ bool DiskImageTrack::IsModified() const
 }
 
 /// 変更済みをクリア
+/// 書き込み用のバッファを渡したセクタは書き込みありのまま残る
 void DiskImageTrack::ClearModify()
 {
 	if (!sectors) return;
+	int dirty_sectors = 0;
 	for(size_t sector_num = 0; sector_num < sectors->Count(); sector_num++) {
 		DiskImageSector *sector = sectors->Item(sector_num);
 		if (!sector) continue;
 
 		sector->ClearModify();
+		if (sector->IsDirty()) dirty_sectors++;
 	}
 	m_orig_sectors = sectors->Count();
+	// セクタの削除分が残っていたらここでディスクに伝える
+	if (m_dirty_sectors > 0 && dirty_sectors == 0 && parent) {
+		parent->DecreaseDirtyTracks();
+	}
+	m_dirty_sectors = dirty_sectors;
+}
+
+/// 書き込みがあったセクタを数える
+/// 最初の1つでディスクに伝える
+void DiskImageTrack::IncreaseDirtySectors()
+{
+	if (m_dirty_sectors++ == 0 && parent) {
+		parent->IncreaseDirtyTracks();
+	}
+}
+
+/// 書き込みがなくなったセクタを減らす
+/// 最後の1つでディスクに伝える
+void DiskImageTrack::DecreaseDirtySectors()
+{
+	if (m_dirty_sectors > 0 && --m_dirty_sectors == 0 && parent) {
+		parent->DecreaseDirtyTracks();
+	}
 }
 
 /// トラック番号とサイド番号の比較
@@ -657,6 +826,97 @@ bool DiskImageTrack::CalcSectorNumbersForInterleave(int interleave, size_t secto
 	return !err;
 }
 
+// ----------------------------------------------------------------------
+//
+//
+//
+/// 領域を確保する
+/// @param[in] size 領域のサイズ
+/// @param[in] next 以前に確保した領域
+DiskImageArena::DiskImageArena(size_t size, DiskImageArena *next)
+{
+	m_buffer = new wxUint8[size];
+	memset(m_buffer, 0, size);
+	m_size = size;
+	m_used = 0;
+	m_owned = true;
+	m_next = next;
+}
+
+/// マッピングした領域を指す
+/// @param[in] mapped_buffer マッピングした領域
+/// @param[in] size          領域のサイズ
+/// @param[in] next          以前に確保した領域
+/// @note 切り出しはできない
+DiskImageArena::DiskImageArena(wxUint8 *mapped_buffer, size_t size, DiskImageArena *next)
+{
+	m_buffer = mapped_buffer;
+	m_size = size;
+	m_used = size;
+	m_owned = false;
+	m_next = next;
+}
+
+/// 以前に確保した領域もまとめて解放する
+DiskImageArena::~DiskImageArena()
+{
+	DiskImageArena *next = m_next;
+	while(next) {
+		DiskImageArena *p = next;
+		next = p->m_next;
+		p->m_next = NULL;
+		delete p;
+	}
+	if (m_owned) {
+		delete [] m_buffer;
+	}
+}
+
+/// 領域からバッファを切り出す
+/// @param[in] size サイズ
+/// @return バッファ 空きがない場合NULL
+wxUint8 *DiskImageArena::Alloc(size_t size)
+{
+	if (size > m_size - m_used) return NULL;
+	wxUint8 *p = &m_buffer[m_used];
+	m_used += size;
+	return p;
+}
+
+/// マッピングした領域を複製して自分の領域にする
+/// @param[in] map マッピングしたファイル
+void DiskImageArena::Own(const DiskMapFile *map)
+{
+	if (m_owned) return;
+	wxUint8 *p = new wxUint8[m_size];
+	if (map) {
+		// ファイルが変わっていたら読み直す
+		map->Read(m_buffer, p, m_size);
+	} else {
+		memcpy(p, m_buffer, m_size);
+	}
+	m_buffer = p;
+	m_owned = true;
+}
+
+/// マッピングした領域内のバッファか
+bool DiskImageArena::IsMapped(const wxUint8 *ptr) const
+{
+	for(const DiskImageArena *p = this; p; p = p->m_next) {
+		if (!p->m_owned && p->m_buffer <= ptr && ptr < p->m_buffer + p->m_size) return true;
+	}
+	return false;
+}
+
+/// 領域内のバッファか
+bool DiskImageArena::Contains(const wxUint8 *ptr) const
+{
+	for(const DiskImageArena *p = this; p; p = p->m_next) {
+		if (p->m_buffer <= ptr && ptr < p->m_buffer + p->m_size) return true;
+	}
+	return false;
+}
+
 // ----------------------------------------------------------------------
 //
 //
@@ -672,11 +932,20 @@ DiskImageDisk::DiskImageDisk(DiskImageFile *file, int n_num)
 	m_write_protect = false;
 
 	tracks = NULL;
+	m_arena = NULL;
 	m_offset_start = 0;
 
 	p_temp_param = NULL;
 	m_param_changed = false;
 
+	m_dirty_tracks = 0;
+	m_dirty = false;
+	m_file_pos = -1;
+
+	m_track_index_valid = false;
+	m_layout_gen = 0;
+	m_data_gen = 0;
+
 	basics = new DiskBasics;
 }
 
@@ -694,11 +963,20 @@ DiskImageDisk::DiskImageDisk(DiskImageFile *file, int n_num, const DiskParam &n_
 	m_write_protect = n_write_protect;
 
 	tracks = NULL;
+	m_arena = NULL;
 	m_offset_start = 0;
 
 	p_temp_param = NULL;
 	m_param_changed = false;
 
+	m_dirty_tracks = 0;
+	m_dirty = false;
+	m_file_pos = -1;
+
+	m_track_index_valid = false;
+	m_layout_gen = 0;
+	m_data_gen = 0;
+
 	basics = new DiskBasics;
 }
 
@@ -714,11 +992,20 @@ DiskImageDisk::DiskImageDisk(DiskImageFile *file, int n_num, const DiskImageDisk
 	m_write_protect = n_header.IsWriteProtected();
 
 	tracks = NULL;
+	m_arena = NULL;
 	m_offset_start = 0;
 
 	p_temp_param = NULL;
 	m_param_changed = false;
 
+	m_dirty_tracks = 0;
+	m_dirty = false;
+	m_file_pos = -1;
+
+	m_track_index_valid = false;
+	m_layout_gen = 0;
+	m_data_gen = 0;
+
 	basics = new DiskBasics;
 }
 
@@ -731,6 +1018,8 @@ DiskImageDisk::~DiskImageDisk()
 		}
 		delete tracks;
 	}
+	// セクタを削除した後で解放する
+	delete m_arena;
 	delete basics;
 }
 
@@ -742,6 +1031,10 @@ size_t DiskImageDisk::Add(DiskImageTrack *newtrk)
 //	return tracks->Add(new DiskImageTrack(newtrk));
 	if (!tracks) tracks = new DiskImageTracks;
 	tracks->Add(newtrk);
+	if (m_track_index_valid) {
+		AddTrackIndex(newtrk, (int)tracks->Count() - 1);
+	}
+	m_layout_gen++;
 //	SetMaxTrackNumber(newtrk->GetTrackNumber());
 	return tracks->Count();
 }
@@ -897,6 +1190,7 @@ void DiskImageDisk::DeleteTracks(int start_offset_pos, int end_offset_pos, int s
 
 //		wxUint32 track_size = track->GetSize();
 		tracks->Remove(track);
+		InvalidateTrackIndex();
 		SetOffset(pos, 0);
 		delete track;
 
@@ -981,19 +1275,90 @@ size_t DiskImageDisk::CalcSizeWithoutHeader()
 	return new_size;
 }
 
+/// セクタデータの領域をまとめて確保
+/// @param[in] size 確保するサイズ（通常はディスクサイズ）
+void DiskImageDisk::ReserveSectorBuffers(int size)
+{
+	if (size <= 0) return;
+	if (m_arena && m_arena->GetFreeSize() >= (size_t)size) return;
+	m_arena = new DiskImageArena(size, m_arena);
+}
+
+/// セクタデータのバッファを領域から確保
+/// @param[in] size セクタサイズ
+/// @return バッファ（0クリア済み） ディスク削除時にまとめて解放される
+wxUint8 *DiskImageDisk::AllocSectorBuffer(size_t size)
+{
+	if (size == 0) return NULL;
+	wxUint8 *p = m_arena ? m_arena->Alloc(size) : NULL;
+	if (!p) {
+		// 足りなければ領域を追加
+		m_arena = new DiskImageArena(size > DISK_ARENA_MIN_SIZE ? size : DISK_ARENA_MIN_SIZE, m_arena);
+		p = m_arena->Alloc(size);
+	}
+	return p;
+}
+
+/// 領域から確保したバッファか
+bool DiskImageDisk::IsSectorBufferInArena(const wxUint8 *ptr) const
+{
+	return (ptr && m_arena && m_arena->Contains(ptr));
+}
+
+/// マッピングしたファイルの領域にあるバッファか
+bool DiskImageDisk::IsSectorBufferMapped(const wxUint8 *ptr) const
+{
+	return (ptr && m_arena && m_arena->IsMapped(ptr));
+}
+
+/// マッピングしたファイルの領域をセクタデータの領域として使う
+/// @param[in] buffer このディスクの先頭位置
+/// @param[in] size   ディスクサイズ
+void DiskImageDisk::AttachMappedBuffer(wxUint8 *buffer, size_t size)
+{
+	if (!buffer || size == 0) return;
+	m_arena = new DiskImageArena(buffer, size, m_arena);
+}
+
+/// マッピングしたファイルの領域にあるセクタデータを複製して切り離す
+/// @param[in] map マッピングしたファイル
+/// @note マッピングを解除する前に呼ぶこと
+void DiskImageDisk::DetachMappedBuffer(const DiskMapFile *map)
+{
+	for(DiskImageArena *arena = m_arena; arena; arena = arena->GetNext()) {
+		if (arena->IsOwned()) continue;
+
+		const wxUint8 *old_base = arena->GetBuffer();
+		arena->Own(map);
+		if (!tracks) continue;
+		for(size_t i=0; i<tracks->Count(); i++) {
+			DiskImageSectors *sectors = tracks->Item(i)->GetSectors();
+			if (!sectors) continue;
+			for(size_t j=0; j<sectors->Count(); j++) {
+				sectors->Item(j)->RelocateSharedData(old_base, arena->GetSize(), arena->GetBuffer());
+			}
+		}
+	}
+}
+
 /// 変更済みに設定
+/// 書き込みがあったことをファイルに伝える
 void DiskImageDisk::SetModify()
 {
+	if (m_dirty) return;
+	m_dirty = true;
+	if (parent) parent->IncreaseDirtyDisks();
 }
 
 /// 変更されているか
+/// 書き込みがあったトラックのみ調べる
 bool DiskImageDisk::IsModified()
 {
 	bool modified = false;
-	if (tracks) {
+	if (tracks && m_dirty_tracks > 0) {
 		for(size_t track_num = 0; track_num < tracks->Count() && !modified; track_num++) {
 			DiskImageTrack *track = tracks->Item(track_num);
-			if (!track) continue;
+			if (!track || !track->IsDirty()) continue;
 
 			modified = track->IsModified();
 			if (modified) {
@@ -1005,16 +1370,46 @@ bool DiskImageDisk::IsModified()
 }
 
 /// 変更済みをクリア
+/// 書き込みがなくなったらファイルに伝える
 void DiskImageDisk::ClearModify()
 {
+	int dirty_tracks = 0;
 	if (tracks) {
 		for(size_t track_num = 0; track_num < tracks->Count(); track_num++) {
 			DiskImageTrack *track = tracks->Item(track_num);
 			if (!track) continue;
 
 			track->ClearModify();
+			if (track->IsDirty()) dirty_tracks++;
 		}
 	}
+	m_dirty_tracks = dirty_tracks;
+	if (m_dirty && dirty_tracks == 0) {
+		m_dirty = false;
+		if (parent) parent->DecreaseDirtyDisks();
+	}
+}
+
+/// 全セクタのCRCを検査
+/// @param [out] errors エラーのあったセクタ
+/// @return エラーのあったセクタ数
+size_t DiskImageDisk::VerifyCRC(DiskCRCErrors &errors)
+{
+	return DiskCRCVerifier::VerifyDisk(this, errors);
+}
+
+/// 書き込みがあったトラックを数える
+void DiskImageDisk::IncreaseDirtyTracks()
+{
+	m_dirty_tracks++;
+	DiskImageDisk::SetModify();
+}
+
+/// 書き込みがなくなったトラックを減らす
+/// ディスク自体の変更は残すので書き込みありのままにする
+void DiskImageDisk::DecreaseDirtyTracks()
+{
+	if (m_dirty_tracks > 0) m_dirty_tracks--;
 }
 
 /// 指定トラックを返す
@@ -1023,17 +1418,77 @@ void DiskImageDisk::ClearModify()
 /// @return トラック
 DiskImageTrack *DiskImageDisk::GetTrack(int track_number, int side_number)
 {
-	DiskImageTrack *track = NULL;
+	if (!tracks) return NULL;
+
+	if (!m_track_index_valid) {
+		RebuildTrackIndex();
+	}
+	IntHashMap::iterator it = m_track_index.find(TrackIndexKey(track_number, side_number));
+	if (it == m_track_index.end()) {
+		return NULL;
+	}
+	DiskImageTrack *track = tracks->Item(it->second);
+	if (track->GetTrackNumber() == track_number && track->GetSideNumber() == side_number) {
+		return track;
+	}
+
+	// キーが衝突している場合は順に探す
+	track = NULL;
+	for(size_t pos=0; pos<tracks->Count(); pos++) {
+		DiskImageTrack *t = tracks->Item(pos);
+		if (t->GetTrackNumber() == track_number && t->GetSideNumber() == side_number) {
+			track = t;
+			break;
+		}
+	}
+	return track;
+}
+
+/// トラック検索用インデックスのキーを返す
+/// @param[in] track_number トラック番号（シリンダ）
+/// @param[in] side_number  サイド番号（ヘッド）
+int DiskImageDisk::TrackIndexKey(int track_number, int side_number)
+{
+	return track_number * 256 + (side_number & 0xff);
+}
+
+/// トラック検索用インデックスに追加する
+/// @note 同じキーがある場合は先にあるトラックを優先する
+/// @param[in] track トラック
+/// @param[in] pos   トラックリスト内の位置
+void DiskImageDisk::AddTrackIndex(DiskImageTrack *track, int pos)
+{
+	int key = TrackIndexKey(track->GetTrackNumber(), track->GetSideNumber());
+	if (m_track_index.find(key) == m_track_index.end()) {
+		m_track_index[key] = pos;
+	}
+}
+
+/// トラック検索用インデックスを作り直す
+void DiskImageDisk::RebuildTrackIndex()
+{
+	m_track_index.clear();
 	if (tracks) {
 		for(size_t pos=0; pos<tracks->Count(); pos++) {
-			DiskImageTrack *t = tracks->Item(pos);
-			if (t->GetTrackNumber() == track_number && t->GetSideNumber() == side_number) {
-				track = t;
-				break;
-			}
+			AddTrackIndex(tracks->Item(pos), (int)pos);
+		}
+	}
+	m_track_index_valid = true;
+}
+
+/// 検索用インデックスを作成しておく
+/// GetTrack()やGetSector()がインデックスを作り直さないので複数スレッドから参照できる
+void DiskImageDisk::PrepareIndexes()
+{
+	if (!m_track_index_valid) {
+		RebuildTrackIndex();
+	}
+	if (tracks) {
+		for(size_t pos=0; pos<tracks->Count(); pos++) {
+			DiskImageTrack *track = tracks->Item(pos);
+			if (track) track->PrepareSectorIndex();
 		}
 	}
-	return track;
 }
 
 /// 指定トラックを返す
@@ -1350,6 +1805,7 @@ bool DiskImageDisk::Rebuild(const DiskParam &param, int selected_side)
 		if (tracks && track) {
 			// トラック削除
 			tracks->Remove(track);
+			InvalidateTrackIndex();
 			delete track;
 		}
 		if (offset == 0) {
@@ -1449,6 +1905,8 @@ DiskImageFile::DiskImageFile()
 	p_image = NULL;
 	disks = NULL;
 	mods  = NULL;
+	m_dirty_disks = 0;
+	p_map = NULL;
 }
 
 DiskImageFile::DiskImageFile(const DiskImageFile &src)
@@ -1461,6 +1919,8 @@ DiskImageFile::DiskImageFile(DiskImage &image)
 	p_image = &image;
 	disks = NULL;
 	mods  = NULL;
+	m_dirty_disks = 0;
+	p_map = NULL;
 }
 
 DiskImageFile::~DiskImageFile()
@@ -1475,6 +1935,9 @@ size_t DiskImageFile::Add(DiskImageDisk *newdsk, short mod_flags)
 	if (!mods)  mods  = new wxArrayShort;
 	disks->Add(newdsk);
 	mods->Add(mod_flags);
+	if (mod_flags != MODIFY_NONE || newdsk->IsDirty()) {
+		m_dirty_disks++;
+	}
 	return disks->Count();
 }
 
@@ -1492,6 +1955,72 @@ void DiskImageFile::Clear()
 	if (mods) {
 		delete mods;
 	}
+	m_dirty_disks = 0;
+	m_pos_path.Empty();
+	// ディスクを削除した後で解除する
+	delete p_map;
+	p_map = NULL;
+}
+
+/// ファイルをメモリにマッピングする
+/// @param[in] filepath ファイルパス
+/// @return false マッピングできない
+bool DiskImageFile::MapFile(const wxString &filepath)
+{
+	UnmapFile();
+	p_map = new DiskMapFile();
+	if (!p_map->Open(filepath)) {
+		delete p_map;
+		p_map = NULL;
+		return false;
+	}
+	return true;
+}
+
+/// マッピングを解除する
+/// セクタデータは複製してから解除する
+void DiskImageFile::UnmapFile()
+{
+	if (!p_map) return;
+	if (disks) {
+		for(size_t i=0; i<disks->Count(); i++) {
+			disks->Item(i)->DetachMappedBuffer(p_map);
+		}
+	}
+	delete p_map;
+	p_map = NULL;
+}
+
+/// マッピングしたファイルが変わっていたら切り離す
+/// 他のプロセスがファイルを切り詰めると領域へのアクセスで落ちるので
+/// ディスクを参照する前に確認する
+void DiskImageFile::ValidateMapFile()
+{
+	if (!p_map || p_map->IsIntact()) return;
+	// ファイルから読み直して切り離す
+	UnmapFile();
+	// ファイル上の配置も当てにならない
+	ClearFilePositions();
+}
+
+/// ファイル上の位置をクリア
+/// 保存し直すとファイル上の配置が変わるため
+void DiskImageFile::ClearFilePositions()
+{
+	m_pos_path.Empty();
+	if (!disks) return;
+	for(size_t i=0; i<disks->Count(); i++) {
+		disks->Item(i)->SetFilePosition(-1);
+	}
+}
+
+/// 指定したファイル上の位置を記録しているか
+/// 別名で保存した後は保存したファイルの位置になる
+/// @param[in] filepath ファイルパス
+bool DiskImageFile::HasFilePositionsOn(const wxString &filepath) const
+{
+	if (m_pos_path.IsEmpty()) return false;
+	return wxFileName(filepath).SameAs(wxFileName(m_pos_path));
 }
 
 /// ディスク数を返す
@@ -1520,16 +2049,18 @@ DiskImageDisk *DiskImageFile::GetDisk(size_t idx)
 	return disks->Item(idx);
 }
 
+/// 変更されているか
+/// 書き込みがあったディスクのみ調べる
 bool DiskImageFile::IsModified()
 {
 	bool modified = false;
-	if (disks) {
+	if (disks && m_dirty_disks > 0) {
 		for(size_t disk_num = 0; disk_num < disks->Count() && !modified; disk_num++) {
 			modified = (mods->Item(disk_num) != 0);
 			if (modified) break;
 
 			DiskImageDisk *disk = disks->Item(disk_num);
-			if (!disk) continue;
+			if (!disk || !disk->IsDirty()) continue;
 
 			modified = disk->IsModified();
 			if (modified) break;
@@ -1540,6 +2071,7 @@ bool DiskImageFile::IsModified()
 
 void DiskImageFile::ClearModify()
 {
+	int dirty_disks = 0;
 	if (disks) {
 		for(size_t disk_num = 0; disk_num < disks->Count(); disk_num++) {
 			mods->Item(disk_num) = MODIFY_NONE;
@@ -1548,8 +2080,10 @@ void DiskImageFile::ClearModify()
 			if (!disk) continue;
 
 			disk->ClearModify();
+			if (disk->IsDirty()) dirty_disks++;
 		}
 	}
+	m_dirty_disks = dirty_disks;
 }
 
 // ======================================================================
@@ -1657,7 +2191,18 @@ int DiskImage::Open(const wxString &filepath, const wxString &file_format, const
 	}
 
 	NewFile(filepath);
+	if (gConfig.DoesMapFileOnOpen() && file_format == wxT("d88")) {
+		// 失敗したときは通常通り読み込む
+		p_file->MapFile(filepath);
+	}
 	DiskParser ps(filepath, &fstream, p_file, m_result);
+	if (filepath == m_detect_path && file_format == m_detect_format) {
+		// 直前のチェックで自動判定した結果のみ覚える
+		ps.SetCacheKey(m_detect_key);
+	}
+	m_detect_path.Empty();
+	m_detect_format.Empty();
+	m_detect_key.Empty();
 	int valid_disk = ps.Parse(file_format, param_hint);
 
 	if (valid_disk < 0) {
@@ -1665,6 +2210,8 @@ int DiskImage::Open(const wxString &filepath, const wxString &file_format, const
 		ClearFile();
 	} else {
 		SetFormatType(file_format);
+		// 読み込んだ位置はこのファイル上のもの
+		p_file->SetFilePositionsPath(filepath);
 	}
 
 	return valid_disk;
@@ -1690,7 +2237,18 @@ int DiskImage::Check(const wxString &filepath, wxString &file_format, DiskParamP
 	}
 
 	DiskParser ps(filepath, &fstream, p_file, m_result);
-	return ps.Check(file_format, params, manual_param);
+	int rc = ps.Check(file_format, params, manual_param);
+
+	m_detect_path.Empty();
+	m_detect_format.Empty();
+	m_detect_key.Empty();
+	if (rc == 0 && params.Count() <= 1) {
+		// 候補を選択させる時は手動の指定とみなして覚えない
+		m_detect_path = filepath;
+		m_detect_format = file_format;
+		m_detect_key = ps.GetCacheKey();
+	}
+	return rc;
 }
 
 /// 閉じる
@@ -1715,8 +2273,30 @@ int DiskImage::CanSave(const wxString &file_format)
 /// @retval -1:エラー
 int DiskImage::Save(const wxString &filepath, const wxString &file_format, const DiskWriteOptions &options)
 {
+	if (p_file) p_file->ValidateMapFile();
+	if (p_file && p_file->HasFilePositionsOn(filepath)) {
+		// 配置が変わっていなければ変更部分だけ書き換える
+		bool support = false;
+		DiskWriter dw(this, options, &m_result);
+		int rc = dw.Overwrite(filepath, file_format, support);
+		if (support) {
+			// 自分で書き換えたのでマッピングしたファイルが変わったとみなさない
+			DiskMapFile *map = p_file->GetMapFile();
+			if (rc >= 0 && map && map->IsSameFile(filepath)) {
+				map->Refresh();
+			}
+			return rc;
+		}
+	}
+	ReleaseMapFile(filepath);
+	// ファイル全体を保存し直すので位置は保存先のものになる
+	if (p_file) p_file->ClearFilePositions();
 	DiskWriter dw(this, filepath, options, &m_result);
-	return dw.Save(file_format);
+	int rc = dw.Save(file_format);
+	if (p_file && rc >= 0) {
+		p_file->SetFilePositionsPath(filepath);
+	}
+	return rc;
 }
 /// ストリームの内容をファイルに保存
 /// @param[in] disk_number ディスク番号
@@ -1728,10 +2308,28 @@ int DiskImage::Save(const wxString &filepath, const wxString &file_format, const
 /// @retval -1:エラー
 int DiskImage::SaveDisk(int disk_number, int side_number, const wxString &filepath, const wxString &file_format, const DiskWriteOptions &options)
 {
+	if (p_file) p_file->ValidateMapFile();
+	ReleaseMapFile(filepath);
 	DiskWriter dw(this, filepath, options, &m_result);
 	return dw.SaveDisk(disk_number, side_number, file_format);
 }
 
+/// 保存先がマッピングしたファイルならマッピングを解除する
+/// また、保存先の位置を記録していたらクリアする
+/// @param[in] filepath 保存先ファイルパス
+void DiskImage::ReleaseMapFile(const wxString &filepath)
+{
+	if (!p_file) return;
+	DiskMapFile *map = p_file->GetMapFile();
+	if (map && map->IsSameFile(filepath)) {
+		p_file->UnmapFile();
+	}
+	// 保存先を作り直すので位置は無効になる
+	if (p_file->HasFilePositionsOn(filepath)) {
+		p_file->ClearFilePositions();
+	}
+}
+
 /// ディスクを削除
 /// @param[in] disk_number ディスク番号
 /// @return true
@@ -1851,6 +2449,14 @@ bool DiskImage::IsModified()
 	}
 	return modified;
 }
+/// 全セクタのCRCを検査
+/// @param [in]  disk_number ディスク番号 / -1なら全ディスク
+/// @param [out] errors      エラーのあったセクタ
+/// @return エラーのあったセクタ数
+size_t DiskImage::VerifyCRC(int disk_number, DiskCRCErrors &errors)
+{
+	return DiskCRCVerifier::VerifyFile(p_file, disk_number, errors);
+}
 /// ディスク枚数
 size_t DiskImage::CountDisks() const
 {
@@ -1863,10 +2469,20 @@ DiskImageDisks *DiskImage::GetDisks()
 	if (!p_file) return NULL;
 	return p_file->GetDisks();
 }
+/// マッピングしたファイルが変わっていたら切り離す
+/// @note 取得済みのディスクのセクタを参照し続ける画面から、
+/// 他のプロセスがファイルを変えうるタイミングで呼ぶ
+void DiskImage::ValidateMapFile()
+{
+	if (!p_file) return;
+	p_file->ValidateMapFile();
+}
 /// 指定した位置のディスクを返す
 DiskImageDisk *DiskImage::GetDisk(size_t index)
 {
 	if (!p_file) return NULL;
+	// マッピングしたファイルが変わっていないか
+	p_file->ValidateMapFile();
 	return p_file->GetDisk(index);
 }
 /// 指定した位置のディスクを返す
@@ -24,6 +24,8 @@ class DiskWriteOptions;
 class DiskImageDisk;
 class DiskImageFile;
 class DiskImage;
+class DiskMapFile;
+class DiskCRCErrors;
 
 // ----------------------------------------------------------------------
 
@@ -53,16 +55,27 @@ public:
 
 // ----------------------------------------------------------------------
 
+class DiskImageTrack;
+
 /// セクタデータへのポインタを保持するクラス
 class DiskImageSector
 {
 protected:
+	DiskImageTrack *parent;	///< 所属するトラック
 	int m_num;		///< sector number(ID Rと同じ)
+	bool m_dirty;	///< 書き込みがあったか
+	wxFileOffset m_file_pos;	///< 読み込み/保存時のファイル上の位置(不明なら-1)
+	wxUint32 m_write_gen;	///< データを書き換えた回数
 
-	DiskImageSector() {}
-	DiskImageSector(const DiskImageSector &src) {}
+	DiskImageSector() { parent = NULL; m_dirty = false; m_file_pos = -1; m_write_gen = 0; }
+	DiskImageSector(const DiskImageSector &src) { parent = NULL; m_dirty = false; m_file_pos = -1; m_write_gen = 0; }
 	DiskImageSector &operator=(const DiskImageSector &src) { return *this; }
 
+	/// トラックのセクタ検索用インデックスを無効にする
+	void	InvalidateParentIndex();
+	/// データを書き換えたことを記録
+	void	IncreaseWriteGeneration();
+
 public:
 	DiskImageSector(int n_num);
 	virtual ~DiskImageSector();
@@ -106,6 +119,12 @@ public:
 	virtual wxUint8 *GetSectorBuffer() = 0;
 	/// セクタデータへのポインタを返す
 	virtual wxUint8 *GetSectorBuffer(int offset) { return NULL; }
+	/// 読み込み専用でセクタデータへのポインタを返す
+	virtual const wxUint8 *PeekSectorBuffer() const { return NULL; }
+	/// 読み込み専用でセクタデータへのポインタを返す
+	virtual const wxUint8 *PeekSectorBuffer(int offset) const { return NULL; }
+	/// イメージ解析時にセクタデータへのポインタを返す(書き込みとはみなさない)
+	virtual wxUint8 *GetSectorBufferForParse() { return NULL; }
 	/// セクタ数を返す
 	virtual wxUint16 GetSectorsPerTrack() const { return 0; }
 	/// セクタ数を設定
@@ -114,6 +133,13 @@ public:
 	virtual wxUint8 GetSectorStatus() const { return 0; }
 	/// セクタのステータスを設定
 	virtual void    SetSectorStatus(wxUint8 val) {}
+	/// ディスクの領域が移動したのでセクタデータの位置を移す
+	virtual void	RelocateSharedData(const wxUint8 *old_base, size_t size, wxUint8 *new_base) {}
+
+	/// 所属するトラックを返す
+	DiskImageTrack *GetTrack() const { return parent; }
+	/// 所属するトラックを設定
+	void	SetTrack(DiskImageTrack *val) { parent = val; }
 
 	/// ヘッダを返す
 	virtual DiskImageSectorHeader *GetHeader() { return NULL; }
@@ -148,9 +174,18 @@ public:
 	/// 変更されているか
 	virtual bool	IsModified() const { return false; }
 	/// 変更済みを設定
-	virtual void	SetModify() {}
+	virtual void	SetModify();
 	/// 変更済みをクリア
-	virtual void	ClearModify() {}
+	virtual void	ClearModify();
+	/// 書き込みがあったか
+	bool	IsDirty() const { return m_dirty; }
+	/// データを書き換えた回数
+	/// @note セクタバッファの内容を展開して保持している側が、古くなったかの判定に使う
+	wxUint32 GetWriteGeneration() const { return m_write_gen; }
+	/// ファイル上の位置を返す
+	wxFileOffset GetFilePosition() const { return m_file_pos; }
+	/// ファイル上の位置を設定
+	void	SetFilePosition(wxFileOffset val) { m_file_pos = val; }
 
 	/// セクタ内容の比較
 	static int		Compare(DiskImageSector *item1, DiskImageSector *item2);
@@ -183,10 +218,21 @@ protected:
 	DiskImageSectors *sectors;
 
 	size_t m_orig_sectors;	///< num of sectors (original / pre save)
+	int m_dirty_sectors;	///< 書き込みがあったセクタ数
 
 	wxUint8 *extra_data;	///< extra data
 	size_t extra_size;		///< extra data size
 
+	IntHashMap m_sector_index;	///< セクタ番号と密度からセクタ位置を引くインデックス
+	bool m_sector_index_valid;	///< インデックスが有効か
+
+	/// セクタ検索用インデックスを作り直す
+	void	RebuildSectorIndex();
+	/// セクタ検索用インデックスに追加する
+	void	AddSectorIndex(DiskImageSector *sector, int pos);
+	/// セクタ検索用インデックスのキーを返す
+	static int SectorIndexKey(int sector_number, int density);
+
 	DiskImageTrack() {}
 	DiskImageTrack(const DiskImageTrack &src) {}
 	DiskImageTrack &operator=(const DiskImageTrack &src) { return *this; }
@@ -223,11 +269,11 @@ public:
 	/// トラック番号を返す
 	virtual int		GetTrackNumber() const { return m_trk_num; }
 	/// トラック番号を設定
-	virtual void	SetTrackNumber(int val) { m_trk_num = val; }
+	virtual void	SetTrackNumber(int val);
 	/// サイド番号を返す
 	virtual int		GetSideNumber() const { return m_sid_num; }
 	/// サイド番号を設定
-	virtual void	SetSideNumber(int val) { m_sid_num = val; }
+	virtual void	SetSideNumber(int val);
 
 	/// オフセットを返す
 	virtual int		GetOffsetPos() const { return m_offset_pos; }
@@ -256,6 +302,10 @@ public:
 	virtual DiskImageSector  *GetSector(int sector_number, int density = -1);
 	/// 指定位置のセクタを返す
 	virtual DiskImageSector  *GetSectorByIndex(int pos);
+	/// セクタ検索用インデックスを無効にする
+	void	InvalidateSectorIndex();
+	/// セクタ検索用インデックスを作成しておく
+	void	PrepareSectorIndex();
 
 	/// トラック内のもっともらしいID Cを返す
 	virtual wxUint8	GetMajorIDC() const;
@@ -288,6 +338,12 @@ public:
 	virtual bool	IsModified() const;
 	/// 変更済みをクリア
 	virtual void	ClearModify();
+	/// 書き込みがあったセクタを数える
+	void	IncreaseDirtySectors();
+	/// 書き込みがなくなったセクタを減らす
+	void	DecreaseDirtySectors();
+	/// 書き込みがあったか
+	bool	IsDirty() const { return m_dirty_sectors > 0; }
 
 	/// ディスクを返す
 	virtual DiskImageDisk *GetDisk() const { return parent; }
@@ -319,6 +375,51 @@ public:
 
 // ----------------------------------------------------------------------
 
+/// セクタデータを連続して確保するメモリ領域
+///
+/// ディスク単位で確保し、ディスクを削除するときにまとめて解放する
+/// マッピングしたファイルの領域を指す場合もある
+class DiskImageArena
+{
+private:
+	wxUint8 *m_buffer;		///< 領域
+	size_t m_size;			///< 領域のサイズ
+	size_t m_used;			///< 使用済みサイズ
+	bool m_owned;			///< 領域を自分で確保したか(falseならマッピングした領域)
+	DiskImageArena *m_next;	///< 以前に確保した領域
+
+	DiskImageArena() {}
+	DiskImageArena(const DiskImageArena &src) {}
+	DiskImageArena &operator=(const DiskImageArena &src) { return *this; }
+
+public:
+	DiskImageArena(size_t size, DiskImageArena *next);
+	DiskImageArena(wxUint8 *mapped_buffer, size_t size, DiskImageArena *next);
+	~DiskImageArena();
+
+	/// 領域からバッファを切り出す
+	wxUint8 *Alloc(size_t size);
+	/// 残りのサイズを返す
+	size_t	GetFreeSize() const { return m_size - m_used; }
+	/// 領域内のバッファか
+	bool	Contains(const wxUint8 *ptr) const;
+	/// マッピングした領域を複製して自分の領域にする
+	void	Own(const DiskMapFile *map);
+	/// マッピングした領域内のバッファか
+	bool	IsMapped(const wxUint8 *ptr) const;
+
+	/// 領域を返す
+	wxUint8 *GetBuffer() const { return m_buffer; }
+	/// 領域のサイズを返す
+	size_t	GetSize() const { return m_size; }
+	/// 領域を自分で確保したか
+	bool	IsOwned() const { return m_owned; }
+	/// 以前に確保した領域を返す
+	DiskImageArena *GetNext() const { return m_next; }
+};
+
+// ----------------------------------------------------------------------
+
 /// １ディスクへのポインタを保持するクラス
 class DiskImageDisk : public DiskParam
 {
@@ -333,6 +434,24 @@ protected:
 	DiskImageTracks *tracks;
 	int m_max_track_number;
 
+	DiskImageArena *m_arena;	///< セクタデータの領域
+
+	int m_dirty_tracks;			///< 書き込みがあったトラック数
+	bool m_dirty;				///< 書き込みがあったか
+	wxFileOffset m_file_pos;	///< 読み込み/保存時のファイル上の位置(不明なら-1)
+
+	IntHashMap m_track_index;	///< トラック番号とサイド番号からトラック位置を引くインデックス
+	bool m_track_index_valid;	///< インデックスが有効か
+	wxUint32 m_layout_gen;		///< トラックやセクタの並びを変更した回数
+	wxUint32 m_data_gen;		///< いずれかのセクタのデータを書き換えた回数
+
+	/// トラック検索用インデックスを作り直す
+	void	RebuildTrackIndex();
+	/// トラック検索用インデックスに追加する
+	void	AddTrackIndex(DiskImageTrack *track, int pos);
+	/// トラック検索用インデックスのキーを返す
+	static int TrackIndexKey(int track_number, int side_number);
+
 	const DiskParam *p_temp_param;	///< 解析でテンプレートがあった場合セット
 	DiskParam orig_param;		///< 解析したパラメータ
 	bool m_param_changed;		///< ディスクパラメータを変更したか
@@ -369,6 +488,19 @@ public:
 	/// ディスクサイズ計算（ディスクヘッダ分を除く）
 	virtual size_t	CalcSizeWithoutHeader();
 
+	/// セクタデータの領域をまとめて確保
+	void	ReserveSectorBuffers(int size);
+	/// セクタデータのバッファを領域から確保
+	wxUint8 *AllocSectorBuffer(size_t size);
+	/// 領域から確保したバッファか
+	bool	IsSectorBufferInArena(const wxUint8 *ptr) const;
+	/// マッピングしたファイルの領域にあるバッファか
+	bool	IsSectorBufferMapped(const wxUint8 *ptr) const;
+	/// マッピングしたファイルの領域をセクタデータの領域として使う
+	void	AttachMappedBuffer(wxUint8 *buffer, size_t size);
+	/// マッピングしたファイルの領域にあるセクタデータを複製して切り離す
+	void	DetachMappedBuffer(const DiskMapFile *map);
+
 	/// ディスク番号を返す
 	virtual int		GetNumber() const { return m_num; }
 	/// ディスク名を返す
@@ -390,6 +522,10 @@ public:
 	virtual DiskImageTrack  *GetTrack(int index);
 	/// 指定オフセット値からトラックを返す
 	virtual DiskImageTrack  *GetTrackByOffset(wxUint32 offset);
+	/// トラック検索用インデックスを無効にする
+	void	InvalidateTrackIndex() { m_track_index_valid = false; m_layout_gen++; }
+	/// 検索用インデックスを作成しておく 複数スレッドから参照する前に呼ぶ
+	void	PrepareIndexes();
 	/// 指定セクタを返す
 	virtual DiskImageSector *GetSector(int track_number, int side_number, int sector_number, int density = -1);
 	/// ディスクの中でもっともらしいパラメータを設定
@@ -447,6 +583,27 @@ public:
 	virtual bool	IsModified();
 	/// 変更済みをクリア
 	virtual void	ClearModify();
+	/// 全セクタのCRCを検査
+	virtual size_t	VerifyCRC(DiskCRCErrors &errors);
+	/// 書き込みがあったトラックを数える
+	void	IncreaseDirtyTracks();
+	/// 書き込みがなくなったトラックを減らす
+	void	DecreaseDirtyTracks();
+	/// トラックやセクタの並びを変更したことを記録
+	void	IncreaseLayoutGeneration() { m_layout_gen++; }
+	/// トラックやセクタの並びを変更した回数
+	/// @note 保持したトラックやセクタのポインタがまだ使えるかの判定に使う
+	wxUint32 GetLayoutGeneration() const { return m_layout_gen; }
+	/// セクタのデータを書き換えたことを記録
+	void	IncreaseDataGeneration() { m_data_gen++; }
+	/// いずれかのセクタのデータを書き換えた回数
+	wxUint32 GetDataGeneration() const { return m_data_gen; }
+	/// 書き込みがあったか
+	bool	IsDirty() const { return m_dirty; }
+	/// ファイル上の位置を返す
+	wxFileOffset GetFilePosition() const { return m_file_pos; }
+	/// ファイル上の位置を設定
+	void	SetFilePosition(wxFileOffset val) { m_file_pos = val; }
 
 	/// トラックが存在するか
 	virtual bool	ExistTrack(int side_number);
@@ -493,6 +650,9 @@ protected:
 	DiskImage *p_image;		///< イメージ
 	DiskImageDisks *disks;	///< ディスク
 	wxArrayShort *mods;		///< 変更フラグ 追加したかどうか
+	int m_dirty_disks;		///< 書き込みがあったディスク数
+	DiskMapFile *p_map;		///< メモリにマッピングしたファイル
+	wxString m_pos_path;	///< ファイル上の位置を記録したファイル
 
 	wxString m_basic_type_hint;	///< BASIC種類ヒント
 
@@ -532,6 +692,25 @@ public:
 
 	virtual bool IsModified();
 	virtual void ClearModify();
+	/// 書き込みがあったディスクを数える
+	void IncreaseDirtyDisks() { m_dirty_disks++; }
+	/// 書き込みがなくなったディスクを減らす
+	void DecreaseDirtyDisks() { if (m_dirty_disks > 0) m_dirty_disks--; }
+
+	/// ファイルをメモリにマッピングする
+	virtual bool MapFile(const wxString &filepath);
+	/// マッピングを解除する
+	virtual void UnmapFile();
+	/// マッピングしたファイルが変わっていたら切り離す
+	void ValidateMapFile();
+	/// マッピングしたファイルを返す
+	DiskMapFile *GetMapFile() const { return p_map; }
+	/// ファイル上の位置をクリア
+	void ClearFilePositions();
+	/// ファイル上の位置を記録したファイルを設定
+	void SetFilePositionsPath(const wxString &val) { m_pos_path = val; }
+	/// 指定したファイル上の位置を記録しているか
+	bool HasFilePositionsOn(const wxString &filepath) const;
 
 	virtual const wxString &GetBasicTypeHint() const { return m_basic_type_hint; }
 	virtual void SetBasicTypeHint(const wxString &val) { m_basic_type_hint = val; }
@@ -550,9 +729,15 @@ protected:
 	DiskImageFile *p_file;
 	DiskResult m_result;
 	wxString m_format_type;
+	wxString m_detect_path;	///< Check()で形式を自動判定したファイル
+	wxString m_detect_format;	///< 上記で決定した形式
+	wxString m_detect_key;	///< 上記の判定結果キャッシュのキー
 
 	virtual void NewFile(const wxString &filepath);
 	virtual void ClearFile();
+	/// 保存先がマッピングしたファイルならマッピングを解除する
+	/// また、保存先の位置を記録していたらクリアする
+	void ReleaseMapFile(const wxString &filepath);
 
 public:
 	DiskImage();
@@ -593,6 +778,8 @@ public:
 
 	/// ディスクを変更したか
 	virtual bool IsModified();
+	/// 全セクタのCRCを検査
+	virtual size_t VerifyCRC(int disk_number, DiskCRCErrors &errors);
 
 	/// ディスクファイルを返す
 	virtual DiskImageFile			*GetFile() { return p_file; }
@@ -602,6 +789,8 @@ public:
 	virtual size_t CountDisks() const;
 	/// ディスク一覧を返す
 	virtual DiskImageDisks *GetDisks();
+	/// マッピングしたファイルが変わっていたら切り離す
+	void ValidateMapFile();
 	/// 指定した位置のディスクを返す
 	virtual DiskImageDisk			*GetDisk(size_t index);
 	/// 指定した位置のディスクを返す
@@ -117,6 +117,8 @@ wxUint32 DiskImageCreator::CreateTrack(int track_number, int side_number, int of
 wxUint32 DiskImageCreator::CreateDisk(int disk_number, short mod_flags)
 {
 	DiskImageDisk *disk = p_file->NewImageDisk(disk_number, *p_param, m_diskname, m_write_protect);
+	// セクタデータの領域をまとめて確保
+	disk->ReserveSectorBuffers(p_param->CalcDiskSize());
 
 	// create tracks
 	size_t create_size = 0;
@@ -62,7 +62,7 @@ wxUint32 DiskIMDParser::ParseSector(wxInputStream &istream, int disk_number, int
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, false);
 	track->Add(sector);
 
-	wxUint8 *buffer = sector->GetSectorBuffer();
+	wxUint8 *buffer = sector->GetSectorBufferForParse();
 //	int buflen = sector->GetSectorBufferSize();
 
 	if (h_sector == 0) {
@@ -257,6 +257,15 @@ int DiskIMDParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskIMDParser::Probe(const DiskProbeData &data)
+{
+	return data.Match(0, "IMD 1.", 6) ? PROBE_SIGNATURE : PROBE_NO;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @retval 1 選択ダイアログ表示
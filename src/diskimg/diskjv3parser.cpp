@@ -63,7 +63,7 @@ wxUint32 DiskJV3Parser::ParseSector(wxInputStream &istream, int track_number, in
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, single_density);
 	track->Add(sector);
 
-	wxUint8 *buf = sector->GetSectorBuffer();
+	wxUint8 *buf = sector->GetSectorBufferForParse();
 	int siz = sector->GetSectorBufferSize();
 
 	size_t len = istream.Read(buf, siz).LastRead();
@@ -169,10 +169,11 @@ wxUint32 DiskJV3Parser::ParseDisk(wxInputStream &istream)
 
 /// ファイルを解析
 /// @param [in,out] istream    解析対象データ
+/// @param [in] disk_param     パラメータ通常不要
 /// @retval  0 正常
 /// @retval -1 エラーあり
 /// @retval  1 警告あり
-int DiskJV3Parser::Parse(wxInputStream &istream)
+int DiskJV3Parser::Parse(wxInputStream &istream, const DiskParam *disk_param)
 {
 	p_result->Clear();
 	istream.SeekI(0);
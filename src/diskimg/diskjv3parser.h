@@ -9,6 +9,7 @@
 #define DISKJV3_PARSER_H
 
 #include "../common.h"
+#include "diskparser.h"
 
 class wxInputStream;
 class wxArrayString;
@@ -22,13 +23,9 @@ class DiskResult;
 class FileParam;
 
 /// TRS-80 JV3ディスクパーサー
-class DiskJV3Parser
+class DiskJV3Parser : public DiskImageParser
 {
 private:
-	DiskImageFile	*p_file;
-	short			 m_mod_flags;
-	DiskResult		*p_result;
-
 	/// セクタデータの作成
 	wxUint32 ParseSector(wxInputStream &istream, int track_number, int side_number, int sector_number, int sector_size, int sector_nums, bool single_density, DiskImageTrack *track);
 	/// ディスクの解析
@@ -40,7 +37,7 @@ public:
 
 	/// チェック
 	int Check(wxInputStream &istream);
-	int Parse(wxInputStream &istream);
+	int Parse(wxInputStream &istream, const DiskParam *disk_param = NULL);
 };
 
 #endif /* DISKJV3_PARSER_H */
@@ -0,0 +1,207 @@
+﻿/// @file diskmapfile.cpp
+///
+/// @brief ディスクイメージファイルのメモリマッピング
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#include "diskmapfile.h"
+#include <wx/filename.h>
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifndef __WXMSW__
+#if defined(__APPLE__)
+#define DISK_MAP_FILE_MTIME_NSEC(st) ((long)(st).st_mtimespec.tv_nsec)
+#else
+#define DISK_MAP_FILE_MTIME_NSEC(st) ((long)(st).st_mtim.tv_nsec)
+#endif
+#endif
+
+
+DiskMapFile::DiskMapFile()
+{
+	m_buffer = NULL;
+	m_size = 0;
+	m_mtime = 0;
+#ifndef __WXMSW__
+	m_mtime_nsec = 0;
+	m_dev = 0;
+	m_ino = 0;
+	m_fd = -1;
+#endif
+}
+
+DiskMapFile::~DiskMapFile()
+{
+	Close();
+}
+
+/// ファイルをマッピングする
+/// @param[in] filepath ファイルパス
+/// @return false マッピングできない
+bool DiskMapFile::Open(const wxString &filepath)
+{
+	Close();
+
+	void *buffer = NULL;
+	size_t size = 0;
+	time_t mtime = 0;
+#ifndef __WXMSW__
+	long mtime_nsec = 0;
+	dev_t dev = 0;
+	ino_t ino = 0;
+#endif
+
+#ifdef __WXMSW__
+	HANDLE fh = ::CreateFileW(filepath.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fh == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fsize;
+	if (::GetFileSizeEx(fh, &fsize) && fsize.QuadPart > 0 && fsize.HighPart == 0) {
+		size = (size_t)fsize.QuadPart;
+		// ビューがある間は他のプロセスもファイルを切り詰められない
+		HANDLE mh = ::CreateFileMappingW(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mh) {
+			buffer = ::MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+			// ビューがある間はマッピングは有効
+			::CloseHandle(mh);
+		}
+	}
+	::CloseHandle(fh);
+#else
+	int fd = ::open(filepath.fn_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+		size = (size_t)st.st_size;
+		mtime = st.st_mtime;
+		mtime_nsec = DISK_MAP_FILE_MTIME_NSEC(st);
+		dev = st.st_dev;
+		ino = st.st_ino;
+		buffer = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (buffer == MAP_FAILED) {
+			buffer = NULL;
+		}
+	}
+	if (!buffer) {
+		::close(fd);
+	} else {
+		// ファイルが変わったことを確認するために開いたままにする
+		m_fd = fd;
+		m_mtime_nsec = mtime_nsec;
+		m_dev = dev;
+		m_ino = ino;
+	}
+#endif
+
+	if (!buffer) {
+		return false;
+	}
+	m_buffer = (wxUint8 *)buffer;
+	m_size = size;
+	m_mtime = mtime;
+	m_file_path = filepath;
+	return true;
+}
+
+/// マッピングを解除する
+/// @note 領域を指しているデータはすべて外しておくこと
+void DiskMapFile::Close()
+{
+	if (m_buffer) {
+#ifdef __WXMSW__
+		::UnmapViewOfFile(m_buffer);
+#else
+		::munmap(m_buffer, m_size);
+#endif
+	}
+#ifndef __WXMSW__
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+	m_fd = -1;
+	m_mtime_nsec = 0;
+	m_dev = 0;
+	m_ino = 0;
+#endif
+	m_buffer = NULL;
+	m_size = 0;
+	m_mtime = 0;
+	m_file_path.Empty();
+}
+
+/// マッピングしたファイルか
+/// @param[in] filepath ファイルパス
+bool DiskMapFile::IsSameFile(const wxString &filepath) const
+{
+	if (!m_buffer) return false;
+	return wxFileName(filepath).SameAs(wxFileName(m_file_path));
+}
+
+/// マッピングした時からファイルが変わっていないか
+/// @note Windowsではビューがある間はファイルを切り詰められないので確認しない
+bool DiskMapFile::IsIntact() const
+{
+	if (!m_buffer) return false;
+#ifdef __WXMSW__
+	return true;
+#else
+	struct stat st;
+	if (::fstat(m_fd, &st) != 0) return false;
+	if ((size_t)st.st_size != m_size || st.st_mtime != m_mtime || DISK_MAP_FILE_MTIME_NSEC(st) != m_mtime_nsec) return false;
+	// パスが別のファイルに置き換わっていないか
+	if (::stat(m_file_path.fn_str(), &st) != 0) return false;
+	return (st.st_dev == m_dev && st.st_ino == m_ino);
+#endif
+}
+
+/// 自分でファイルを書き換えた後にファイルの状態を取り直す
+/// @note 書き換えるのはマッピングした領域から切り離したセクタだけなので、
+/// 領域を指しているデータの内容は変わらない
+void DiskMapFile::Refresh()
+{
+	if (!m_buffer) return;
+#ifndef __WXMSW__
+	struct stat st;
+	if (::fstat(m_fd, &st) == 0 && (size_t)st.st_size == m_size) {
+		m_mtime = st.st_mtime;
+		m_mtime_nsec = DISK_MAP_FILE_MTIME_NSEC(st);
+	}
+#endif
+}
+
+/// 領域の内容を複製する
+/// ファイルが変わっていたら領域にはアクセスせずファイルから読み直す
+/// @param[in]  src 領域内の位置
+/// @param[out] dst 複製先
+/// @param[in]  len 長さ ファイルが短くなっていたら残りは0で埋める
+void DiskMapFile::Read(const wxUint8 *src, wxUint8 *dst, size_t len) const
+{
+	if (IsIntact()) {
+		memcpy(dst, src, len);
+		return;
+	}
+	size_t done = 0;
+#ifndef __WXMSW__
+	off_t offset = (off_t)(src - m_buffer);
+	while(done < len) {
+		ssize_t rlen = ::pread(m_fd, dst + done, len - done, offset + (off_t)done);
+		if (rlen <= 0) break;
+		done += (size_t)rlen;
+	}
+#endif
+	if (done < len) {
+		memset(dst + done, 0, len - done);
+	}
+}
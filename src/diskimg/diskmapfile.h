@@ -0,0 +1,70 @@
+﻿/// @file diskmapfile.h
+///
+/// @brief ディスクイメージファイルのメモリマッピング
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#ifndef _DISK_MAP_FILE_H_
+#define _DISK_MAP_FILE_H_
+
+#include "../common.h"
+#include <wx/string.h>
+#ifndef __WXMSW__
+#include <sys/types.h>
+#endif
+
+
+/// ディスクイメージファイルをメモリにマッピングするクラス
+///
+/// 領域は読み込み専用で、書き込むセクタは事前に複製する。
+/// マッピングはファイルの複製ではないので、他のプロセスがファイルを
+/// 切り詰めると領域へのアクセスで落ちる。アクセス前にIsIntact()で確認し、
+/// 変わっていたらRead()でファイルから読み直して切り離すこと。
+/// 更新日時は秒未満まで比べ、パスが別のファイルに置き換わったことも
+/// iノードで確認する。
+class DiskMapFile
+{
+private:
+	wxString m_file_path;	///< ファイルパス
+	wxUint8 *m_buffer;		///< マッピングした領域
+	size_t	 m_size;		///< 領域のサイズ
+	time_t	 m_mtime;		///< マッピング時のファイルの更新日時
+#ifndef __WXMSW__
+	long	 m_mtime_nsec;	///< 上記の秒未満(ナノ秒)
+	dev_t	 m_dev;			///< マッピングしたファイルのデバイス
+	ino_t	 m_ino;			///< マッピングしたファイルのiノード
+	int		 m_fd;			///< ファイルの確認と読み直し用
+#endif
+
+	DiskMapFile(const DiskMapFile &src) {}
+	DiskMapFile &operator=(const DiskMapFile &src) { return *this; }
+
+public:
+	DiskMapFile();
+	~DiskMapFile();
+
+	/// ファイルをマッピングする
+	bool	Open(const wxString &filepath);
+	/// マッピングを解除する
+	void	Close();
+	/// マッピングしているか
+	bool	IsOpened() const { return (m_buffer != NULL); }
+	/// マッピングしたファイルか
+	bool	IsSameFile(const wxString &filepath) const;
+	/// マッピングした時からファイルが変わっていないか
+	bool	IsIntact() const;
+	/// 自分でファイルを書き換えた後にファイルの状態を取り直す
+	void	Refresh();
+	/// 領域の内容を複製する ファイルが変わっていたらファイルから読み直す
+	void	Read(const wxUint8 *src, wxUint8 *dst, size_t len) const;
+
+	/// 領域を返す
+	wxUint8 *GetBuffer() const { return m_buffer; }
+	/// 領域のサイズを返す
+	size_t	GetSize() const { return m_size; }
+	/// ファイルパスを返す
+	const wxString &GetFilePath() const { return m_file_path; }
+};
+
+#endif /* _DISK_MAP_FILE_H_ */
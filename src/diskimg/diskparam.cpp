@@ -10,6 +10,7 @@
 #include <wx/translation.h>
 #include "../logging.h"
 #include "../utils.h"
+#include "../xmldoccache.h"
 
 
 /// (0:128bytes 1:256bytes 2:512bytes 3:1024bytes)
@@ -1069,7 +1070,7 @@ bool DiskTemplates::Load(const wxString &data_path, const wxString &locale_name,
 {
 	wxXmlDocument doc;
 
-	if (!doc.Load(data_path + wxT("disk_types.xml"))) return false;
+	if (!gXmlDocCache.LoadDocument(doc, data_path + wxT("disk_types.xml"))) return false;
 
 	// start processing the XML file
 	if (doc.GetRoot()->GetName() != "DiskTypes") return false;
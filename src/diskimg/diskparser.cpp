@@ -25,8 +25,56 @@
 #include "diskimage.h"
 #include "fileparam.h"
 #include "diskresult.h"
+#include "diskdetectcache.h"
 #include "../logging.h"
 
+/// パーサーを生成
+template<class T>
+static DiskImageParser *NewDiskImageParser(DiskImageFile *file, short mod_flags, DiskResult *result)
+{
+	return new T(file, mod_flags, result);
+}
+
+/// ディスクパーサーの登録情報
+///
+/// 拡張子に対応しないファイルの判定時はこの順で候補にする
+static const disk_parser_entry_t c_disk_parser_entries[] = {
+	// d88形式
+	{ wxT("d88"), 0, &NewDiskImageParser<DiskD88Parser>, &DiskD88Parser::Probe },
+	// CPC DSK形式
+	{ wxT("cpcdsk"), DISK_PARSER_FLAG_CHECK_ON_PARSE, &NewDiskImageParser<DiskDskParser>, &DiskDskParser::Probe },
+	// FDI形式
+	{ wxT("fdi"), DISK_PARSER_FLAG_CHECK_PARAMS, &NewDiskImageParser<DiskFDIParser>, &DiskFDIParser::Probe },
+	// CopyQM IMG形式
+	{ wxT("cqmimg"), DISK_PARSER_FLAG_CHECK_PARAMS, &NewDiskImageParser<DiskCQMParser>, &DiskCQMParser::Probe },
+	// Teledisk TD0形式
+	{ wxT("teletd0"), 0, &NewDiskImageParser<DiskTD0Parser>, &DiskTD0Parser::Probe },
+	// DIFC.X DIM形式
+	{ wxT("difcdim"), DISK_PARSER_FLAG_CHECK_PARAMS, &NewDiskImageParser<DiskDIMParser>, &DiskDIMParser::Probe },
+	// Virtual98 FDD形式
+	{ wxT("v98fdd"), 0, &NewDiskImageParser<DiskVFDParser>, &DiskVFDParser::Probe },
+	// IMageDisk IMD形式
+	{ wxT("imd"), 0, &NewDiskImageParser<DiskIMDParser>, &DiskIMDParser::Probe },
+	// DSKSTR 形式
+	{ wxT("dskstr"), 0, &NewDiskImageParser<DiskSTRParser>, &DiskSTRParser::Probe },
+	// Commodore VICE emu G64 形式
+	{ wxT("g64"), 0, &NewDiskImageParser<DiskG64Parser>, &DiskG64Parser::Probe },
+	// Apple 2MG 形式
+	{ wxT("2mg"), DISK_PARSER_FLAG_CHECK_PARAMS, &NewDiskImageParser<Disk2MGParser>, &Disk2MGParser::Probe },
+	// Apple Disk Copy 4 形式
+	{ wxT("adc"), DISK_PARSER_FLAG_CHECK_PARAMS, &NewDiskImageParser<DiskADCParser>, &DiskADCParser::Probe },
+	// TRS-80 DMK 形式
+	{ wxT("dmk"), DISK_PARSER_FLAG_CHECK_ON_PARSE, &NewDiskImageParser<DiskDmkParser>, &DiskDmkParser::Probe },
+	// TRS-80 JV3 形式
+	{ wxT("jv3"), 0, &NewDiskImageParser<DiskJV3Parser>, &DiskJV3Parser::Probe },
+	// HxC HFE 形式
+	{ wxT("hfe"), 0, &NewDiskImageParser<DiskHfeParser>, &DiskHfeParser::Probe },
+	// ベタ
+	{ wxT("plain"), DISK_PARSER_FLAG_CHECK_PARAMS, &NewDiskImageParser<DiskPlainParser>, &DiskPlainParser::Probe },
+	// 終端
+	{ NULL, 0, NULL, NULL }
+};
+
 
 /// コンストラクタ
 /// @param [in]     filepath    解析するファイルのパス 
@@ -85,6 +133,10 @@ int DiskParser::Parse(const wxString &file_format, const DiskParam &param_hint,
 		p_result->SetError(DiskResult::ERR_UNSUPPORTED);
 		return p_result->GetValid();
 	}
+	if (rc >= 0 && mod_flags == DiskImageFile::MODIFY_NONE) {
+		// 自動判定した結果なら覚えておく
+		gDiskDetectCache.SetImage(m_cache_key, file_format, param_hint.GetDiskTypeName());
+	}
 	return rc;
 }
 
@@ -109,6 +161,7 @@ int DiskParser::Check(wxString &file_format, DiskParamPtrs &disk_params, DiskPar
 	bool support = false;
 	int rc = -1;
 
+	m_cache_key.Empty();
 	if (file_format.IsEmpty()) {
 		// ファイル形式の指定がない場合
 
@@ -117,21 +170,18 @@ int DiskParser::Check(wxString &file_format, DiskParamPtrs &disk_params, DiskPar
 
 		// サポートしているファイルか
 		const FileParam *fitem = gFileTypes.FindExt(ext);
-		if (!fitem) {
-			p_result->SetError(DiskResult::ERR_UNSUPPORTED);
-			return p_result->GetValid();
-		}
 
-		// 指定形式で解析する
-		const FileParamFormats *formats = &fitem->GetFormats();
-		for(size_t i=0; i<formats->Count(); i++) {
-			const FileParamFormat *param_format = &formats->Item(i);
-			myLog.SetInfo(wxT("Parsing image: ") + param_format->GetType()); 
-			rc = SelectChecker(param_format->GetType(), &param_format->GetHints(), NULL, disk_params, manual_param, mod_flags, support);
-			if (rc >= 0) {
-				file_format = param_format->GetType();
-				break;
-			}
+		// 先頭部分は一度だけ読み込み、キャッシュのキーと全パーサーの判定に使う
+		DiskProbeData data;
+		data.Read(*p_stream);
+
+		// 同じ内容のファイルを判定したことがあればその形式でチェックする
+		m_cache_key = DiskDetectCache::MakeImageKey(data);
+		rc = CheckCached(m_cache_key, file_format, disk_params, manual_param, mod_flags, support);
+
+		if (!support) {
+			// ファイルの内容で候補を絞ってから解析する
+			rc = ProbeAndCheck(data, fitem, file_format, disk_params, manual_param, mod_flags, support);
 		}
 
 	} else {
@@ -150,6 +200,126 @@ int DiskParser::Check(wxString &file_format, DiskParamPtrs &disk_params, DiskPar
 	return rc;
 }
 
+/// ファイル先頭部分で判定して候補の形式を順にチェック
+///
+/// 先頭部分は呼び出し元で一度だけ読み込み、全パーサーの判定に使う。
+/// シグネチャが一致した形式、ヘッダから該当しそうな形式、判定できない形式の順にチェックする。
+/// 拡張子に対応しない形式はシグネチャが一致したときのみ候補にする。
+/// @param [in] data             ファイル先頭部分
+/// @param [in] fitem            拡張子に対応するファイル種類 Nullable
+/// @param [out] file_format     決定したファイルの形式名
+/// @param [out] disk_params     ディスクパラメータの候補
+/// @param [out] manual_param    候補がないときのパラメータヒント
+/// @param [in] mod_flags        オープン/追加 DiskImageFile::Add()
+/// @param [out] support         サポートしているファイルか
+/// @retval  1 候補がないので改めてディスク種類を選択してもらう
+/// @retval  0 候補あり正常
+/// @retval -1 エラー終了
+int DiskParser::ProbeAndCheck(const DiskProbeData &data, const FileParam *fitem, wxString &file_format, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags, bool &support)
+{
+	wxArrayPtrVoid entries;	// 候補の登録情報
+	wxArrayPtrVoid hints;	// 候補のヒント
+	wxArrayInt scores;		// 判定結果
+
+	// 拡張子に対応する形式
+	const FileParamFormats *formats = fitem ? &fitem->GetFormats() : NULL;
+	size_t formats_count = formats ? formats->Count() : 0;
+	for(size_t i=0; i<formats_count; i++) {
+		const FileParamFormat *param_format = &formats->Item(i);
+		const disk_parser_entry_t *entry = FindEntry(param_format->GetType());
+		if (!entry) continue;
+		entries.Add((void *)entry);
+		hints.Add((void *)&param_format->GetHints());
+		scores.Add(entry->probe(data));
+	}
+	// シグネチャが一致する形式
+	for(const disk_parser_entry_t *entry = c_disk_parser_entries; entry->type != NULL; entry++) {
+		if (entries.Index((void *)entry) != wxNOT_FOUND) continue;
+		int score = entry->probe(data);
+		if (score < DiskImageParser::PROBE_SIGNATURE) continue;
+		entries.Add((void *)entry);
+		hints.Add(NULL);
+		scores.Add(score);
+	}
+
+	int rc = -1;
+	bool checked = false;
+	for(int score = DiskImageParser::PROBE_SIGNATURE; score >= DiskImageParser::PROBE_UNKNOWN; score--) {
+		for(size_t i=0; i<entries.Count(); i++) {
+			if (scores[i] != score) continue;
+			const disk_parser_entry_t *entry = (const disk_parser_entry_t *)entries[i];
+			myLog.SetInfo(wxT("Parsing image: ") + wxString(entry->type)); 
+			rc = SelectChecker(entry->type, (const DiskTypeHints *)hints[i], NULL, disk_params, manual_param, mod_flags, support);
+			checked = true;
+			if (rc >= 0) {
+				file_format = entry->type;
+				return rc;
+			}
+		}
+	}
+	if (!checked && formats_count > 0) {
+		// どの形式にも該当しない時は、エラー内容を得るため拡張子の最初の形式でチェックする
+		const FileParamFormat *param_format = &formats->Item(0);
+		myLog.SetInfo(wxT("Parsing image: ") + param_format->GetType()); 
+		rc = SelectChecker(param_format->GetType(), &param_format->GetHints(), NULL, disk_params, manual_param, mod_flags, support);
+	}
+	return rc;
+}
+
+/// 前回の判定結果の形式でチェック
+///
+/// チェックに失敗したときは判定結果を破棄し、未チェックの状態に戻す。
+/// @param [in] cache_key        ファイル内容のキー DiskDetectCache::MakeImageKey()
+/// @param [out] file_format     決定したファイルの形式名
+/// @param [out] disk_params     ディスクパラメータの候補
+/// @param [out] manual_param    候補がないときのパラメータヒント
+/// @param [in] mod_flags        オープン/追加 DiskImageFile::Add()
+/// @param [out] support         チェックしたか
+/// @retval  1 候補がないので改めてディスク種類を選択してもらう
+/// @retval  0 候補あり正常
+/// @retval -1 判定結果なし or エラー
+int DiskParser::CheckCached(const wxString &cache_key, wxString &file_format, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags, bool &support)
+{
+	support = false;
+
+	wxString cached_format;
+	wxString disk_type_name;
+	if (!gDiskDetectCache.FindImage(cache_key, cached_format, disk_type_name)) {
+		return -1;
+	}
+	const DiskParam *disk_param = NULL;
+	if (!disk_type_name.IsEmpty()) {
+		disk_param = gDiskTemplates.Find(disk_type_name);
+	}
+
+	myLog.SetInfo(wxT("Parsing image (cached): ") + cached_format); 
+	int rc = SelectChecker(cached_format, NULL, disk_param, disk_params, manual_param, mod_flags, support);
+	if (rc < 0) {
+		// 一致しないので判定をやり直す
+		myLog.SetInfo(wxT("  Cache mismatched."));
+		gDiskDetectCache.RemoveImage(cache_key);
+		disk_params.Clear();
+		p_result->Clear();
+		support = false;
+		return rc;
+	}
+	file_format = cached_format;
+	return rc;
+}
+
+/// 形式名から登録情報をさがす
+/// @param [in] type ファイルの形式名("d88","plain"など)
+/// @return 登録情報 なければNULL
+const disk_parser_entry_t *DiskParser::FindEntry(const wxString &type)
+{
+	for(const disk_parser_entry_t *entry = c_disk_parser_entries; entry->type != NULL; entry++) {
+		if (type == entry->type) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
 /// ファイルの解析方法を選択
 /// @param [in] type             ファイルの形式名("d88","plain"など)
 /// @param [in] disk_param       ディスクパラメータ("plain"時のみ)
@@ -160,92 +330,18 @@ int DiskParser::Check(wxString &file_format, DiskParamPtrs &disk_params, DiskPar
 /// @retval -1 エラー
 int DiskParser::SelectPerser(const wxString &type, const DiskParam *disk_param, short mod_flags, bool &support)
 {
+	const disk_parser_entry_t *entry = FindEntry(type);
+	if (!entry) {
+		return -1;
+	}
 	int rc = -1;
-	if (type == wxT("d88")) {
-		// d88形式
-		DiskD88Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("cpcdsk")) {
-		// CPC DSK形式
-		DiskDskParser ps(p_file, mod_flags, p_result);
-		if (ps.Check(*p_stream) >= 0) {
-			rc = ps.Parse(*p_stream);
-		}
-		support = true;
-	} else if (type == wxT("fdi")) {
-		// FDI形式
-		DiskFDIParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream, disk_param);
-		support = true;
-	} else if (type == wxT("cqmimg")) {
-		// CopyQM IMG形式
-		DiskCQMParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream, disk_param);
-		support = true;
-	} else if (type == wxT("teletd0")) {
-		// Teledisk TD0形式
-		DiskTD0Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("difcdim")) {
-		// DIFC.X DIM形式
-		DiskDIMParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream, disk_param);
-		support = true;
-	} else if (type == wxT("v98fdd")) {
-		// Virtual98 FDD形式
-		DiskVFDParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("imd")) {
-		// IMageDisk IMD形式
-		DiskIMDParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("dskstr")) {
-		// DSKSTR 形式
-		DiskSTRParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("g64")) {
-		// Commodore VICE emu G64 形式
-		DiskG64Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("2mg")) {
-		// Apple 2MG 形式
-		Disk2MGParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream, disk_param);
-		support = true;
-	} else if (type == wxT("adc")) {
-		// Apple Disk Copy 4 形式
-		DiskADCParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream, disk_param);
-		support = true;
-	} else if (type == wxT("dmk")) {
-		// TRS-80 DMK 形式
-		DiskDmkParser ps(p_file, mod_flags, p_result);
-		if (ps.Check(*p_stream) >= 0) {
-			rc = ps.Parse(*p_stream);
-		}
-		support = true;
-	} else if (type == wxT("jv3")) {
-		// TRS-80 JV3 形式
-		DiskJV3Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("hfe")) {
-		// HxC HFE 形式
-		DiskHfeParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream);
-		support = true;
-	} else if (type == wxT("plain")) {
-		// ベタ
-		DiskPlainParser ps(p_file, mod_flags, p_result);
-		rc = ps.Parse(*p_stream, disk_param);
-		support = true;
+	DiskImageParser *ps = entry->create(p_file, mod_flags, p_result);
+	ps->SetFilePath(m_filepath.GetFullPath());
+	if ((entry->flags & DISK_PARSER_FLAG_CHECK_ON_PARSE) == 0 || ps->Check(*p_stream) >= 0) {
+		rc = ps->Parse(*p_stream, disk_param);
 	}
+	delete ps;
+	support = true;
 	return rc;
 }
 
@@ -262,91 +358,70 @@ int DiskParser::SelectPerser(const wxString &type, const DiskParam *disk_param,
 /// @retval -1 エラー終了
 int DiskParser::SelectChecker(const wxString &type, const DiskTypeHints *disk_hints, const DiskParam *disk_param, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags, bool &support)
 {
+	const disk_parser_entry_t *entry = FindEntry(type);
+	if (!entry) {
+		return -1;
+	}
 	int rc = -1;
-	if (type == wxT("d88")) {
-		// d88形式
-		DiskD88Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("cpcdsk")) {
-		// CPC DSK形式
-		DiskDskParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("fdi")) {
-		// FDI形式
-		DiskFDIParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
-		support = true;
-	} else if (type == wxT("cqmimg")) {
-		// CopyQM IMG形式
-		DiskCQMParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
-		support = true;
-	} else if (type == wxT("teletd0")) {
-		// Teledisk TD0形式
-		DiskTD0Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("difcdim")) {
-		// DIFC.X DIM形式
-		DiskDIMParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
-		support = true;
-	} else if (type == wxT("v98fdd")) {
-		// Virtual98 FDD形式
-		DiskVFDParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("imd")) {
-		// IMageDisk IMD形式
-		DiskIMDParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("dskstr")) {
-		// DSKSTR 形式
-		DiskSTRParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("g64")) {
-		// Commodore VICE emu G64 形式
-		DiskG64Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("2mg")) {
-		// Apple 2mg 形式
-		Disk2MGParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
-		support = true;
-	} else if (type == wxT("adc")) {
-		// Apple Disk Copy 4 形式
-		DiskADCParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
-		support = true;
-	} else if (type == wxT("dmk")) {
-		// TRS-80 DMK 形式
-		DiskDmkParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("jv3")) {
-		// TRS-80 JV3 形式
-		DiskJV3Parser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("hfe")) {
-		// HxC HFE 形式
-		DiskHfeParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream);
-		support = true;
-	} else if (type == wxT("plain")) {
-		// ベタ
-		DiskPlainParser ps(p_file, mod_flags, p_result);
-		rc = ps.Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
-		support = true;
+	DiskImageParser *ps = entry->create(p_file, mod_flags, p_result);
+	if (entry->flags & DISK_PARSER_FLAG_CHECK_PARAMS) {
+		rc = ps->Check(*p_stream, disk_hints, disk_param, disk_params, manual_param);
+	} else {
+		rc = ps->Check(*p_stream);
 	}
+	delete ps;
+	support = true;
 	return rc;
 }
 
+// ----------------------------------------------------------------------
+//
+//
+//
+DiskProbeData::DiskProbeData()
+{
+	memset(m_data, 0, sizeof(m_data));
+	m_size = 0;
+	m_file_size = 0;
+}
+
+/// ストリームの先頭部分を読み込む
+/// @param [in] istream 解析対象データ
+void DiskProbeData::Read(wxInputStream &istream)
+{
+	m_file_size = istream.GetLength();
+	istream.SeekI(0);
+	m_size = istream.Read(m_data, sizeof(m_data)).LastRead();
+	istream.SeekI(0);
+	if (m_file_size == wxInvalidOffset) {
+		m_file_size = (wxFileOffset)m_size;
+	}
+}
+
+/// 指定位置のデータが一致するか
+/// @param [in] pos 位置
+/// @param [in] sig 比較するデータ
+/// @param [in] len 比較するデータの長さ
+bool DiskProbeData::Match(size_t pos, const void *sig, size_t len) const
+{
+	if (pos + len > m_size) return false;
+	return (memcmp(&m_data[pos], sig, len) == 0);
+}
+
+/// 指定位置からデータをコピー 足りない部分は0で埋める
+/// @param [in]  pos 位置
+/// @param [out] buf バッファ
+/// @param [in]  len コピーする長さ
+/// @return 全てコピーできた
+bool DiskProbeData::Copy(size_t pos, void *buf, size_t len) const
+{
+	memset(buf, 0, len);
+	if (pos >= m_size) return false;
+	size_t remain = m_size - pos;
+	memcpy(buf, &m_data[pos], remain < len ? remain : len);
+	return (remain >= len);
+}
+
 // ----------------------------------------------------------------------
 //
 //
@@ -362,6 +437,14 @@ DiskImageParser::~DiskImageParser()
 {
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @return 判定できないので PROBE_UNKNOWN
+int DiskImageParser::Probe(const DiskProbeData &data)
+{
+	return PROBE_UNKNOWN;
+}
+
 /// ファイルイメージを解析
 /// @param [in] istream    解析対象データ
 /// @param [in] disk_param ディスクパラメータ
@@ -22,8 +22,61 @@ class DiskImageFile;
 class DiskResult;
 class DiskParam;
 class DiskParamPtrs;
+class FileParam;
 class FileParamFormat;
 class DiskTypeHints;
+class DiskImageParser;
+
+/// ファイル形式判定で先頭から読み込むサイズ
+#define DISK_PROBE_DATA_SIZE	4096
+
+/// @brief ファイル形式判定用のデータ
+///
+/// ファイルの先頭部分を一度だけ読み込み、各パーサーの判定で共用する
+class DiskProbeData
+{
+private:
+	wxUint8		 m_data[DISK_PROBE_DATA_SIZE];
+	size_t		 m_size;		///< 読み込んだサイズ
+	wxFileOffset m_file_size;	///< ファイルサイズ
+
+public:
+	DiskProbeData();
+
+	/// ストリームの先頭部分を読み込む
+	void	Read(wxInputStream &istream);
+	/// 読み込んだデータ
+	const wxUint8 *GetData() const { return m_data; }
+	/// 読み込んだサイズ
+	size_t	GetSize() const { return m_size; }
+	/// ファイルサイズ
+	wxFileOffset GetFileSize() const { return m_file_size; }
+	/// ファイル全体を読み込んだか
+	bool	IsWhole() const { return ((wxFileOffset)m_size >= m_file_size); }
+	/// 指定位置のデータが一致するか
+	bool	Match(size_t pos, const void *sig, size_t len) const;
+	/// 指定位置からデータをコピー 足りない部分は0で埋める
+	bool	Copy(size_t pos, void *buf, size_t len) const;
+};
+
+/// @brief ディスクパーサーの登録情報
+///
+/// 形式名ごとにパーサーの生成方法と判定方法を持つ
+typedef struct st_disk_parser_entry {
+	/// 形式名("d88","plain"など)
+	const wxChar *type;
+	/// DISK_PARSER_FLAG_XXX
+	int flags;
+	/// パーサーを生成
+	DiskImageParser *(*create)(DiskImageFile *file, short mod_flags, DiskResult *result);
+	/// ファイル先頭部分で形式を判定 DiskImageParser::en_probe_results を返す
+	int (*probe)(const DiskProbeData &data);
+} disk_parser_entry_t;
+
+/// ディスクパラメータの候補を使ってチェックする
+#define DISK_PARSER_FLAG_CHECK_PARAMS	0x01
+/// 解析の前にチェックする
+#define DISK_PARSER_FLAG_CHECK_ON_PARSE	0x02
 
 /// ディスクパーサー
 class DiskParser
@@ -34,6 +87,10 @@ private:
 	DiskImageFile	*p_file;
 	DiskResult		*p_result;
 	wxString		 m_image_type;
+	wxString		 m_cache_key;	///< 判定結果キャッシュのキー
+
+	/// 形式名から登録情報をさがす
+	static const disk_parser_entry_t *FindEntry(const wxString &type);
 
 	/// ファイルの解析方法を選択
 	int SelectPerser(const wxString &type, const DiskParam *disk_param, short mod_flags, bool &support);
@@ -41,6 +98,10 @@ private:
 	/// ファイルの解析方法を選択
 	int SelectChecker(const wxString &type, const DiskTypeHints *disk_hints, const DiskParam *disk_param, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags, bool &support);
 	int Check(wxString &file_format, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags);
+	/// ファイル先頭部分で判定して候補の形式を順にチェック
+	int ProbeAndCheck(const DiskProbeData &data, const FileParam *fitem, wxString &file_format, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags, bool &support);
+	/// 前回の判定結果の形式でチェック
+	int CheckCached(const wxString &cache_key, wxString &file_format, DiskParamPtrs &disk_params, DiskParam &manual_param, short mod_flags, bool &support);
 
 public:
 	DiskParser(const wxString &filepath, wxInputStream *stream, DiskImageFile *file, DiskResult &result);
@@ -54,6 +115,10 @@ public:
 	int Check(wxString &file_format, DiskParamPtrs &disk_params, DiskParam &manual_param);
 	/// ディスクイメージのタイプを返す
 	const wxString &GetImageType() const { return m_image_type; }
+	/// 判定結果キャッシュのキーを返す 形式を自動判定しなかった時は空
+	const wxString &GetCacheKey() const { return m_cache_key; }
+	/// 判定結果キャッシュのキーを設定 空なら解析結果を覚えない
+	void SetCacheKey(const wxString &val) { m_cache_key = val; }
 };
 
 /// ディスクパーサー
@@ -67,10 +132,24 @@ protected:
 	DiskImageParser() {}
 	DiskImageParser(const DiskImageParser &src) {}
 
+public:
+	/// ファイル形式の判定結果
+	enum en_probe_results {
+		PROBE_NO = 0,		///< 該当しない
+		PROBE_UNKNOWN,		///< 判定できない
+		PROBE_LIKELY,		///< ヘッダの内容から該当しそう
+		PROBE_SIGNATURE,	///< シグネチャが一致
+	};
+
 public:
 	DiskImageParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	virtual ~DiskImageParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
+	/// ファイルパスを設定
+	virtual void SetFilePath(const wxString &val) {}
+
 	/// チェック
 	virtual int Check(wxInputStream &istream);
 	/// チェック
@@ -91,7 +91,7 @@ wxUint32 DiskPlainParser::ParseSector(wxInputStream &istream, int disk_number, c
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, single_density);
 	track->Add(sector);
 
-	wxUint8 *buf = sector->GetSectorBuffer();
+	wxUint8 *buf = sector->GetSectorBufferForParse();
 	int siz = sector->GetSectorBufferSize();
 
 	if (!is_dummy) {
@@ -174,6 +174,8 @@ wxUint32 DiskPlainParser::ParseTrack(wxInputStream &istream, int offset_pos, wxU
 wxUint32 DiskPlainParser::ParseDisk(wxInputStream &istream, int disk_number, const DiskParam *disk_param)
 {
 	DiskImageDisk *disk = p_file->NewImageDisk(disk_number);
+	// セクタデータの領域をまとめて確保
+	disk->ReserveSectorBuffers(disk_param->CalcDiskSize());
 
 	// パラメータの計算値がディスクサイズの２倍なら
 	// 表面にのみデータをセットする
@@ -94,7 +94,7 @@ int DiskPlainWriter::SaveDisk(DiskImageDisk *disk, int side_number, wxOutputStre
 			if (!sector) continue;
 
 			// write sector body
-			wxUint8 *buffer = sector->GetSectorBuffer();
+			const wxUint8 *buffer = sector->PeekSectorBuffer();
 			size_t buffer_size = sector->GetSectorBufferSize();
 			if (buffer && buffer_size) {
 				ostream->Write((void *)buffer, buffer_size);	
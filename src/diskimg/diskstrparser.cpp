@@ -92,7 +92,7 @@ wxUint32 DiskSTRParser::ParseSector(wxInputStream &istream, int disk_number, int
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, false);
 	track->Add(sector);
 
-	wxUint8 *buffer = sector->GetSectorBuffer();
+	wxUint8 *buffer = sector->GetSectorBufferForParse();
 
 	// plain data
 	istream.Read(buffer, sector_size);
@@ -659,6 +659,28 @@ int DiskSTRParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_UNKNOWN   先頭部分だけでは判定できない
+/// @retval PROBE_NO        該当しない
+int DiskSTRParser::Probe(const DiskProbeData &data)
+{
+	// 0x1aを含む16バイトの次にシグネチャがある
+	const wxUint8 *buf = data.GetData();
+	size_t pos = 0;
+	for(; pos + 16 <= data.GetSize(); pos += 16) {
+		if (memchr(&buf[pos], 0x1a, 16) != NULL) {
+			break;
+		}
+	}
+	pos += 16;
+	if (pos + 16 > data.GetSize()) {
+		return data.IsWhole() ? PROBE_NO : PROBE_UNKNOWN;
+	}
+	return data.Match(pos, "DSKSTR ver", 10) ? PROBE_SIGNATURE : PROBE_NO;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @retval 1 選択ダイアログ表示
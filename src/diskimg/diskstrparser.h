@@ -82,6 +82,8 @@ public:
 	DiskSTRParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskSTRParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// チェック
 	int Check(wxInputStream &istream);
 	/// 解析
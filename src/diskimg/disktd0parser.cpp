@@ -193,7 +193,7 @@ wxUint32 DiskTD0Parser::ParseSector(wxInputStream &istream, int disk_number, int
 		sector->SetDeletedMark(true);
 	}
 
-	wxUint8 *buffer = sector->GetSectorBuffer();
+	wxUint8 *buffer = sector->GetSectorBufferForParse();
 	int buflen = sector->GetSectorBufferSize();
 
 	DecodeData(istream, disk_number, buffer, buflen);
@@ -320,6 +320,23 @@ int DiskTD0Parser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskTD0Parser::Probe(const DiskProbeData &data)
+{
+	td0_image_header_t header;
+	if (!data.Copy(0, &header, sizeof(header))) {
+		// too short
+		return PROBE_NO;
+	}
+	if (memcmp(header.ident, "TD", 2) != 0 || header.teledisk_version != 0x15) {
+		return PROBE_NO;
+	}
+	return PROBE_SIGNATURE;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @retval 1 選択ダイアログ表示
@@ -47,6 +47,8 @@ public:
 	DiskTD0Parser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskTD0Parser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// チェック
 	int Check(wxInputStream &istream);
 	/// 解析
@@ -0,0 +1,264 @@
+﻿/// @file diskverify.cpp
+///
+/// @brief ディスクイメージのCRC検査
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#include "diskverify.h"
+#include <wx/intl.h>
+#include <wx/thread.h>
+#include "diskimage.h"
+
+
+/// D88のステータス IDのCRCエラー
+#define DISK_STATUS_ID_CRC_ERROR	0xa0
+/// D88のステータス データのCRCエラー
+#define DISK_STATUS_DATA_CRC_ERROR	0xb0
+
+//
+//
+//
+DiskCRCError::DiskCRCError()
+{
+	kind = CRC_DATA_MISMATCH;
+	disk_number = 0;
+	track_number = 0;
+	side_number = 0;
+	sector_number = 0;
+	recorded_crc = -1;
+	calculated_crc = -1;
+}
+
+DiskCRCError::DiskCRCError(int n_kind, int n_disk_number, int n_track_number, int n_side_number, int n_sector_number, int n_recorded_crc, int n_calculated_crc)
+{
+	kind = n_kind;
+	disk_number = n_disk_number;
+	track_number = n_track_number;
+	side_number = n_side_number;
+	sector_number = n_sector_number;
+	recorded_crc = n_recorded_crc;
+	calculated_crc = n_calculated_crc;
+}
+
+/// 1行で表した文字列を返す
+wxString DiskCRCError::ToString() const
+{
+	wxString str = wxString::Format(_("Disk %d Track %d Side %d Sector %d:"), disk_number, track_number, side_number, sector_number);
+	str += wxT(" ");
+	switch(kind) {
+	case CRC_ID_ERROR_STATUS:
+		str += _("ID CRC error is recorded.");
+		break;
+	case CRC_DATA_ERROR_STATUS:
+		str += _("Data CRC error is recorded.");
+		break;
+	default:
+		str += wxString::Format(_("CRC mismatch (in disk:%04x calculated:%04x)"), recorded_crc, calculated_crc);
+		break;
+	}
+	return str;
+}
+
+#include <wx/arrimpl.cpp>
+WX_DEFINE_OBJARRAY(DiskCRCErrors);
+
+//
+//
+//
+/// 並列検査用 トラック1つ分
+class DiskCRCVerifyEntry
+{
+public:
+	int				 disk_number;
+	DiskImageTrack	*track;
+	DiskCRCErrors	 errors;
+
+	DiskCRCVerifyEntry(int n_disk_number, DiskImageTrack *n_track) {
+		disk_number = n_disk_number;
+		track = n_track;
+	}
+};
+
+WX_DEFINE_ARRAY(DiskCRCVerifyEntry *, DiskCRCVerifyEntriesBase);
+
+/// 並列検査用 トラックのリスト
+class DiskCRCVerifyEntries : public DiskCRCVerifyEntriesBase
+{
+};
+
+/// エントリを順に取り出して検査する
+static void VerifyEntriesOnThread(DiskCRCVerifyEntries *entries, size_t *next, wxCriticalSection *lock)
+{
+	for(;;) {
+		size_t idx;
+		{
+			wxCriticalSectionLocker locker(*lock);
+			idx = (*next)++;
+		}
+		if (idx >= entries->Count()) break;
+
+		DiskCRCVerifyEntry *entry = entries->Item(idx);
+		DiskCRCVerifier::VerifyTrack(entry->disk_number, entry->track, entry->errors);
+	}
+}
+
+#if wxUSE_THREADS
+/// 並列検査用ワーカースレッド
+class DiskCRCVerifyWorker : public wxThread
+{
+private:
+	DiskCRCVerifyEntries	*p_entries;
+	size_t					*p_next;
+	wxCriticalSection		*p_lock;
+
+	ExitCode Entry() {
+		VerifyEntriesOnThread(p_entries, p_next, p_lock);
+		return 0;
+	}
+
+public:
+	DiskCRCVerifyWorker(DiskCRCVerifyEntries *entries, size_t *next, wxCriticalSection *lock)
+		: wxThread(wxTHREAD_JOINABLE)
+	{
+		p_entries = entries;
+		p_next = next;
+		p_lock = lock;
+	}
+};
+#endif
+
+/// セクタを検査する
+/// @param [in]  disk_number ディスク番号
+/// @param [in]  track       トラック
+/// @param [in]  sector      セクタ
+/// @param [out] errors      エラーがあれば追加する
+void DiskCRCVerifier::VerifySector(int disk_number, DiskImageTrack *track, DiskImageSector *sector, DiskCRCErrors &errors)
+{
+	int recorded = sector->GetRecordedCRC();
+	int calculated = -1;
+	if (recorded >= 0) {
+		calculated = sector->CalculateCRC();
+		if (calculated >= 0 && calculated != recorded) {
+			errors.Add(DiskCRCError(DiskCRCError::CRC_DATA_MISMATCH, disk_number, track->GetTrackNumber(), track->GetSideNumber(), sector->GetSectorNumber(), recorded, calculated));
+			return;
+		}
+	}
+	switch(sector->GetSectorStatus()) {
+	case DISK_STATUS_ID_CRC_ERROR:
+		errors.Add(DiskCRCError(DiskCRCError::CRC_ID_ERROR_STATUS, disk_number, track->GetTrackNumber(), track->GetSideNumber(), sector->GetSectorNumber(), recorded, calculated));
+		break;
+	case DISK_STATUS_DATA_CRC_ERROR:
+		errors.Add(DiskCRCError(DiskCRCError::CRC_DATA_ERROR_STATUS, disk_number, track->GetTrackNumber(), track->GetSideNumber(), sector->GetSectorNumber(), recorded, calculated));
+		break;
+	}
+}
+
+/// トラックを検査する
+/// @param [in]  disk_number ディスク番号
+/// @param [in]  track       トラック
+/// @param [out] errors      エラーがあれば追加する
+void DiskCRCVerifier::VerifyTrack(int disk_number, DiskImageTrack *track, DiskCRCErrors &errors)
+{
+	if (!track) return;
+	DiskImageSectors *sectors = track->GetSectors();
+	if (!sectors) return;
+	for(size_t i = 0; i < sectors->Count(); i++) {
+		DiskImageSector *sector = sectors->Item(i);
+		if (!sector) continue;
+		VerifySector(disk_number, track, sector, errors);
+	}
+}
+
+/// ディスクのトラックを検査対象に加える
+/// @param [in]     disk_number ディスク番号
+/// @param [in]     disk        ディスク
+/// @param [in,out] entries     検査対象
+void DiskCRCVerifier::AddEntries(int disk_number, DiskImageDisk *disk, DiskCRCVerifyEntries &entries)
+{
+	if (!disk) return;
+	DiskImageTracks *tracks = disk->GetTracks();
+	if (!tracks) return;
+	for(size_t track_num = 0; track_num < tracks->Count(); track_num++) {
+		entries.Add(new DiskCRCVerifyEntry(disk_number, tracks->Item(track_num)));
+	}
+}
+
+/// 検査対象を並列で検査する
+/// 結果は検査対象の順に並ぶ
+/// @param [in]  entries 検査対象 処理後に削除する
+/// @param [out] errors  エラーのあったセクタ
+/// @return エラーのあったセクタ数
+size_t DiskCRCVerifier::VerifyEntries(DiskCRCVerifyEntries &entries, DiskCRCErrors &errors)
+{
+	size_t next = 0;
+	wxCriticalSection lock;
+#if wxUSE_THREADS
+	int threads = wxThread::GetCPUCount();
+	if (threads > (int)entries.Count()) threads = (int)entries.Count();
+
+	// 自スレッドでも検査するので一つ少なく作る
+	wxArrayPtrVoid workers;
+	for(int i = 1; i < threads; i++) {
+		DiskCRCVerifyWorker *worker = new DiskCRCVerifyWorker(&entries, &next, &lock);
+		if (worker->Run() != wxTHREAD_NO_ERROR) {
+			delete worker;
+			break;
+		}
+		workers.Add(worker);
+	}
+#endif
+	VerifyEntriesOnThread(&entries, &next, &lock);
+#if wxUSE_THREADS
+	for(size_t i = 0; i < workers.Count(); i++) {
+		DiskCRCVerifyWorker *worker = (DiskCRCVerifyWorker *)workers.Item(i);
+		worker->Wait();
+		delete worker;
+	}
+#endif
+
+	// 順にまとめる
+	for(size_t idx = 0; idx < entries.Count(); idx++) {
+		DiskCRCVerifyEntry *entry = entries.Item(idx);
+		for(size_t i = 0; i < entry->errors.Count(); i++) {
+			errors.Add(entry->errors.Item(i));
+		}
+		delete entry;
+	}
+	entries.Empty();
+	return errors.Count();
+}
+
+/// ディスクの全セクタを並列で検査する
+/// @param [in]  disk   ディスク
+/// @param [out] errors エラーのあったセクタ
+/// @return エラーのあったセクタ数
+size_t DiskCRCVerifier::VerifyDisk(DiskImageDisk *disk, DiskCRCErrors &errors)
+{
+	errors.Empty();
+	if (!disk) return 0;
+
+	DiskCRCVerifyEntries entries;
+	AddEntries(disk->GetNumber(), disk, entries);
+	return VerifyEntries(entries, errors);
+}
+
+/// 全ディスクの全セクタを並列で検査する
+/// 結果はディスク、トラックの順に並ぶ
+/// @param [in]  file        ディスクイメージ
+/// @param [in]  disk_number ディスク番号 / -1なら全ディスク
+/// @param [out] errors      エラーのあったセクタ
+/// @return エラーのあったセクタ数
+size_t DiskCRCVerifier::VerifyFile(DiskImageFile *file, int disk_number, DiskCRCErrors &errors)
+{
+	errors.Empty();
+	if (!file) return 0;
+
+	// トラック単位に分ける
+	DiskCRCVerifyEntries entries;
+	for(size_t disk_num = 0; disk_num < file->Count(); disk_num++) {
+		if (disk_number >= 0 && (int)disk_num != disk_number) continue;
+		AddEntries((int)disk_num, file->GetDisk(disk_num), entries);
+	}
+	return VerifyEntries(entries, errors);
+}
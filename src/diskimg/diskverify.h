@@ -0,0 +1,84 @@
+﻿/// @file diskverify.h
+///
+/// @brief ディスクイメージのCRC検査
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#ifndef DISK_VERIFY_H
+#define DISK_VERIFY_H
+
+#include "../common.h"
+#include <wx/string.h>
+#include <wx/dynarray.h>
+
+
+class DiskImageTrack;
+class DiskImageSector;
+class DiskImageDisk;
+class DiskImageFile;
+class DiskCRCVerifyEntries;
+
+/// CRCエラーのあるセクタ
+class DiskCRCError
+{
+public:
+	/// エラーの種類
+	enum en_crc_error_kinds {
+		CRC_DATA_MISMATCH = 0,	///< 記録されたCRCと計算したCRCが異なる
+		CRC_ID_ERROR_STATUS,	///< ステータスがIDのCRCエラー
+		CRC_DATA_ERROR_STATUS,	///< ステータスがデータのCRCエラー
+	};
+
+private:
+	int		kind;			///< エラーの種類
+	int		disk_number;	///< ディスク番号
+	int		track_number;	///< トラック番号
+	int		side_number;	///< サイド番号
+	int		sector_number;	///< セクタ番号(ID R)
+	int		recorded_crc;	///< 記録されたCRC(なければ-1)
+	int		calculated_crc;	///< 計算したCRC(計算できなければ-1)
+
+public:
+	DiskCRCError();
+	DiskCRCError(int n_kind, int n_disk_number, int n_track_number, int n_side_number, int n_sector_number, int n_recorded_crc, int n_calculated_crc);
+	~DiskCRCError() {}
+
+	int		GetKind() const { return kind; }
+	int		GetDiskNumber() const { return disk_number; }
+	int		GetTrackNumber() const { return track_number; }
+	int		GetSideNumber() const { return side_number; }
+	int		GetSectorNumber() const { return sector_number; }
+	int		GetRecordedCRC() const { return recorded_crc; }
+	int		GetCalculatedCRC() const { return calculated_crc; }
+
+	/// 1行で表した文字列を返す
+	wxString	ToString() const;
+};
+
+/// @class DiskCRCErrors
+///
+/// @brief DiskCRCError のリスト
+WX_DECLARE_OBJARRAY(DiskCRCError, DiskCRCErrors);
+
+/// CRC検査
+class DiskCRCVerifier
+{
+private:
+	/// ディスクのトラックを検査対象に加える
+	static void AddEntries(int disk_number, DiskImageDisk *disk, DiskCRCVerifyEntries &entries);
+	/// 検査対象を並列で検査する
+	static size_t VerifyEntries(DiskCRCVerifyEntries &entries, DiskCRCErrors &errors);
+
+public:
+	/// セクタを検査する
+	static void VerifySector(int disk_number, DiskImageTrack *track, DiskImageSector *sector, DiskCRCErrors &errors);
+	/// トラックを検査する
+	static void VerifyTrack(int disk_number, DiskImageTrack *track, DiskCRCErrors &errors);
+	/// ディスクの全セクタを並列で検査する
+	static size_t VerifyDisk(DiskImageDisk *disk, DiskCRCErrors &errors);
+	/// 全ディスクの全セクタを並列で検査する
+	static size_t VerifyFile(DiskImageFile *file, int disk_number, DiskCRCErrors &errors);
+};
+
+#endif /* DISK_VERIFY_H */
@@ -81,7 +81,7 @@ wxUint32 DiskVFDParser::ParseSector(wxInputStream &istream, int sector_nums, voi
 	DiskImageSector *sector = track->NewImageSector(track_number, side_number, sector_number, sector_size, sector_nums, sector_header->dden == 0);
 	track->Add(sector);
 
-	wxUint8 *buf = sector->GetSectorBuffer();
+	wxUint8 *buf = sector->GetSectorBufferForParse();
 	int siz = sector->GetSectorBufferSize();
 
 	if (sector_header->start != (wxUint32)-1) {
@@ -208,6 +208,15 @@ int DiskVFDParser::Check(wxInputStream &istream, const DiskTypeHints *disk_hints
 	return -1;
 }
 
+/// ファイル先頭部分で形式を判定
+/// @param [in] data ファイル先頭部分
+/// @retval PROBE_SIGNATURE シグネチャが一致
+/// @retval PROBE_NO        該当しない
+int DiskVFDParser::Probe(const DiskProbeData &data)
+{
+	return data.Match(0, "VFD1", 4) ? PROBE_SIGNATURE : PROBE_NO;
+}
+
 /// チェック
 /// @param [in] istream       解析対象データ
 /// @retval  0 正常
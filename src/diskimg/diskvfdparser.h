@@ -41,6 +41,8 @@ public:
 	DiskVFDParser(DiskImageFile *file, short mod_flags, DiskResult *result);
 	~DiskVFDParser();
 
+	/// ファイル先頭部分で形式を判定
+	static int Probe(const DiskProbeData &data);
 	/// チェック
 	int Check(wxInputStream &istream);
 	/// 解析
@@ -79,6 +79,20 @@ DiskWriter::DiskWriter(DiskImage *image, DiskResult *result)
 	m_ownstream = false;
 }
 
+/// @param [in]  image    ディスクイメージ
+/// @param [in]  options  出力時のオプション
+/// @param [out] result   結果
+/// @note 出力先は開かない
+DiskWriter::DiskWriter(DiskImage *image, const DiskWriteOptions &options, DiskResult *result)
+	: DiskWriteOptions(options)
+{
+	p_image = image;
+	m_file_path = wxEmptyString;
+	p_result = result;
+	p_ostream = NULL;
+	m_ownstream = false;
+}
+
 DiskWriter::~DiskWriter()
 {
 	if (m_ownstream) {
@@ -249,6 +263,23 @@ int DiskWriter::SaveDisk(int disk_number, int side_number, const wxString &file_
 	return rc;
 }
 
+/// 既存のファイルの変更部分だけを書き換える
+/// @param [in]  path        ファイルパス
+/// @param [in]  file_format ファイルフォーマット
+/// @param [out] support     書き換えたらtrue
+/// @note 書き換えられないときはファイル全体を保存すること
+int DiskWriter::Overwrite(const wxString &path, const wxString &file_format, bool &support)
+{
+	int rc = 0;
+	support = false;
+	if (file_format == wxT("d88")) {
+		// d88形式
+		DiskD88Writer wr(this, p_result);
+		rc = wr.Overwrite(p_image, path, support);
+	}
+	return rc;
+}
+
 /// 拡張子で保存形式を判定＆保存できるか
 /// @param [in] file_format ファイルフォーマット
 /// @param [in] disk_number ディスク番号
@@ -61,6 +61,7 @@ private:
 public:
 	DiskWriter(DiskImage *image, const wxString &path, const DiskWriteOptions &options, DiskResult *result);
 	DiskWriter(DiskImage *image, DiskResult *result);
+	DiskWriter(DiskImage *image, const DiskWriteOptions &options, DiskResult *result);
 	~DiskWriter();
 
 	/// 出力先を開く
@@ -78,6 +79,8 @@ public:
 	int Save(const wxString &file_format);
 	/// ストリームの内容をファイルに保存
 	int SaveDisk(int disk_number, int side_number, const wxString &file_format);
+	/// 既存のファイルの変更部分だけを書き換える
+	int Overwrite(const wxString &path, const wxString &file_format, bool &support);
 };
 
 /// 形式ごとのディスクライター
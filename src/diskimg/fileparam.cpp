@@ -9,6 +9,7 @@
 #include "diskwriter.h"
 #include <wx/intl.h>
 #include <wx/xml/xml.h>
+#include "../xmldoccache.h"
 
 FileTypes gFileTypes;
 
@@ -181,7 +182,7 @@ bool FileTypes::Load(const wxString &data_path, const wxString &locale_name, wxS
 {
 	wxXmlDocument doc;
 
-	if (!doc.Load(data_path + wxT("file_types.xml"))) return false;
+	if (!gXmlDocCache.LoadDocument(doc, data_path + wxT("file_types.xml"))) return false;
 
 	// start processing the XML file
 	if (doc.GetRoot()->GetName() != "FileTypes") return false;
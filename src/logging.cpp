@@ -16,6 +16,26 @@
 
 MyLogging myLog;
 
+/// スレッドごとにメッセージを溜めるバッファ
+class MyLoggingCapture
+{
+public:
+	unsigned long	 id;		///< スレッドID
+	wxString		*buffer;	///< バッファ
+
+	MyLoggingCapture(unsigned long n_id, wxString *n_buffer) { id = n_id; buffer = n_buffer; }
+};
+
+/// 現在のスレッドIDを返す
+static unsigned long CurrentThreadId()
+{
+#if wxUSE_THREADS
+	return (unsigned long)wxThread::GetCurrentId();
+#else
+	return 0;
+#endif
+}
+
 //
 //
 //
@@ -31,6 +51,9 @@ MyLogging::MyLogging()
 MyLogging::~MyLogging()
 {
 	delete p_file;
+	for(size_t i=0; i<m_captures.Count(); i++) {
+		delete (MyLoggingCapture *)m_captures.Item(i);
+	}
 }
 bool MyLogging::Open(const wxString &file_path, const wxString &file_base_name, const wxString &file_ext)
 {
@@ -81,6 +104,56 @@ void MyLogging::Close()
 		p_file = NULL;
 	}
 }
+/// ファイルに書き込む
+/// 複数スレッドから呼ばれても行が混ざらないように排他する
+/// バッファに溜めているスレッドからはバッファに追加する
+void MyLogging::Write(const wxString &msg)
+{
+	wxCriticalSectionLocker locker(m_lock);
+	if (m_captures.Count() > 0) {
+		unsigned long id = CurrentThreadId();
+		for(size_t i=0; i<m_captures.Count(); i++) {
+			MyLoggingCapture *capture = (MyLoggingCapture *)m_captures.Item(i);
+			if (capture->id == id) {
+				capture->buffer->Append(msg);
+				return;
+			}
+		}
+	}
+	if (!p_file) return;
+	p_file->Write(msg);
+	p_file->Flush();
+}
+/// 現在のスレッドのメッセージをファイルに書かずにバッファに溜める
+/// 並列で処理した結果のメッセージを決まった順で出力するときに使う
+/// @param[in] buffer バッファ EndCapture()を呼ぶまで有効であること
+void MyLogging::BeginCapture(wxString *buffer)
+{
+	EndCapture();
+	wxCriticalSectionLocker locker(m_lock);
+	m_captures.Add(new MyLoggingCapture(CurrentThreadId(), buffer));
+}
+/// バッファに溜めるのをやめる
+void MyLogging::EndCapture()
+{
+	wxCriticalSectionLocker locker(m_lock);
+	unsigned long id = CurrentThreadId();
+	for(size_t i=0; i<m_captures.Count(); i++) {
+		MyLoggingCapture *capture = (MyLoggingCapture *)m_captures.Item(i);
+		if (capture->id == id) {
+			delete capture;
+			m_captures.RemoveAt(i);
+			break;
+		}
+	}
+}
+/// 溜めたメッセージをファイルに書き込む
+/// @param[in] buffer BeginCapture()で指定したバッファ
+void MyLogging::WriteCaptured(const wxString &buffer)
+{
+	if (buffer.IsEmpty()) return;
+	Write(buffer);
+}
 int MyLogging::FindFile(const wxString &file_path, const wxString &file_base_name, const wxString &file_ext)
 {
 	wxRegEx re(file_base_name + wxT("([0-9])"));
@@ -128,8 +201,7 @@ void MyLogging::SetMessage(int level, const wxString &msg)
 	mmsg += msg;
 	mmsg += wxT("\n");
 
-	p_file->Write(mmsg);
-	p_file->Flush();
+	Write(mmsg);
 }
 void MyLogging::SetMessage(int level, const char *format, ...)
 {
@@ -154,8 +226,7 @@ void MyLogging::SetMessageV(int level, const char *format, va_list ap)
 	mmsg += wxString::FormatV(format, ap);
 	mmsg += wxT("\n");
 
-	p_file->Write(mmsg);
-	p_file->Flush();
+	Write(mmsg);
 }
 void MyLogging::SetMessage(int level, const wchar_t *format, ...)
 {
@@ -180,8 +251,7 @@ void MyLogging::SetMessageV(int level, const wchar_t *format, va_list ap)
 	mmsg += wxString::FormatV(format, ap);
 	mmsg += wxT("\n");
 
-	p_file->Write(mmsg);
-	p_file->Flush();
+	Write(mmsg);
 }
 void MyLogging::SetError(const wxString &msg)
 {
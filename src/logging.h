@@ -11,6 +11,8 @@
 #include "common.h"
 #include <stdarg.h>
 #include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/dynarray.h>
 
 class wxFile;
 
@@ -21,7 +23,10 @@ private:
 	wxFile  *p_file;
 	wxString m_file_path;
 	int      m_log_level;
+	wxCriticalSection m_lock;
+	wxArrayPtrVoid m_captures;	///< スレッドごとにメッセージを溜めるバッファ
 
+	void Write(const wxString &msg);
 	int FindFile(const wxString &file_path, const wxString &file_base_name, const wxString &file_ext);
 
 public:
@@ -59,6 +64,13 @@ public:
 	void SetDebug(const wchar_t *format, ...);
 	void SetDebugV(const wchar_t *format, va_list ap);
 
+	/// 現在のスレッドのメッセージをファイルに書かずにバッファに溜める
+	void BeginCapture(wxString *buffer);
+	/// バッファに溜めるのをやめる
+	void EndCapture();
+	/// 溜めたメッセージをファイルに書き込む
+	void WriteCaptured(const wxString &buffer);
+
 	bool GetLog(wxString &text);
 	
 	void SetLogLevel(int val) { m_log_level = val; }
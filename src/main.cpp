@@ -21,6 +21,9 @@
 #include "diskimg/fileparam.h"
 #include "basicfmt/basictemplate.h"
 #include "diskimg/diskimage.h"
+#include "diskimg/diskverify.h"
+#include "diskimg/diskdetectcache.h"
+#include "xmldoccache.h"
 #include "logging.h"
 #include "version.h"
 // icon
@@ -51,6 +54,8 @@ wxEND_EVENT_TABLE()
 UiDiskApp::UiDiskApp()
 {
 	frame = NULL;
+	verify_crc = false;
+	batch_rc = 0;
 #ifdef CAPTURE_MOD_KEY_ON_APP
 	mod_keys = 0;
 	mod_cnt = 0;
@@ -72,6 +77,10 @@ bool UiDiskApp::OnInit()
 
 	// load ini file
 	gConfig.Load(ini_path + GetAppName() + _T(".ini"));
+	// load detection cache
+	gDiskDetectCache.Load(ini_path + GetAppName() + _T(".cache"));
+	// load parsed xml cache
+	gXmlDocCache.Load(ini_path + GetAppName() + _T(".xmlcache"));
 
 	// set locale search path and catalog name
 
@@ -120,6 +129,14 @@ bool UiDiskApp::OnInit()
 		wxMessageBox(_("Cannot load file types data file."), _("Error"), wxOK);
 		return false;
 	}
+	// save parsed xml cache
+	gXmlDocCache.Save();
+
+	if (verify_crc) {
+		// ウィンドウを開かずにCRC検査のみ行う
+		batch_rc = VerifyCRCOfFiles();
+		return true;
+	}
 
 	int w = gConfig.GetWindowWidth();
 	int h = gConfig.GetWindowHeight();
@@ -135,6 +152,7 @@ bool UiDiskApp::OnInit()
 }
 
 #define OPTION_VERBOSE "verbose"
+#define OPTION_VERIFY_CRC "verify-crc"
 
 /// コマンドラインの解析
 void UiDiskApp::OnInitCmdLine(wxCmdLineParser &parser)
@@ -156,11 +174,17 @@ void UiDiskApp::OnInitCmdLine(wxCmdLineParser &parser)
 			0x0
 		},
 #endif // wxUSE_LOG
+		{
+			wxCMD_LINE_SWITCH, NULL, OPTION_VERIFY_CRC,
+			"verify CRC of all sectors in input files and exit",
+			wxCMD_LINE_VAL_NONE,
+			0x0
+		},
 	    {
 			wxCMD_LINE_PARAM, NULL, NULL,
 			"input file",
 			wxCMD_LINE_VAL_STRING,
-			wxCMD_LINE_PARAM_OPTIONAL
+			wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE
 		},
 
 		// terminator
@@ -181,14 +205,73 @@ bool UiDiskApp::OnCmdLineParsed(wxCmdLineParser &parser)
 	if (parser.GetParamCount() > 0) {
 		in_file = parser.GetParam(0);
 	}
+	if (parser.Found(OPTION_VERIFY_CRC)) {
+		verify_crc = true;
+		for(size_t i = 0; i < parser.GetParamCount(); i++) {
+			verify_files.Add(parser.GetParam(i));
+		}
+	}
 	return true;
 }
 
+/// メインループ
+int UiDiskApp::OnRun()
+{
+	if (verify_crc) {
+		return batch_rc;
+	}
+	return wxApp::OnRun();
+}
+
+/// 指定したファイルのCRCを検査して結果を出力
+/// @retval 0 エラーなし
+/// @retval 1 CRCエラーあり
+/// @retval 2 開けないファイルあり
+int UiDiskApp::VerifyCRCOfFiles()
+{
+	int rc_all = 0;
+	for(size_t n = 0; n < verify_files.Count(); n++) {
+		const wxString &path = verify_files[n];
+		DiskImage image;
+		wxString file_format;
+		DiskParamPtrs params;
+		DiskParam manual_param;
+		DiskParam param_hint;
+
+		int rc = image.Check(path, file_format, params, manual_param);
+		if (rc >= 0 && params.Count() > 0) {
+			param_hint = *params.Item(0);
+		}
+		if (rc >= 0) {
+			rc = image.Open(path, file_format, param_hint);
+		}
+		if (rc < 0) {
+			wxPrintf(wxT("%s: %s\n"), path, _("Cannot open the file."));
+			rc_all = 2;
+			continue;
+		}
+
+		DiskCRCErrors errors;
+		size_t count = image.VerifyCRC(-1, errors);
+		if (count == 0) {
+			wxPrintf(wxT("%s: OK\n"), path);
+			continue;
+		}
+		for(size_t i = 0; i < count; i++) {
+			wxPrintf(wxT("%s: %s\n"), path, errors.Item(i).ToString());
+		}
+		if (rc_all == 0) rc_all = 1;
+	}
+	return rc_all;
+}
+
 /// 終了処理
 int UiDiskApp::OnExit()
 {
 	// save ini file
 	gConfig.Save();
+	// save detection cache
+	gDiskDetectCache.Save();
 	// remove temp directories
 	RemoveTempDirs();
 
@@ -75,6 +75,10 @@ private:
 	UiDiskFrame *frame;
 	wxString in_file;
 
+	bool verify_crc;			///< CRC検査のみ行う
+	wxArrayString verify_files;	///< CRC検査するファイル
+	int batch_rc;				///< CRC検査の終了コード
+
 #ifdef CAPTURE_MOD_KEY_ON_APP
 	int		mod_keys;	///< 修飾キー押下を記憶
 	int		mod_cnt;
@@ -84,6 +88,8 @@ private:
 
 	/// アプリケーションのパスを設定
 	void	SetAppPath();
+	/// 指定したファイルのCRCを検査して結果を出力
+	int		VerifyCRCOfFiles();
 public:
 	UiDiskApp();
 	/// 初期処理
@@ -92,6 +98,8 @@ public:
 	void	OnInitCmdLine(wxCmdLineParser &parser);
 	/// コマンドラインの解析完了
 	bool	OnCmdLineParsed(wxCmdLineParser &parser);
+	/// メインループ
+	int		OnRun();
 	/// 終了処理
 	int		OnExit();
 #ifdef CAPTURE_MOD_KEY_ON_APP
@@ -105,6 +105,21 @@ const wxArrayString &ResultInfo::GetMessages(int maxrow)
 	}
 }
 
+/// 別の結果を後ろに追加
+/// 結果レベルは順に設定した場合と同じになる
+/// @param[in] src 追加する結果
+void ResultInfo::Merge(const ResultInfo &src)
+{
+	for(size_t i = 0; i < src.msgs.Count(); i++) {
+		msgs.Add(src.msgs.Item(i));
+	}
+	if (src.valid < 0) {
+		valid = -1;
+	} else if (valid == 0) {
+		valid = src.valid;
+	}
+}
+
 /// 結果ダイアログを表示
 void ResultInfo::Show()
 {
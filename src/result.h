@@ -38,6 +38,8 @@ public:
 	virtual void SetMessageV(int error_number, va_list ap) = 0;
 	virtual void GetMessages(wxArrayString &arr);
 	virtual const wxArrayString &GetMessages(int maxrow = 20);
+	/// 別の結果を後ろに追加
+	virtual void Merge(const ResultInfo &src);
 
 	/// 結果レベルをセット
 	virtual void SetValid(int val) { valid = val; }
@@ -66,6 +66,9 @@ ConfigBox::ConfigBox(wxWindow* parent, wxWindowID id, Config *ini)
 	// プロパティダイアログに内部ディレクトリ情報を表示する
 	chkInterDirItem = CreateCheckBoxH(page, IDC_CHECK_INTER_DIR_ITEM, _("Show the internal directory information on the property dialog."), ini->DoesShowInterDirItem(), szrPage, flags);
 
+	// オープン時ファイルをメモリにマッピングする
+	chkMapFile = CreateCheckBoxH(page, IDC_CHECK_MAP_FILE, _("Map the D88 disk image file to memory when open it."), ini->DoesMapFileOnOpen(), szrPage, flags);
+
 	// 一度に処理できるディレクトリの深さ
 	spnDirDepth = CreateSpinCtrlH(page, IDC_SPIN_DIR_DEPTH, _("The depth of subdirectories that can be processed per time:"), ini->GetDirDepth(), szrPage, flags);
 
@@ -275,6 +278,7 @@ void ConfigBox::CommitData()
 	ini->SetTextEditor(txtTextEditor->GetValue());
 	ini->ShowInterDirItem(chkInterDirItem->GetValue());
 	ini->CheckSideNumber(chkChkSideNum->GetValue());
+	ini->MapFileOnOpen(chkMapFile->GetValue());
 
 	int sel = comLanguage->GetSelection();
 	wxString lang;
@@ -39,6 +39,7 @@ private:
 	wxTextCtrl *txtTextEditor;
 	wxCheckBox *chkInterDirItem;
 	wxCheckBox *chkChkSideNum;
+	wxCheckBox *chkMapFile;
 	wxChoice   *comLanguage;
 
 public:
@@ -63,6 +64,7 @@ public:
 		IDC_BUTTON_TEXT_EDITOR,
 		IDC_CHECK_INTER_DIR_ITEM,
 		IDC_CHECK_CHK_SIDE_NUM,
+		IDC_CHECK_MAP_FILE,
 		IDC_COMBO_LANGUAGE,
 	};
 
@@ -199,7 +199,7 @@ void UiDiskFileListCtrl::SetListData(DiskBasic *basic, const DiskBasicDirItem *i
 	wxString filename = item->GetFileNameStr();		// ファイル名
 	wxString attr =		item->GetFileAttrStr();		// ファイル属性
 	int		 size =		item->GetFileSize();		// ファイルサイズ
-	int		 groups =	item->GetGroupSize();		// 使用グループ数
+	int		 groups =	item->GetGroupSizeForList();	// 使用グループ数
 	int		 start = 	item->GetStartGroup(0);		// 開始グループ
 	wxString date =		item->GetFileDateTimeStr();	// 日時
 	int		 staddr =	item->GetStartAddress();	// 開始アドレス
@@ -426,7 +426,7 @@ int UiDiskFileListCtrl::CompareSize(DiskBasicDirItems *items, int i1, int i2, in
 }
 int UiDiskFileListCtrl::CompareGroups(DiskBasicDirItems *items, int i1, int i2, int dir)
 {
-	return (items->Item(i1)->GetGroupSize() - items->Item(i2)->GetGroupSize()) * dir;
+	return (items->Item(i1)->GetGroupSizeForList() - items->Item(i2)->GetGroupSizeForList()) * dir;
 }
 int UiDiskFileListCtrl::CompareStart(DiskBasicDirItems *items, int i1, int i2, int dir)
 {
@@ -1159,7 +1159,7 @@ bool UiDiskFileList::SelectItem(const MyFileListItem &selected_item, int count)
 
 	if (count == 1) {
 		// ダンプリストをセット
-		frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->GetSectorBuffer(), sector->GetSectorSize(), m_current_basic->GetCharCode(), m_current_basic->IsDataInverted());
+		frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->PeekSectorBuffer(), sector->GetSectorSize(), m_current_basic->GetCharCode(), m_current_basic->IsDataInverted());
 	}
 
 	if (count <= 2) {
@@ -1210,9 +1210,9 @@ bool UiDiskFileList::SetDumpData(DiskBasicGroupItem &group_item)
 			break;
 		}
 		if (s == group_item.sector_start) {
-			frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->GetSectorBuffer(), sector->GetSectorSize());
+			frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->PeekSectorBuffer(), sector->GetSectorSize());
 		} else {
-			frame->AppendBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->GetSectorBuffer(), sector->GetSectorSize());
+			frame->AppendBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->PeekSectorBuffer(), sector->GetSectorSize());
 		}
 	}
 	return true;
@@ -1239,9 +1239,9 @@ bool UiDiskFileList::SetDumpData(int track_num, int side_num, int sector_start,
 			break;
 		}
 		if (s == sector_start) {
-			frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->GetSectorBuffer(), sector->GetSectorSize());
+			frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->PeekSectorBuffer(), sector->GetSectorSize());
 		} else {
-			frame->AppendBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->GetSectorBuffer(), sector->GetSectorSize());
+			frame->AppendBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->PeekSectorBuffer(), sector->GetSectorSize());
 		}
 	}
 	return true;
@@ -33,6 +33,7 @@
 #include "../diskimg/diskd88.h"
 #include "../diskimg/diskwriter.h"
 #include "../diskimg/diskresult.h"
+#include "../diskimg/diskverify.h"
 #include "../diskimg/fileparam.h"
 #include "../logging.h"
 #include "../version.h"
@@ -220,6 +221,7 @@ static const long TOOLBAR_STYLE = wxTB_FLAT | wxTB_DOCKABLE | wxTB_TEXT;
 wxBEGIN_EVENT_TABLE(UiDiskFrame, wxFrame)
 	// menu event
 	EVT_CLOSE(UiDiskFrame::OnClose)
+	EVT_ACTIVATE(UiDiskFrame::OnActivate)
 
 	EVT_MENU(wxID_EXIT,  UiDiskFrame::OnQuit)
 	EVT_MENU(wxID_ABOUT, UiDiskFrame::OnAbout)
@@ -239,6 +241,7 @@ wxBEGIN_EVENT_TABLE(UiDiskFrame, wxFrame)
 
 	EVT_MENU(IDM_DELETE_DISK_FROM_FILE, UiDiskFrame::OnDeleteDiskFromFile)
 	EVT_MENU(IDM_RENAME_DISK, UiDiskFrame::OnRenameDisk)
+	EVT_MENU(IDM_VERIFY_CRC, UiDiskFrame::OnVerifyCRC)
 
 	EVT_MENU_RANGE(IDM_RECENT_FILE_0, IDM_RECENT_FILE_0 + MAX_RECENT_FILES - 1, UiDiskFrame::OnOpenRecentFile)
 
@@ -340,6 +343,7 @@ UiDiskFrame::~UiDiskFrame()
 	gConfig.SetWindowHeight(sz.GetHeight());
 
 	delete p_image;
+	p_image = NULL;
 }
 
 /// フレーム部の初期処理
@@ -519,6 +523,17 @@ void UiDiskFrame::OnClose(wxCloseEvent& event)
 	event.Skip();
 }
 
+/// ウィンドウがアクティブになったとき
+void UiDiskFrame::OnActivate(wxActivateEvent& event)
+{
+	if (event.GetActive() && p_image) {
+		// 他のアプリでファイルを変えられたかもしれないので、
+		// マッピングした領域を参照する前に確認する
+		p_image->ValidateMapFile();
+	}
+	event.Skip();
+}
+
 /// メニュー 終了選択
 void UiDiskFrame::OnQuit(wxCommandEvent& WXUNUSED(event))
 {
@@ -598,6 +613,11 @@ void UiDiskFrame::OnRenameDisk(wxCommandEvent& WXUNUSED(event))
 {
 	RenameDisk();
 }
+/// メニュー CRCを検査選択
+void UiDiskFrame::OnVerifyCRC(wxCommandEvent& WXUNUSED(event))
+{
+	VerifyCRC();
+}
 /// メニュー 初期化選択
 void UiDiskFrame::OnInitializeDisk(wxCommandEvent& WXUNUSED(event))
 {
@@ -787,6 +807,8 @@ void UiDiskFrame::MakeMenu()
 	menuFile->Append( IDM_DELETE_DISK_FROM_FILE, _("&Delete Disk...") );
 	menuFile->Append( IDM_RENAME_DISK, _("&Rename Disk") );
 	menuFile->AppendSeparator();
+	menuFile->Append( IDM_VERIFY_CRC, _("&Verify CRC") );
+	menuFile->AppendSeparator();
 	menuFile->Append( IDM_INITIALIZE_DISK, _("I&nitialize...") );
 	menuFile->Append( IDM_FORMAT_DISK, _("&Format For BASIC...") );
 	menuFile->AppendSeparator();
@@ -880,6 +902,7 @@ void UiDiskFrame::UpdateMenuFile()
 
 	opened = (opened && p_image->CountDisks() > 0);
 	menuFile->Enable(IDM_SAVEAS_FILE, opened);
+	menuFile->Enable(IDM_VERIFY_CRC, opened);
 
 	UiDiskList *list = GetDiskListPanel();
 	if (list) {
@@ -1963,6 +1986,28 @@ void UiDiskFrame::RenameDisk()
 		return;
 	}
 }
+/// 全セクタのCRCを検査
+void UiDiskFrame::VerifyCRC()
+{
+	DiskCRCErrors errors;
+	wxBusyCursor wait;
+	size_t count = p_image->VerifyCRC(-1, errors);
+	wxArrayString msgs;
+	if (count == 0) {
+		msgs.Add(_("No CRC error found."));
+		ResultInfo::ShowMessage(0, msgs);
+		return;
+	}
+	const size_t maxrow = 20;
+	msgs.Add(wxString::Format(_("%d CRC error(s) found."), (int)count));
+	for(size_t i = 0; i < count && i < maxrow; i++) {
+		msgs.Add(errors.Item(i).ToString());
+	}
+	if (count > maxrow) {
+		msgs.Add(_("and more..."));
+	}
+	ResultInfo::ShowMessage(1, msgs);
+}
 /// ディスクパラメータを表示/変更
 void UiDiskFrame::ShowDiskAttr()
 {
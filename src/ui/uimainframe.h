@@ -175,6 +175,8 @@ public:
 	//@{
 	/// ウィンドウを閉じたとき
 	void OnClose(wxCloseEvent& event);
+	/// ウィンドウがアクティブになったとき
+	void OnActivate(wxActivateEvent& event);
 
 	/// メニュー 終了選択
 	void OnQuit(wxCommandEvent& event);
@@ -207,6 +209,8 @@ public:
 	void OnDeleteDiskFromFile(wxCommandEvent& event);
 	/// メニュー ディスク名を変更選択
 	void OnRenameDisk(wxCommandEvent& event);
+	/// メニュー CRCを検査選択
+	void OnVerifyCRC(wxCommandEvent& event);
 
 	/// メニュー 初期化選択
 	void OnInitializeDisk(wxCommandEvent& event);
@@ -398,6 +402,8 @@ public:
 	void DeleteDisk();
 	/// ディスク名を変更
 	void RenameDisk();
+	/// 全セクタのCRCを検査
+	void VerifyCRC();
 	/// ディスクパラメータを表示/変更
 	void ShowDiskAttr();
 	/// ディスクからデータをエクスポート
@@ -669,6 +675,7 @@ public:
 
 		IDM_DELETE_DISK_FROM_FILE,
 		IDM_RENAME_DISK,
+		IDM_VERIFY_CRC,
 
 		IDM_INITIALIZE_DISK,
 		IDM_FORMAT_DISK,
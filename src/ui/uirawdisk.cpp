@@ -1123,7 +1123,7 @@ bool UiDiskRawTrack::ExportTrackDataFile(const wxString &path, int st_trk, int s
 					DiskImageSector *sector = track->GetSector(sec);
 					if (sector) {
 						size_t bufsize = sector->GetSectorSize();
-						wxUint8 *buf = sector->GetSectorBuffer();
+						const wxUint8 *buf = sector->PeekSectorBuffer();
 
 						tbuf.SetData(buf, bufsize, inv_data);
 						if (outfile.Write(tbuf.GetData(), tbuf.GetSize()) == 0) {
@@ -2025,7 +2025,7 @@ void UiDiskRawSector::ShowPopupMenu()
 void UiDiskRawSector::SelectItem(DiskImageSector *sector)
 {
 	// ダンプリストをセット
-	frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->GetSectorBuffer(), sector->GetSectorSize());
+	frame->SetBinDumpData(sector->GetIDC(), sector->GetIDH(), sector->GetIDR(), sector->PeekSectorBuffer(), sector->GetSectorSize());
 
 	// メニューを更新
 	frame->UpdateMenuAndToolBarRawDisk(parent);
@@ -2309,7 +2309,7 @@ bool UiDiskRawSector::ExportDataFile(const wxString &path, DiskImageSector *sect
 	if (!sector) return false;
 
 	size_t bufsize = sector->GetSectorBufferSize();
-	wxUint8 *buf = sector->GetSectorBuffer();
+	const wxUint8 *buf = sector->PeekSectorBuffer();
 	if (buf == NULL || bufsize <= 0) return false;
 
 	wxFile outfile(path, wxFile::write);
@@ -2613,12 +2613,17 @@ void UiDiskRawSector::EditSector()
 	}
 
 	// ファイルを読み込む
+	// セクタへは書き換えたことが伝わるように Copy() で書く
 	wxFile infile(tmp_path.GetFullPath(), wxFile::read);
 	if (!infile.IsOpened()) return;
-	if (inverted) mem_invert(buf, bufsize);
-	infile.Read((void *)buf, bufsize);
+	wxUint8 *newbuf = new wxUint8[bufsize];
+	memcpy(newbuf, buf, bufsize);
+	if (inverted) mem_invert(newbuf, bufsize);
+	infile.Read((void *)newbuf, bufsize);
 	infile.Close();
-	if (inverted) mem_invert(buf, bufsize);
+	if (inverted) mem_invert(newbuf, bufsize);
+	sector->Copy(newbuf, (int)bufsize);
+	delete [] newbuf;
 
 //	wxRemove(tmp_path.GetFullPath());
 }
@@ -820,18 +820,108 @@ bool IsPowerOfTwo(wxUint32 val, int digit)
 	return valid;
 }
 
+//////////////////////////////////////////////////////////////////////
+
+/// CRC計算用のテーブル
+///
+/// 8バイトずつまとめて計算する(slicing-by-8)
+/// [n][x]はバイトxの後にnバイトの0が続いたときのCRC
+class CRCTables
+{
+public:
+	wxUint32 crc32[8][256];	///< CRC32 (多項式 0xedb88320 LSBから)
+	wxUint16 crc16[8][256];	///< CRC16-CCITT (多項式 0x1021 MSBから)
+
+	CRCTables();
+};
+
+CRCTables::CRCTables()
+{
+	for(int n = 0; n < 256; n++) {
+		wxUint32 r = (wxUint32)n;
+		for(int j = 0; j < 8; j++) {
+			r = (r & 1) ? ((r >> 1) ^ 0xedb88320) : (r >> 1);
+		}
+		crc32[0][n] = r;
+
+		wxUint16 c = (wxUint16)(n << 8);
+		for(int j = 0; j < 8; j++) {
+			c = (c & 0x8000) ? (wxUint16)((c << 1) ^ 0x1021) : (wxUint16)(c << 1);
+		}
+		crc16[0][n] = c;
+	}
+	for(int n = 0; n < 256; n++) {
+		for(int k = 1; k < 8; k++) {
+			wxUint32 r = crc32[k - 1][n];
+			crc32[k][n] = (r >> 8) ^ crc32[0][r & 0xff];
+
+			wxUint16 c = crc16[k - 1][n];
+			crc16[k][n] = (wxUint16)(c << 8) ^ crc16[0][c >> 8];
+		}
+	}
+}
+
+/// 起動時に作成する
+static const CRCTables cCRCTables;
+
+/// 下位から連続する0のビット数を返す
+/// @param[in] val 値
+/// @return ビット数 (valが0の時は32)
+int CountTrailingZeros(wxUint32 val)
+{
+	static const int c_debruijn[32] = {
+		 0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+		31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+	};
+	if (val == 0) return 32;
+	return c_debruijn[((val & (0 - val)) * 0x077cb531U) >> 27];
+}
+
+/// 下位から連続する0のビット数を返す(64ビット)
+/// @param[in] val 値
+/// @return ビット数 (valが0の時は64)
+int CountTrailingZeros64(wxUint64 val)
+{
+	wxUint32 lo = (wxUint32)(val & 0xffffffffU);
+	if (lo != 0) return CountTrailingZeros(lo);
+	return 32 + CountTrailingZeros((wxUint32)(val >> 32));
+}
+
+/// 1のビット数を返す(64ビット)
+/// @param[in] val 値
+/// @return ビット数
+int PopCount64(wxUint64 val)
+{
+	val = val - ((val >> 1) & 0x5555555555555555ULL);
+	val = (val & 0x3333333333333333ULL) + ((val >> 2) & 0x3333333333333333ULL);
+	val = (val + (val >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (int)((val * 0x0101010101010101ULL) >> 56);
+}
+
 /// CRC32を計算する
-wxUint32 CRC32(wxUint8 *data, int size)
+wxUint32 CRC32(const wxUint8 *data, int size)
 {
-	int i, j;
-	wxUint32 r;
+	return CRC32(data, size, 0);
+}
 
-	r = 0xffffffff;
-	for (i = 0; i < size; i++) {
-		r ^= data[i];
-		for (j = 0; j < 8; j++)
-			if (r & 1) r = (r >> 1) ^ 0xedb88320;
-			else       r >>= 1;
+/// CRC32を続けて計算する
+/// @param[in] data バッファ
+/// @param[in] size バッファサイズ
+/// @param[in] crc  直前までのCRC32 (最初は0)
+wxUint32 CRC32(const wxUint8 *data, int size, wxUint32 crc)
+{
+	const wxUint32 (*t)[256] = cCRCTables.crc32;
+	wxUint32 r = crc ^ 0xffffffff;
+
+	for(; size >= 8; size -= 8) {
+		wxUint32 lo = r ^ ((wxUint32)data[0] | ((wxUint32)data[1] << 8) | ((wxUint32)data[2] << 16) | ((wxUint32)data[3] << 24));
+		r = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+		  ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+	}
+	for(; size > 0; size--) {
+		r = (r >> 8) ^ t[0][(r ^ *data) & 0xff];
+		data++;
 	}
 	return r ^ 0xffffffff;
 }
@@ -839,14 +929,25 @@ wxUint32 CRC32(wxUint8 *data, int size)
 /// CRC16-CCITTを1バイト分計算する
 wxUint16 CRC16(wxUint8 data, wxUint16 crc)
 {
-	for (int count = 7; count >= 0; count--) {
-		wxUint16 bit = (((crc >> 15) ^ (data >> 7)) & 1);
-		crc <<= 1;
-		crc |= bit;
-		data <<= 1;
-		if (bit) {
-			crc ^= 0x1020;
-		}
+	return (wxUint16)(crc << 8) ^ cCRCTables.crc16[0][(crc >> 8) ^ data];
+}
+
+/// CRC16-CCITTをバッファ分計算する
+/// @param[in] data バッファ
+/// @param[in] size バッファサイズ
+/// @param[in] crc  初期値
+wxUint16 CRC16(const wxUint8 *data, size_t size, wxUint16 crc)
+{
+	const wxUint16 (*t)[256] = cCRCTables.crc16;
+
+	for(; size >= 8; size -= 8) {
+		crc = t[7][data[0] ^ (crc >> 8)] ^ t[6][data[1] ^ (crc & 0xff)]
+			^ t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+		data += 8;
+	}
+	for(; size > 0; size--) {
+		crc = (wxUint16)(crc << 8) ^ t[0][(crc >> 8) ^ *data];
+		data++;
 	}
 	return crc;
 }
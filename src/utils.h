@@ -182,12 +182,27 @@ bool	IsUpperString(const wxString &str);
 /// @brief 2のn乗かどうか
 bool	IsPowerOfTwo(wxUint32 val, int digit);
 
+/// @brief 下位から連続する0のビット数を返す
+int		CountTrailingZeros(wxUint32 val);
+
+/// @brief 下位から連続する0のビット数を返す(64ビット)
+int		CountTrailingZeros64(wxUint64 val);
+
+/// @brief 1のビット数を返す(64ビット)
+int		PopCount64(wxUint64 val);
+
 /// @brief CRC32を計算する
-wxUint32 CRC32(wxUint8 *data, int size);
+wxUint32 CRC32(const wxUint8 *data, int size);
+
+/// @brief CRC32を続けて計算する
+wxUint32 CRC32(const wxUint8 *data, int size, wxUint32 crc);
 
 /// @brief CRC16-CCITTを1バイト分計算する
 wxUint16 CRC16(wxUint8 data, wxUint16 crc);
 
+/// @brief CRC16-CCITTをバッファ分計算する
+wxUint16 CRC16(const wxUint8 *data, size_t size, wxUint16 crc);
+
 }; /* namespace Utils */
 
 #endif /* DISKUTILS_H */
@@ -0,0 +1,304 @@
+﻿/// @file xmldoccache.cpp
+///
+/// @brief 解析済みXMLデータのキャッシュ
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#include "xmldoccache.h"
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/datetime.h>
+#include <wx/xml/xml.h>
+
+
+/// キャッシュファイルの識別子
+#define XML_DOC_CACHE_MAGIC		"L3XMLDOC"
+/// キャッシュファイルの形式バージョン
+#define XML_DOC_CACHE_VERSION	1
+
+XmlDocCache gXmlDocCache;
+
+//
+// バイナリ読み書き (リトルエンディアン)
+//
+static void PutUint32(wxMemoryBuffer &buf, wxUint32 val)
+{
+	wxUint8 tmp[4];
+	for(int i=0; i<4; i++) {
+		tmp[i] = (wxUint8)(val >> (i * 8));
+	}
+	buf.AppendData(tmp, 4);
+}
+
+static void PutUint64(wxMemoryBuffer &buf, wxULongLong val)
+{
+	PutUint32(buf, val.GetLo());
+	PutUint32(buf, val.GetHi());
+}
+
+static void PutString(wxMemoryBuffer &buf, const wxString &str)
+{
+	wxScopedCharBuffer utf8 = str.utf8_str();
+	PutUint32(buf, (wxUint32)utf8.length());
+	buf.AppendData(utf8.data(), utf8.length());
+}
+
+static bool GetUint32(const wxUint8 *&pos, const wxUint8 *end, wxUint32 &val)
+{
+	if (end - pos < 4) return false;
+	val = 0;
+	for(int i=0; i<4; i++) {
+		val |= ((wxUint32)pos[i] << (i * 8));
+	}
+	pos += 4;
+	return true;
+}
+
+static bool GetUint64(const wxUint8 *&pos, const wxUint8 *end, wxULongLong &val)
+{
+	wxUint32 lo, hi;
+	if (!GetUint32(pos, end, lo)) return false;
+	if (!GetUint32(pos, end, hi)) return false;
+	val = wxULongLong(hi, lo);
+	return true;
+}
+
+static bool GetString(const wxUint8 *&pos, const wxUint8 *end, wxString &str)
+{
+	wxUint32 len;
+	if (!GetUint32(pos, end, len)) return false;
+	if ((wxUint32)(end - pos) < len) return false;
+	str = wxString::FromUTF8((const char *)pos, len);
+	pos += len;
+	return true;
+}
+
+//
+//
+//
+XmlDocCacheItem::XmlDocCacheItem()
+{
+	used = false;
+}
+
+//
+//
+//
+XmlDocCache::XmlDocCache()
+{
+	m_modified = false;
+}
+
+/// ファイルから読み込む
+/// @param [in] file キャッシュファイル
+void XmlDocCache::Load(const wxString &file)
+{
+	m_file = file;
+	m_items.clear();
+	m_modified = false;
+
+	if (!wxFileName::FileExists(file)) return;
+
+	wxFile fp(file);
+	if (!fp.IsOpened()) return;
+
+	// まとめて読む
+	wxFileOffset len = fp.Length();
+	if (len <= 0) return;
+	wxMemoryBuffer buf;
+	if (fp.Read(buf.GetWriteBuf((size_t)len), (size_t)len) != (ssize_t)len) return;
+	buf.UngetWriteBuf((size_t)len);
+
+	const wxUint8 *pos = (const wxUint8 *)buf.GetData();
+	const wxUint8 *end = pos + buf.GetDataLen();
+
+	size_t mlen = strlen(XML_DOC_CACHE_MAGIC);
+	if ((size_t)(end - pos) < mlen || memcmp(pos, XML_DOC_CACHE_MAGIC, mlen) != 0) return;
+	pos += mlen;
+
+	wxUint32 version, count;
+	if (!GetUint32(pos, end, version) || version != XML_DOC_CACHE_VERSION) return;
+	if (!GetUint32(pos, end, count)) return;
+
+	for(wxUint32 i = 0; i < count; i++) {
+		wxString path;
+		XmlDocCacheItem item;
+		wxULongLong mtime;
+		wxUint32 dlen;
+		if (!GetString(pos, end, path)) break;
+		if (!GetUint64(pos, end, item.size)) break;
+		if (!GetUint64(pos, end, mtime)) break;
+		if (!GetUint32(pos, end, dlen)) break;
+		if ((wxUint32)(end - pos) < dlen) break;
+		item.mtime = wxLongLong((wxInt32)mtime.GetHi(), mtime.GetLo());
+		item.data.AppendData(pos, dlen);
+		pos += dlen;
+		m_items[path] = item;
+	}
+}
+
+/// ファイルに保存する
+///
+/// 今回使用したデータだけを保存する。
+void XmlDocCache::Save()
+{
+	if (m_file.IsEmpty() || !m_modified) return;
+
+	wxMemoryBuffer buf;
+	wxUint32 count = 0;
+	XmlDocCacheItems::const_iterator it;
+	for(it = m_items.begin(); it != m_items.end(); ++it) {
+		if (it->second.used) count++;
+	}
+
+	buf.AppendData(XML_DOC_CACHE_MAGIC, strlen(XML_DOC_CACHE_MAGIC));
+	PutUint32(buf, XML_DOC_CACHE_VERSION);
+	PutUint32(buf, count);
+	for(it = m_items.begin(); it != m_items.end(); ++it) {
+		const XmlDocCacheItem &item = it->second;
+		if (!item.used) continue;
+		PutString(buf, it->first);
+		PutUint64(buf, item.size);
+		PutUint64(buf, wxULongLong((wxUint32)item.mtime.GetHi(), item.mtime.GetLo()));
+		PutUint32(buf, (wxUint32)item.data.GetDataLen());
+		buf.AppendData(item.data.GetData(), item.data.GetDataLen());
+	}
+
+	wxFile fp(m_file, wxFile::write);
+	if (!fp.IsOpened()) return;
+	fp.Write(buf.GetData(), buf.GetDataLen());
+
+	m_modified = false;
+}
+
+/// XMLドキュメントを読み込む
+///
+/// 元ファイルのサイズと更新日時がキャッシュと一致すればキャッシュから
+/// ノードツリーを作成する。一致しなければXMLを解析してキャッシュを更新する。
+/// @param [out] doc  ドキュメント
+/// @param [in]  path XMLファイル
+/// @return false:読み込めない
+bool XmlDocCache::LoadDocument(wxXmlDocument &doc, const wxString &path)
+{
+	wxFileName fn(path);
+	if (m_file.IsEmpty() || !fn.FileExists()) {
+		return doc.Load(path);
+	}
+
+	wxULongLong size = fn.GetSize();
+	wxLongLong mtime = fn.GetModificationTime().GetValue();
+
+	XmlDocCacheItems::iterator it = m_items.find(path);
+	if (it != m_items.end()) {
+		XmlDocCacheItem &item = it->second;
+		if (item.size == size && item.mtime == mtime) {
+			const wxUint8 *pos = (const wxUint8 *)item.data.GetData();
+			const wxUint8 *end = pos + item.data.GetDataLen();
+			wxXmlNode *root = ReadNode(pos, end);
+			if (root && pos == end) {
+				doc.SetRoot(root);
+				item.used = true;
+				return true;
+			}
+			// 壊れている
+			delete root;
+		}
+		m_items.erase(it);
+		m_modified = true;
+	}
+
+	if (!doc.Load(path)) return false;
+	if (!doc.GetRoot()) return true;
+
+	XmlDocCacheItem item;
+	item.size = size;
+	item.mtime = mtime;
+	item.used = true;
+	WriteNode(doc.GetRoot(), item.data);
+	m_items[path] = item;
+	m_modified = true;
+
+	return true;
+}
+
+/// ノードをバイナリにする
+/// @param [in]     node ノード
+/// @param [in,out] buf  出力先
+void XmlDocCache::WriteNode(const wxXmlNode *node, wxMemoryBuffer &buf)
+{
+	PutUint32(buf, (wxUint32)node->GetType());
+	PutString(buf, node->GetName());
+	PutString(buf, node->GetContent());
+	PutUint32(buf, (wxUint32)node->GetLineNumber());
+
+	wxUint32 count = 0;
+	const wxXmlAttribute *attr;
+	for(attr = node->GetAttributes(); attr; attr = attr->GetNext()) {
+		count++;
+	}
+	PutUint32(buf, count);
+	for(attr = node->GetAttributes(); attr; attr = attr->GetNext()) {
+		PutString(buf, attr->GetName());
+		PutString(buf, attr->GetValue());
+	}
+
+	count = 0;
+	const wxXmlNode *child;
+	for(child = node->GetChildren(); child; child = child->GetNext()) {
+		count++;
+	}
+	PutUint32(buf, count);
+	for(child = node->GetChildren(); child; child = child->GetNext()) {
+		WriteNode(child, buf);
+	}
+}
+
+/// バイナリからノードを作成する
+/// @param [in,out] pos 現在位置
+/// @param [in]     end 終端
+/// @return ノード NULLはデータ不正
+wxXmlNode *XmlDocCache::ReadNode(const wxUint8 *&pos, const wxUint8 *end)
+{
+	wxUint32 type, line, count;
+	wxString name, content;
+	if (!GetUint32(pos, end, type)) return NULL;
+	if (!GetString(pos, end, name)) return NULL;
+	if (!GetString(pos, end, content)) return NULL;
+	if (!GetUint32(pos, end, line)) return NULL;
+
+	wxXmlNode *node = new wxXmlNode(NULL, (wxXmlNodeType)type, name, content, NULL, NULL, (int)line);
+
+	if (!GetUint32(pos, end, count)) {
+		delete node;
+		return NULL;
+	}
+	for(wxUint32 i = 0; i < count; i++) {
+		wxString aname, avalue;
+		if (!GetString(pos, end, aname) || !GetString(pos, end, avalue)) {
+			delete node;
+			return NULL;
+		}
+		node->AddAttribute(aname, avalue);
+	}
+
+	if (!GetUint32(pos, end, count)) {
+		delete node;
+		return NULL;
+	}
+	// AddChild()は末尾を毎回探すので直接つなぐ
+	wxXmlNode *last = NULL;
+	for(wxUint32 i = 0; i < count; i++) {
+		wxXmlNode *child = ReadNode(pos, end);
+		if (!child) {
+			delete node;
+			return NULL;
+		}
+		child->SetParent(node);
+		if (last) last->SetNext(child);
+		else node->SetChildren(child);
+		last = child;
+	}
+
+	return node;
+}
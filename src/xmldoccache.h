@@ -0,0 +1,67 @@
+﻿/// @file xmldoccache.h
+///
+/// @brief 解析済みXMLデータのキャッシュ
+///
+/// @author Copyright (c) Sasaji. All rights reserved.
+///
+
+#ifndef XML_DOC_CACHE_H
+#define XML_DOC_CACHE_H
+
+#include "common.h"
+#include <wx/string.h>
+#include <wx/buffer.h>
+#include <wx/longlong.h>
+#include <wx/hashmap.h>
+
+
+class wxXmlDocument;
+class wxXmlNode;
+
+/// キャッシュ内の1ファイル分のデータ
+class XmlDocCacheItem
+{
+public:
+	wxULongLong		size;		///< 元ファイルのサイズ
+	wxLongLong		mtime;		///< 元ファイルの更新日時
+	wxMemoryBuffer	data;		///< ノードツリーをバイナリにしたもの
+	bool			used;		///< 今回使用したか
+
+	XmlDocCacheItem();
+};
+
+WX_DECLARE_STRING_HASH_MAP(XmlDocCacheItem, XmlDocCacheItems);
+
+/// 解析済みXMLデータのキャッシュ
+///
+/// data/*.xmlを起動のたびに解析しないように、読み込んだノードツリーを
+/// バイナリにして設定ファイルと同じ場所に保存する。
+/// 元ファイルのサイズと更新日時が一致しない時はXMLから読み直す。
+class XmlDocCache
+{
+private:
+	wxString			m_file;		///< 保存先ファイル
+	XmlDocCacheItems	m_items;	///< ファイルパスごとのデータ
+	bool				m_modified;	///< 変更したか
+
+	/// ノードをバイナリにする
+	static void WriteNode(const wxXmlNode *node, wxMemoryBuffer &buf);
+	/// バイナリからノードを作成する
+	static wxXmlNode *ReadNode(const wxUint8 *&pos, const wxUint8 *end);
+
+public:
+	XmlDocCache();
+	~XmlDocCache() {}
+
+	/// ファイルから読み込む
+	void Load(const wxString &file);
+	/// ファイルに保存する
+	void Save();
+
+	/// XMLドキュメントを読み込む キャッシュが有効ならそれを使う
+	bool LoadDocument(wxXmlDocument &doc, const wxString &path);
+};
+
+extern XmlDocCache gXmlDocCache;
+
+#endif /* XML_DOC_CACHE_H */